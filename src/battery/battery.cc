@@ -93,21 +93,21 @@ bool UpdateBatteries() {
                old_hours == battery_state.time.hours &&
                old_minutes == battery_state.time.minutes);
 
-  for (Panel& panel : panels) {
+  for (auto& panel : panels) {
     if (battery_state.percentage >= percentage_hide) {
-      if (panel.battery()->on_screen_) {
-        panel.battery()->Hide();
+      if (panel->battery()->on_screen_) {
+        panel->battery()->Hide();
         panel_refresh = true;
       }
     } else {
-      if (!panel.battery()->on_screen_) {
-        panel.battery()->Show();
+      if (!panel->battery()->on_screen_) {
+        panel->battery()->Show();
         panel_refresh = true;
       }
     }
 
-    if (panel.battery()->on_screen_ && !same_info) {
-      panel.battery()->need_resize_ = true;
+    if (panel->battery()->on_screen_ && !same_info) {
+      panel->battery()->need_resize_ = true;
       panel_refresh = true;
     }
   }
@@ -110,8 +110,8 @@ bool UpdateClockSeconds() {
   time_clock = absl::Now();
 
   if (!time1_format.empty()) {
-    for (Panel& p : panels) {
-      p.clock()->need_resize_ = true;
+    for (auto& p : panels) {
+      p->clock()->need_resize_ = true;
     }
   }
 
@@ -128,8 +128,8 @@ bool UpdateClockMinutes() {
   absl::Time::Breakdown bd = time_clock.In(::LoadTimeZone(time1_timezone));
   if (bd.second == 0 || time_clock - old_time > absl::Seconds(60)) {
     if (!time1_format.empty()) {
-      for (Panel& p : panels) {
-        p.clock()->need_resize_ = true;
+      for (auto& p : panels) {
+        p->clock()->need_resize_ = true;
       }
     }
     panel_refresh = true;
@@ -38,8 +38,12 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -48,6 +52,7 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 
 #include "clock/clock.hh"
 #include "config.hh"
@@ -57,6 +62,7 @@
 #include "taskbar/task.hh"
 #include "taskbar/taskbar.hh"
 #include "taskbar/taskbarname.hh"
+#include "taskbar/title_throttle.hh"
 #include "tooltip/tooltip.hh"
 #include "util/common.hh"
 #include "util/fs.hh"
@@ -109,6 +115,21 @@ int GetTaskStatus(std::string const& status) {
   return kTaskNormal;
 }
 
+// "task<status>_font_color", "task<status>_icon_asb" and
+// "task<status>_background_id", where <status> is usually one of "_active",
+// "_iconified" or "_urgent"
+bool IsTaskStatusKey(std::string const& key) {
+  absl::string_view rest{key};
+  if (absl::ConsumePrefix(&rest, "task")) {
+    for (char const* suffix : {"_font_color", "_icon_asb", "_background_id"}) {
+      if (absl::EndsWith(rest, suffix)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 Background& GetBackgroundFromId(size_t id) {
   try {
     return backgrounds.at(id);
@@ -122,8 +143,7 @@ Background& GetBackgroundFromId(size_t id) {
 namespace config {
 namespace {
 
-bool IdentifierMatcher(std::string const& buffer, unsigned int* position,
-                       std::string* output) {
+bool IdentifierMatcher(absl::string_view buffer, unsigned int* position) {
   unsigned int begin = (*position);
   if (!isalpha(buffer[*position])) {
     return false;
@@ -134,7 +154,6 @@ bool IdentifierMatcher(std::string const& buffer, unsigned int* position,
     ++end;
   }
   (*position) = end;
-  output->assign(buffer, begin, end - begin);
   return true;
 }
 
@@ -251,6 +270,7 @@ bool Parser::Import(parser::TokenList* tokens) {
   } else {
     util::log::Debug() << "config: import file \"" << path
                        << "\" doesn't exist, ignoring\n";
+    reader_->snapshot_.AddMissingSource(path);
   }
 
   return ConfigEntryParser(tokens);
@@ -322,7 +342,86 @@ void ExtractValues(std::string const& value, std::string* v1, std::string* v2,
   }
 }
 
-Reader::Reader(Server* server) : server_(server), new_config_file_(false) {
+namespace {
+
+// Settings that can be changed without restarting. When reloading, their
+// values are reset to the defaults, the new entries are applied, and the
+// result is copied over to the running panels.
+struct LiveSetting {
+  std::function<bool(std::string const&)> matches;
+  std::function<void()> reset;
+  // returns false if the running panels can't be updated after all
+  std::function<bool()> apply;
+};
+
+std::function<bool(std::string const&)> AnyOf(std::set<std::string> keys) {
+  return [keys](std::string const& key) { return keys.count(key) != 0; };
+}
+
+LiveSetting const* FindLiveSetting(std::string const& key) {
+  static std::vector<LiveSetting> const settings{
+      {AnyOf({"clock_lclick_command", "clock_rclick_command"}),
+       [] {
+         clock_lclick_command.clear();
+         clock_rclick_command.clear();
+       },
+       [] { return true; }},
+      {AnyOf({"launcher_item_app"}),
+       [] { panel_config.launcher_.list_apps_.clear(); },
+       LauncherReloadItems},
+      {AnyOf({"mouse_middle", "mouse_right", "mouse_scroll_up",
+              "mouse_scroll_down"}),
+       [] { new_panel_config.mouse_actions = MouseActionConfig{}; },
+       [] {
+         for (auto& panel : panels) {
+           panel->UpdateMouseActions(new_panel_config.mouse_actions);
+         }
+         return true;
+       }},
+      {AnyOf({"tooltip_show_timeout", "tooltip_hide_timeout"}),
+       [] {
+         TooltipConfig defaults;
+         tooltip_config.show_timeout_msec = defaults.show_timeout_msec;
+         tooltip_config.hide_timeout_msec = defaults.hide_timeout_msec;
+       },
+       [] { return true; }},
+      {AnyOf({"task_title_update_interval"}),
+       [] {
+         new_panel_config.title_update_interval =
+             PanelConfig{}.title_update_interval;
+       },
+       [] {
+         if (task_title_throttle != nullptr) {
+           task_title_throttle->set_interval(
+               absl::Milliseconds(new_panel_config.title_update_interval));
+         }
+         return true;
+       }},
+      // only read when drawing the tasks
+      {IsTaskStatusKey,
+       [] {
+         panel_config.g_task.config_asb_mask = 0;
+         panel_config.g_task.config_font_mask = 0;
+         panel_config.g_task.config_background_mask = 0;
+       },
+       TaskbarReloadTaskStates},
+  };
+
+  for (LiveSetting const& setting : settings) {
+    if (setting.matches(key)) {
+      return &setting;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+Reader::Reader(Server* server)
+    : server_(server),
+      new_config_file_(false),
+      apply_entries_(true),
+      load_depth_(0) {
   new_panel_config = PanelConfig{};
   tooltip_config = TooltipConfig{};
 }
@@ -376,24 +475,149 @@ bool Reader::LoadFromDefaults() {
 }
 
 bool Reader::LoadFromFile(std::string const& path) {
-  bool read = util::fs::ReadFile(path, [=](std::string const& contents) {
+  bool outermost = (load_depth_ == 0);
+  if (outermost) {
+    snapshot_.Clear();
+    if (LoadFromSnapshot(path)) {
+      return true;
+    }
+  }
+
+  bool found = false;
+  ++load_depth_;
+  bool read = util::fs::ReadFile(path, [&](std::string const& contents) {
+    found = true;
+    snapshot_.AddSource(path, contents);
     config::Parser config_entry_parser{this, path};
     parser::Parser p{config::kLexer, &config_entry_parser};
     return p.Parse(contents);
   });
+  --load_depth_;
 
+  if (!found) {
+    snapshot_.AddMissingSource(path);
+  }
   if (!read) {
     util::log::Error() << "Couldn't read the configuration file.\n";
     return false;
   }
 
+  FinishFile();
+
+  if (outermost) {
+    std::string snapshot_path = snapshot::SnapshotPath(path);
+    if (!snapshot::Write(snapshot_path, snapshot_)) {
+      util::log::Debug() << "config: couldn't save \"" << snapshot_path
+                         << "\"\n";
+    }
+  }
+  return true;
+}
+
+bool Reader::Compile(std::string const& path) {
+  apply_entries_ = false;
+  bool read = LoadFromFile(path);
+  apply_entries_ = true;
+  if (!read) {
+    return false;
+  }
+
+  std::string snapshot_path = snapshot::SnapshotPath(path);
+  if (!snapshot::Write(snapshot_path, snapshot_)) {
+    util::log::Error() << "Couldn't write \"" << snapshot_path << "\".\n";
+    return false;
+  }
+  return true;
+}
+
+Reader::ReloadResult Reader::Reload() {
+  if (snapshot_.sources.empty()) {
+    return ReloadResult::kRestartNeeded;
+  }
+  if (snapshot_.IsFresh()) {
+    util::log::Debug() << "config: no changes to reload\n";
+    return ReloadResult::kUnchanged;
+  }
+
+  std::string path = snapshot_.sources[0].path;
+  snapshot::Snapshot running = snapshot_;
+  apply_entries_ = false;
+  bool read = LoadFromFile(path);
+  apply_entries_ = true;
+  if (!read) {
+    util::log::Error() << "Keeping the current configuration.\n";
+    snapshot_ = std::move(running);
+    return ReloadResult::kUnchanged;
+  }
+
+  auto is_live = [](std::string const& key) {
+    return FindLiveSetting(key) != nullptr;
+  };
+  if (!snapshot::EqualEntries(running, snapshot_, is_live)) {
+    return ReloadResult::kRestartNeeded;
+  }
+
+  std::set<LiveSetting const*> changed;
+  for (std::string const& key : snapshot::ChangedKeys(running, snapshot_)) {
+    changed.insert(FindLiveSetting(key));
+  }
+  if (changed.empty()) {
+    util::log::Debug() << "config: no changes to reload\n";
+    return ReloadResult::kUnchanged;
+  }
+
+  for (LiveSetting const* setting : changed) {
+    setting->reset();
+    for (snapshot::Snapshot::Entry const& entry : snapshot_.entries) {
+      if (FindLiveSetting(entry.key) == setting) {
+        (this->*FindEntryHandler(entry.key))(entry.key, entry.value);
+      }
+    }
+    if (!setting->apply()) {
+      return ReloadResult::kRestartNeeded;
+    }
+  }
+  util::log::Debug() << "config: reloaded " << changed.size()
+                     << " group(s) of settings in place\n";
+  return ReloadResult::kApplied;
+}
+
+bool Reader::LoadFromSnapshot(std::string const& path) {
+  std::string snapshot_path = snapshot::SnapshotPath(path);
+  snapshot::Snapshot snapshot;
+  if (!snapshot::Read(snapshot_path, &snapshot)) {
+    // either missing, or unusable: it'll be replaced once the file is parsed
+    return false;
+  }
+  if (snapshot.sources.empty() || snapshot.sources[0].path != path ||
+      !snapshot.IsFresh()) {
+    util::log::Debug() << "config: \"" << snapshot_path << "\" is stale\n";
+    return false;
+  }
+
+  util::log::Debug() << "config: loading \"" << snapshot_path << "\"\n";
+  for (snapshot::Snapshot::Entry const& entry : snapshot.entries) {
+    if (entry.key.empty()) {
+      FinishFile();
+    } else {
+      AddEntry(entry.key, entry.value);
+    }
+  }
+  snapshot_ = std::move(snapshot);
+  return true;
+}
+
+void Reader::FinishFile() {
+  snapshot_.AddEndOfFile();
+  if (!apply_entries_) {
+    return;
+  }
+
   // append Taskbar item
   if (!new_config_file_) {
     taskbar_enabled = true;
     new_panel_config.items_order.insert(0, "T");
   }
-
-  return true;
 }
 
 namespace {
@@ -476,14 +700,95 @@ unsigned int ParseBorderSides(std::string const& value) {
 
 }  // namespace
 
+Reader::EntryHandler Reader::FindEntryHandler(std::string const& key) {
+  // Built once: new configuration keys need to be listed here, as well as
+  // handled by the matching AddEntry_* method.
+  static std::unordered_map<std::string, EntryHandler> const handlers = [] {
+    std::unordered_map<std::string, EntryHandler> handlers;
+    auto add = [&](EntryHandler handler,
+                   std::initializer_list<char const*> keys) {
+      for (char const* key : keys) {
+        handlers.emplace(key, handler);
+      }
+    };
+    add(&Reader::AddEntry_BackgroundBorder,
+        {"rounded", "border_width", "background_color",
+         "background_color_hover", "background_color_pressed", "border_sides",
+         "border_color", "border_color_hover", "border_color_pressed",
+         "gradient_id", "gradient_id_hover", "gradient_id_pressed"});
+    add(&Reader::AddEntry_Gradient,
+        {"gradient", "start_color", "end_color", "color_stop"});
+    add(&Reader::AddEntry_Panel,
+        {"panel_monitor", "panel_size", "panel_items", "panel_margin",
+         "panel_padding", "panel_position", "font_shadow",
+         "panel_background_id", "wm_menu", "panel_dock", "urgent_nb_of_blink",
+         "panel_layer"});
+    add(&Reader::AddEntry_Battery,
+        {"battery_low_status", "battery_low_cmd", "bat1_font", "bat2_font",
+         "battery_font_color", "battery_padding", "battery_background_id",
+         "battery_hide"});
+    add(&Reader::AddEntry_Clock,
+        {"time1_format", "time2_format", "time1_font", "time1_timezone",
+         "time2_timezone", "time2_font", "clock_font_color", "clock_padding",
+         "clock_background_id", "clock_tooltip", "clock_tooltip_timezone",
+         "clock_lclick_command", "clock_rclick_command"});
+    add(&Reader::AddEntry_Taskbar,
+        {"taskbar_mode", "taskbar_sort_order", "taskbar_padding",
+         "taskbar_background_id", "taskbar_active_background_id",
+         "taskbar_name", "taskbar_name_padding", "taskbar_name_background_id",
+         "taskbar_name_active_background_id", "taskbar_name_font",
+         "taskbar_name_font_color", "taskbar_name_active_font_color"});
+    add(&Reader::AddEntry_Task,
+        {"task_text", "task_icon", "task_centered", "task_width",
+         "task_maximum_size", "task_minimum_size", "task_padding", "task_font",
+         "task_tooltip", "tooltip", "task_title_update_interval"});
+    add(&Reader::AddEntry_Systray,
+        {"systray_padding", "systray_background_id", "systray_sort",
+         "systray_icon_size", "systray_icon_asb"});
+    add(&Reader::AddEntry_Launcher,
+        {"launcher_padding", "launcher_background_id", "launcher_icon_size",
+         "launcher_item_app", "launcher_icon_theme", "launcher_icon_asb",
+         "launcher_tooltip"});
+    add(&Reader::AddEntry_Tooltip,
+        {"tooltip_show_timeout", "tooltip_hide_timeout", "tooltip_padding",
+         "tooltip_background_id", "tooltip_font_color", "tooltip_font"});
+    add(&Reader::AddEntry_Executor,
+        {"execp", "execp_background_id", "execp_cache_icon", "execp_centered",
+         "execp_command", "execp_continuous", "execp_dwheel_command",
+         "execp_font", "execp_font_color", "execp_has_icon", "execp_icon_h",
+         "execp_icon_w", "execp_interval", "execp_lclick_command",
+         "execp_markup", "execp_mclick_command", "execp_rclick_command",
+         "execp_tooltip", "execp_uwheel_command"});
+    add(&Reader::AddEntry_Mouse,
+        {"mouse_middle", "mouse_right", "mouse_scroll_up", "mouse_scroll_down",
+         "mouse_effects", "mouse_hover_icon_asb", "mouse_pressed_icon_asb"});
+    add(&Reader::AddEntry_Autohide,
+        {"autohide", "autohide_show_timeout", "autohide_hide_timeout",
+         "strut_policy", "autohide_height"});
+    add(&Reader::AddEntry_Legacy,
+        {"systray", "battery", "primary_monitor_first"});
+    return handlers;
+  }();
+
+  auto it = handlers.find(key);
+  if (it != handlers.end()) {
+    return it->second;
+  }
+
+  if (IsTaskStatusKey(key)) {
+    return &Reader::AddEntry_TaskStatus;
+  }
+  return nullptr;
+}
+
 void Reader::AddEntry(std::string const& key, std::string const& value) {
-  if (AddEntry_BackgroundBorder(key, value) || AddEntry_Gradient(key, value) ||
-      AddEntry_Panel(key, value) || AddEntry_Battery(key, value) ||
-      AddEntry_Clock(key, value) || AddEntry_Taskbar(key, value) ||
-      AddEntry_Task(key, value) || AddEntry_Systray(key, value) ||
-      AddEntry_Launcher(key, value) || AddEntry_Tooltip(key, value) ||
-      AddEntry_Executor(key, value) || AddEntry_Mouse(key, value) ||
-      AddEntry_Autohide(key, value) || AddEntry_Legacy(key, value)) {
+  snapshot_.AddEntry(key, value);
+  if (!apply_entries_) {
+    return;
+  }
+
+  EntryHandler handler = FindEntryHandler(key);
+  if (handler != nullptr && (this->*handler)(key, value)) {
     return;
   }
 
@@ -995,6 +1300,20 @@ bool Reader::AddEntry_Taskbar(std::string const& key,
     }
     return true;
   }
+  if (key == "taskbar_sort_order") {
+    if (value == "desktop") {
+      new_panel_config.taskbar_sort_order = TaskbarSortOrder::kDesktop;
+    } else if (value == "title") {
+      new_panel_config.taskbar_sort_order = TaskbarSortOrder::kTitle;
+    } else if (value == "class") {
+      new_panel_config.taskbar_sort_order = TaskbarSortOrder::kClass;
+    } else if (value == "creation") {
+      new_panel_config.taskbar_sort_order = TaskbarSortOrder::kCreation;
+    } else {
+      new_panel_config.taskbar_sort_order = TaskbarSortOrder::kNone;
+    }
+    return true;
+  }
   if (key == "taskbar_padding") {
     std::string value1, value2, value3;
     config::ExtractValues(value, &value1, &value2, &value3);
@@ -1129,6 +1448,10 @@ bool Reader::AddEntry_Task(std::string const& key, std::string const& value) {
     }
     return true;
   }
+  if (key == "task_minimum_size") {
+    ParseNumber(value, &panel_config.g_task.minimum_size);
+    return true;
+  }
   if (key == "task_padding") {
     std::string value1, value2, value3;
     config::ExtractValues(value, &value1, &value2, &value3);
@@ -1155,16 +1478,34 @@ bool Reader::AddEntry_Task(std::string const& key, std::string const& value) {
         pango_font_description_from_string(value.c_str());
     return true;
   }
-  if (util::string::RegexMatch("task.*_font_color", key)) {
-    std::vector<std::string> split = absl::StrSplit(key, '_');
-    int status = GetTaskStatus(split[1]);
+  // "tooltip" is deprecated but here for backwards compatibility
+  if (key == "task_tooltip" || key == "tooltip") {
+    ParseBoolean(value, &panel_config.g_task.tooltip_enabled);
+    return true;
+  }
+  if (key == "task_title_update_interval") {
+    float interval;
+    if (!ParseNumber(value, &interval)) {
+      return true;
+    }
+    new_panel_config.title_update_interval = 1000 * interval;
+    return true;
+  }
+
+  return false;
+}
+
+bool Reader::AddEntry_TaskStatus(std::string const& key,
+                                 std::string const& value) {
+  std::vector<std::string> split = absl::StrSplit(key, '_');
+  int status = GetTaskStatus(split[1]);
+
+  if (absl::EndsWith(key, "_font_color")) {
     panel_config.g_task.font[status] = ParseColor(value, 1.0);
     panel_config.g_task.config_font_mask |= (1 << status);
     return true;
   }
-  if (util::string::RegexMatch("task.*_icon_asb", key)) {
-    std::vector<std::string> split = absl::StrSplit(key, '_');
-    int status = GetTaskStatus(split[1]);
+  if (absl::EndsWith(key, "_icon_asb")) {
     std::string value1, value2, value3;
     config::ExtractValues(value, &value1, &value2, &value3);
     if (!ParseNumber(value1, &panel_config.g_task.alpha[status])) {
@@ -1179,9 +1520,7 @@ bool Reader::AddEntry_Task(std::string const& key, std::string const& value) {
     panel_config.g_task.config_asb_mask |= (1 << status);
     return true;
   }
-  if (util::string::RegexMatch("task.*_background_id", key)) {
-    std::vector<std::string> split = absl::StrSplit(key, '_');
-    int status = GetTaskStatus(split[1]);
+  if (absl::EndsWith(key, "_background_id")) {
     int id;
     if (!ParseNumber(value, &id)) {
       return true;
@@ -1194,11 +1533,6 @@ bool Reader::AddEntry_Task(std::string const& key, std::string const& value) {
     }
     return true;
   }
-  // "tooltip" is deprecated but here for backwards compatibility
-  if (key == "task_tooltip" || key == "tooltip") {
-    ParseBoolean(value, &panel_config.g_task.tooltip_enabled);
-    return true;
-  }
 
   return false;
 }
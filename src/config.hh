@@ -3,6 +3,7 @@
 
 #include <string>
 
+#include "config_snapshot.hh"
 #include "parser/parser.hh"
 #include "server.hh"
 #include "util/fs.hh"
@@ -33,21 +34,52 @@ void ExtractValues(const std::string& value, std::string* v1, std::string* v2,
 class Parser;
 class Reader {
  public:
+  enum class ReloadResult {
+    kUnchanged,
+    kApplied,
+    kRestartNeeded,
+  };
+
   Reader(Server* server);
 
   static void GetDefaultPaths(util::fs::Path* user_config_dir,
                               util::fs::Path* config_path);
 
+  // Configuration files are loaded from their snapshot if it's up to date.
+  // Otherwise, they're parsed and the snapshot is saved for the next time.
   virtual bool LoadFromFile(std::string const& path);
   bool LoadFromDefaults();
 
+  // Parses the given configuration file and saves its snapshot, without
+  // applying any of the entries.
+  bool Compile(std::string const& path);
+
+  // Reads the configuration loaded last again. Changes limited to settings
+  // that can be updated on the fly are applied to the running panels right
+  // away, anything else needs a restart.
+  ReloadResult Reload();
+
  private:
   friend class Parser;
   friend class test::ConfigReader;
 
+  using EntryHandler = bool (Reader::*)(std::string const& key,
+                                        std::string const& value);
+
   Server* server_;
   bool new_config_file_;
-
+  bool apply_entries_;
+  // how many files are being loaded, counting imports
+  unsigned int load_depth_;
+  // what was read so far, for the outermost file being loaded
+  snapshot::Snapshot snapshot_;
+
+  // Returns the handler for the given configuration key, or nullptr if the key
+  // is unknown.
+  static EntryHandler FindEntryHandler(std::string const& key);
+
+  bool LoadFromSnapshot(std::string const& path);
+  void FinishFile();
   void AddEntry(std::string const& key, std::string const& value);
   bool AddEntry_BackgroundBorder(std::string const& key,
                                  std::string const& value);
@@ -57,6 +89,7 @@ class Reader {
   bool AddEntry_Clock(std::string const& key, std::string const& value);
   bool AddEntry_Taskbar(std::string const& key, std::string const& value);
   bool AddEntry_Task(std::string const& key, std::string const& value);
+  bool AddEntry_TaskStatus(std::string const& key, std::string const& value);
   bool AddEntry_Systray(std::string const& key, std::string const& value);
   bool AddEntry_Launcher(std::string const& key, std::string const& value);
   bool AddEntry_Tooltip(std::string const& key, std::string const& value);
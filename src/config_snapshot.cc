@@ -0,0 +1,245 @@
+#include "config_snapshot.hh"
+
+#include <cstring>
+#include <map>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+
+#include "util/fs.hh"
+#include "util/hash.hh"
+
+namespace config {
+namespace snapshot {
+
+namespace {
+
+// Snapshots are laid out as follows, in native byte order:
+//  - a Header;
+//  - source_count sources, each made of a string (the path), a uint8_t (0 if
+//    the file doesn't exist, 1 otherwise) and a uint64_t (the hash);
+//  - entry_count entries, each made of two strings (the key and the value).
+// Strings are stored as a uint32_t length, followed by as many bytes.
+const char kMagic[8] = {'t', 'i', 'n', 't', '3', 'c', 's', '\0'};
+const uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t source_count;
+  uint32_t entry_count;
+  uint32_t reserved;
+  // hash of everything following the header
+  uint64_t checksum;
+};
+
+static_assert(sizeof(Header) == 32, "unexpected padding in Header");
+
+template <typename T>
+void AppendValue(T value, std::string* output) {
+  output->append(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+void AppendString(absl::string_view value, std::string* output) {
+  AppendValue(static_cast<uint32_t>(value.length()), output);
+  output->append(value.data(), value.length());
+}
+
+// Reads values sequentially from a buffer, failing on truncated data.
+class BufferReader {
+ public:
+  explicit BufferReader(absl::string_view buffer) : buffer_(buffer) {}
+
+  template <typename T>
+  bool ReadValue(T* value) {
+    if (buffer_.length() < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(value, buffer_.data(), sizeof(T));
+    buffer_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    uint32_t length;
+    if (!ReadValue(&length) || buffer_.length() < length) {
+      return false;
+    }
+    value->assign(buffer_.data(), length);
+    buffer_.remove_prefix(length);
+    return true;
+  }
+
+  bool empty() const { return buffer_.empty(); }
+
+ private:
+  absl::string_view buffer_;
+};
+
+}  // namespace
+
+void Snapshot::AddSource(std::string const& path, absl::string_view contents) {
+  sources.push_back(Source{path, true, util::Fnv1aHash(contents)});
+}
+
+void Snapshot::AddMissingSource(std::string const& path) {
+  sources.push_back(Source{path, false, 0});
+}
+
+void Snapshot::AddEntry(std::string const& key, std::string const& value) {
+  entries.push_back(Entry{key, value});
+}
+
+void Snapshot::AddEndOfFile() { entries.push_back(Entry{}); }
+
+void Snapshot::Clear() {
+  sources.clear();
+  entries.clear();
+}
+
+bool Snapshot::IsFresh() const {
+  for (Source const& source : sources) {
+    std::string contents;
+    bool exists = util::fs::ReadFile(source.path, &contents);
+    if (exists != source.exists ||
+        (exists && util::Fnv1aHash(contents) != source.hash)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string SnapshotPath(std::string const& config_path) {
+  util::fs::Path path{config_path};
+  return path.DirectoryName() / absl::StrCat(".", path.BaseName(), ".snapshot");
+}
+
+bool EqualEntries(Snapshot const& lhs, Snapshot const& rhs,
+                  std::function<bool(std::string const&)> const& skip) {
+  auto l = lhs.entries.begin();
+  auto r = rhs.entries.begin();
+  while (true) {
+    while (l != lhs.entries.end() && skip(l->key)) {
+      ++l;
+    }
+    while (r != rhs.entries.end() && skip(r->key)) {
+      ++r;
+    }
+    if (l == lhs.entries.end() || r == rhs.entries.end()) {
+      return l == lhs.entries.end() && r == rhs.entries.end();
+    }
+    if (l->key != r->key || l->value != r->value) {
+      return false;
+    }
+    ++l;
+    ++r;
+  }
+}
+
+std::set<std::string> ChangedKeys(Snapshot const& before,
+                                  Snapshot const& after) {
+  using ValuesByKey = std::map<std::string, std::vector<std::string>>;
+  auto values_by_key = [](Snapshot const& snapshot) {
+    ValuesByKey result;
+    for (Snapshot::Entry const& entry : snapshot.entries) {
+      result[entry.key].push_back(entry.value);
+    }
+    return result;
+  };
+
+  ValuesByKey old_values = values_by_key(before);
+  ValuesByKey new_values = values_by_key(after);
+
+  std::set<std::string> changed;
+  for (auto const& pair : old_values) {
+    auto it = new_values.find(pair.first);
+    if (it == new_values.end() || it->second != pair.second) {
+      changed.insert(pair.first);
+    }
+  }
+  for (auto const& pair : new_values) {
+    if (old_values.count(pair.first) == 0) {
+      changed.insert(pair.first);
+    }
+  }
+  return changed;
+}
+
+std::string Serialize(Snapshot const& snapshot) {
+  std::string payload;
+  for (Snapshot::Source const& source : snapshot.sources) {
+    AppendString(source.path, &payload);
+    AppendValue(static_cast<uint8_t>(source.exists ? 1 : 0), &payload);
+    AppendValue(source.hash, &payload);
+  }
+  for (Snapshot::Entry const& entry : snapshot.entries) {
+    AppendString(entry.key, &payload);
+    AppendString(entry.value, &payload);
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.source_count = snapshot.sources.size();
+  header.entry_count = snapshot.entries.size();
+  header.reserved = 0;
+  header.checksum = util::Fnv1aHash(payload);
+
+  std::string result(reinterpret_cast<char const*>(&header), sizeof(header));
+  result.append(payload);
+  return result;
+}
+
+bool Deserialize(absl::string_view data, Snapshot* snapshot) {
+  snapshot->Clear();
+
+  BufferReader reader{data};
+  Header header;
+  if (!reader.ReadValue(&header) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion ||
+      util::Fnv1aHash(data.substr(sizeof(Header))) != header.checksum) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < header.source_count; ++i) {
+    Snapshot::Source source;
+    uint8_t exists;
+    if (!reader.ReadString(&source.path) || !reader.ReadValue(&exists) ||
+        !reader.ReadValue(&source.hash)) {
+      snapshot->Clear();
+      return false;
+    }
+    source.exists = (exists != 0);
+    snapshot->sources.push_back(std::move(source));
+  }
+  for (uint32_t i = 0; i < header.entry_count; ++i) {
+    Snapshot::Entry entry;
+    if (!reader.ReadString(&entry.key) || !reader.ReadString(&entry.value)) {
+      snapshot->Clear();
+      return false;
+    }
+    snapshot->entries.push_back(std::move(entry));
+  }
+
+  if (!reader.empty()) {
+    snapshot->Clear();
+    return false;
+  }
+  return true;
+}
+
+bool Read(std::string const& path, Snapshot* snapshot) {
+  util::fs::MappedFile file{path};
+  if (!file.valid()) {
+    return false;
+  }
+  return Deserialize(absl::string_view(file.data(), file.size()), snapshot);
+}
+
+bool Write(std::string const& path, Snapshot const& snapshot) {
+  return util::fs::WriteFileAtomically(path, Serialize(snapshot));
+}
+
+}  // namespace snapshot
+}  // namespace config
@@ -0,0 +1,79 @@
+#ifndef TINT3_CONFIG_SNAPSHOT_HH
+#define TINT3_CONFIG_SNAPSHOT_HH
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace config {
+namespace snapshot {
+
+// A compiled configuration: all the entries read from a configuration file
+// and the files it imports, in order, along with the hashes of the contents
+// of those files. Loading a snapshot doesn't involve any lexing or parsing,
+// and doesn't follow imports.
+//
+// Values are stored as written, so that whatever depends on the environment
+// (monitor names, paths relative to the home directory, ...) is still
+// resolved when the snapshot is loaded.
+struct Snapshot {
+  struct Source {
+    std::string path;
+    // false if the file didn't exist, in which case the hash is meaningless
+    bool exists;
+    uint64_t hash;
+  };
+
+  struct Entry {
+    std::string key;
+    std::string value;
+  };
+
+  std::vector<Source> sources;
+  // Configuration entries are never empty: an entry with an empty key marks
+  // the end of a file.
+  std::vector<Entry> entries;
+
+  void AddSource(std::string const& path, absl::string_view contents);
+  void AddMissingSource(std::string const& path);
+  void AddEntry(std::string const& key, std::string const& value);
+  void AddEndOfFile();
+  void Clear();
+
+  // Returns true if none of the source files changed since the snapshot was
+  // taken.
+  bool IsFresh() const;
+};
+
+// Returns the path of the snapshot for the given configuration file, which
+// lives next to it.
+std::string SnapshotPath(std::string const& config_path);
+
+uint64_t HashContents(absl::string_view contents);
+
+// Returns true if both snapshots hold the same entries in the same order,
+// skipping the ones whose key is accepted by the given filter.
+bool EqualEntries(Snapshot const& lhs, Snapshot const& rhs,
+                  std::function<bool(std::string const&)> const& skip);
+
+// Returns the keys with different values in the two snapshots, comparing
+// their entries in order: keys only present in one of them are included too.
+std::set<std::string> ChangedKeys(Snapshot const& before,
+                                  Snapshot const& after);
+
+std::string Serialize(Snapshot const& snapshot);
+// Returns false if the data is truncated, damaged or was written by an
+// incompatible version of tint3.
+bool Deserialize(absl::string_view data, Snapshot* snapshot);
+
+bool Read(std::string const& path, Snapshot* snapshot);
+bool Write(std::string const& path, Snapshot const& snapshot);
+
+}  // namespace snapshot
+}  // namespace config
+
+#endif  // TINT3_CONFIG_SNAPSHOT_HH
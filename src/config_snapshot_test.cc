@@ -0,0 +1,138 @@
+#include "catch.hpp"
+
+#include <set>
+#include <string>
+#include <utility>
+
+#include "config_snapshot.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+using config::snapshot::Snapshot;
+
+TEST_CASE("SnapshotPath") {
+  REQUIRE(config::snapshot::SnapshotPath("/home/user/.config/tint3/tint3rc") ==
+          "/home/user/.config/tint3/.tint3rc.snapshot");
+}
+
+TEST_CASE("Snapshot") {
+  TempDirectory temp;
+  std::string const config_path = temp / "tint3rc";
+  std::string const import_path = temp / "colors";
+  REQUIRE(util::fs::WriteFile(config_path, "panel_items = TC\n"));
+  REQUIRE(util::fs::WriteFile(import_path, "font_shadow = 1\n"));
+
+  Snapshot snapshot;
+  snapshot.AddSource(config_path, "panel_items = TC\n");
+  snapshot.AddEntry("panel_items", "TC");
+  snapshot.AddSource(import_path, "font_shadow = 1\n");
+  snapshot.AddEntry("font_shadow", "1");
+  snapshot.AddEndOfFile();
+  snapshot.AddMissingSource(temp / "missing");
+  snapshot.AddEndOfFile();
+
+  SECTION("serialization round trip") {
+    Snapshot copy;
+    REQUIRE(config::snapshot::Deserialize(
+        config::snapshot::Serialize(snapshot), &copy));
+    REQUIRE(copy.sources.size() == 3);
+    REQUIRE(copy.sources[0].path == config_path);
+    REQUIRE(copy.sources[0].hash == snapshot.sources[0].hash);
+    REQUIRE(copy.sources[2].exists == false);
+    REQUIRE(copy.entries.size() == 4);
+    REQUIRE(copy.entries[1].key == "font_shadow");
+    REQUIRE(copy.entries[1].value == "1");
+    REQUIRE(copy.entries[2].key.empty());
+  }
+
+  SECTION("damaged data is rejected") {
+    std::string data = config::snapshot::Serialize(snapshot);
+    Snapshot copy;
+    REQUIRE_FALSE(config::snapshot::Deserialize(data.substr(0, 16), &copy));
+    REQUIRE_FALSE(
+        config::snapshot::Deserialize(data.substr(0, data.size() - 1), &copy));
+    data[data.size() - 1] ^= 1;
+    REQUIRE_FALSE(config::snapshot::Deserialize(data, &copy));
+    REQUIRE(copy.entries.empty());
+  }
+
+  SECTION("read and write") {
+    std::string const snapshot_path =
+        config::snapshot::SnapshotPath(config_path);
+    Snapshot copy;
+    REQUIRE_FALSE(config::snapshot::Read(snapshot_path, &copy));
+    REQUIRE(config::snapshot::Write(snapshot_path, snapshot));
+    REQUIRE(config::snapshot::Read(snapshot_path, &copy));
+    REQUIRE(copy.entries.size() == snapshot.entries.size());
+  }
+
+  SECTION("snapshots go stale when any of the sources change") {
+    REQUIRE(snapshot.IsFresh());
+
+    SECTION("modified import") {
+      REQUIRE(util::fs::WriteFile(import_path, "font_shadow = 0\n"));
+      REQUIRE_FALSE(snapshot.IsFresh());
+    }
+
+    SECTION("removed import") {
+      REQUIRE(util::fs::Unlink(import_path));
+      REQUIRE_FALSE(snapshot.IsFresh());
+    }
+
+    SECTION("missing import that appeared") {
+      REQUIRE(util::fs::WriteFile(temp / "missing", ""));
+      REQUIRE_FALSE(snapshot.IsFresh());
+    }
+  }
+}
+
+TEST_CASE("ChangedKeys") {
+  Snapshot before;
+  before.AddEntry("rounded", "1");
+  before.AddEntry("launcher_item_app", "a.desktop");
+  before.AddEntry("launcher_item_app", "b.desktop");
+  before.AddEntry("mouse_right", "close");
+  before.AddEndOfFile();
+
+  Snapshot after = before;
+  REQUIRE(config::snapshot::ChangedKeys(before, after).empty());
+
+  after.entries[2].value = "c.desktop";
+  after.entries.erase(after.entries.begin() + 3);
+  after.AddEntry("mouse_middle", "close");
+  REQUIRE(config::snapshot::ChangedKeys(before, after) ==
+          std::set<std::string>{"launcher_item_app", "mouse_middle",
+                                "mouse_right"});
+}
+
+TEST_CASE("EqualEntries") {
+  Snapshot lhs;
+  lhs.AddEntry("rounded", "1");
+  lhs.AddEntry("background_color", "#000000 60");
+  lhs.AddEntry("rounded", "2");
+  lhs.AddEndOfFile();
+
+  auto skip_nothing = [](std::string const&) { return false; };
+  auto skip_mouse = [](std::string const& key) {
+    return key.compare(0, 6, "mouse_") == 0;
+  };
+
+  Snapshot rhs = lhs;
+  REQUIRE(config::snapshot::EqualEntries(lhs, rhs, skip_nothing));
+
+  SECTION("entries moving across others are detected") {
+    std::swap(rhs.entries[1], rhs.entries[2]);
+    REQUIRE_FALSE(config::snapshot::EqualEntries(lhs, rhs, skip_nothing));
+  }
+
+  SECTION("skipped entries are ignored") {
+    rhs.entries.insert(rhs.entries.begin() + 1, {"mouse_right", "close"});
+    REQUIRE_FALSE(config::snapshot::EqualEntries(lhs, rhs, skip_nothing));
+    REQUIRE(config::snapshot::EqualEntries(lhs, rhs, skip_mouse));
+  }
+
+  SECTION("files ending elsewhere are detected") {
+    rhs.entries.insert(rhs.entries.begin() + 2, Snapshot::Entry{});
+    REQUIRE_FALSE(config::snapshot::EqualEntries(lhs, rhs, skip_mouse));
+  }
+}
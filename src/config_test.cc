@@ -6,6 +6,7 @@
 #include <sstream>
 #include <streambuf>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_format.h"
 
@@ -167,6 +168,7 @@ strut_policy = follow_size
 
 # Taskbar
 taskbar_mode = single_desktop
+taskbar_sort_order = title
 taskbar_padding = 2 3 2
 taskbar_background_id = 0
 taskbar_active_background_id = 0
@@ -177,12 +179,14 @@ task_icon = 1
 task_text = 1
 task_centered = 1
 task_maximum_size = 140 35
+task_minimum_size = 40
 task_padding = 6 2
 task_background_id = 3
 task_active_background_id = 2
 task_urgent_background_id = 2
 task_iconified_background_id = 3
 task_tooltip = 0
+task_title_update_interval = 0.25
 
 # Task Icons
 task_icon_asb = 70 0 0
@@ -268,6 +272,9 @@ TEST_CASE("ConfigParser", "Correctly loads a valid configuration file") {
   REQUIRE(panel_config.g_task.centered == true);
   REQUIRE(error_contents.find("invalid option \"task_centered\"") ==
           std::string::npos);
+  REQUIRE(new_panel_config.title_update_interval == 250);
+  REQUIRE(new_panel_config.taskbar_sort_order == TaskbarSortOrder::kTitle);
+  REQUIRE(panel_config.g_task.minimum_size == 40);
 
   CleanupPanel();  // TODO: decouple from config loading
 }
@@ -745,3 +752,129 @@ TEST_CASE("ConfigParserExecp") {
 
   CleanupPanel();  // TODO: decouple from config loading
 }
+
+TEST_CASE("ConfigReaderReload") {
+  DefaultPanel();  // TODO: decouple from config loading
+
+  TempDirectory temp;
+  std::string const path = temp / "tint3rc";
+  REQUIRE(util::fs::WriteFile(path,
+                              "panel_items = TC\n"
+                              "mouse_scroll_down = iconify\n"));
+
+  test::MockServer server;
+  config::Reader reader{&server};
+  REQUIRE(reader.LoadFromFile(path));
+  REQUIRE(new_panel_config.mouse_actions.scroll_down == MouseAction::kIconify);
+
+  SECTION("unchanged file") {
+    REQUIRE(reader.Reload() == config::Reader::ReloadResult::kUnchanged);
+  }
+
+  SECTION("live settings are applied in place") {
+    REQUIRE(util::fs::WriteFile(path,
+                                "panel_items = TC\n"
+                                "mouse_scroll_down = shade\n"));
+    REQUIRE(reader.Reload() == config::Reader::ReloadResult::kApplied);
+    REQUIRE(new_panel_config.mouse_actions.scroll_down == MouseAction::kShade);
+
+    // the reloaded configuration is the new reference
+    REQUIRE(reader.Reload() == config::Reader::ReloadResult::kUnchanged);
+  }
+
+  SECTION("task colors and the title update interval are applied in place") {
+    REQUIRE(util::fs::WriteFile(path,
+                                "panel_items = TC\n"
+                                "mouse_scroll_down = iconify\n"
+                                "task_active_font_color = #ff0000 50\n"
+                                "task_title_update_interval = 0.5\n"));
+    REQUIRE(reader.Reload() == config::Reader::ReloadResult::kApplied);
+    REQUIRE(panel_config.g_task.font[kTaskActive] ==
+            Color{Color::Array{1.0, 0.0, 0.0}, 0.5});
+    REQUIRE(new_panel_config.title_update_interval == 500);
+
+    // removed settings go back to their defaults
+    REQUIRE(util::fs::WriteFile(path,
+                                "panel_items = TC\n"
+                                "mouse_scroll_down = iconify\n"));
+    REQUIRE(reader.Reload() == config::Reader::ReloadResult::kApplied);
+    REQUIRE(panel_config.g_task.config_font_mask == 0);
+    REQUIRE(new_panel_config.title_update_interval ==
+            PanelConfig{}.title_update_interval);
+  }
+
+  SECTION("other settings need a restart") {
+    REQUIRE(util::fs::WriteFile(path,
+                                "panel_items = TCS\n"
+                                "mouse_scroll_down = shade\n"));
+    REQUIRE(reader.Reload() == config::Reader::ReloadResult::kRestartNeeded);
+    // nothing is applied to the running panels
+    REQUIRE(new_panel_config.mouse_actions.scroll_down ==
+            MouseAction::kIconify);
+  }
+
+  SECTION("parse failures keep the running configuration") {
+    REQUIRE(util::fs::WriteFile(path,
+                                "panel_items TC\n"
+                                "mouse_scroll_down = shade\n"));
+    test::ostream_capture error_output{&std::cerr};
+    REQUIRE(reader.Reload() == config::Reader::ReloadResult::kUnchanged);
+    REQUIRE(new_panel_config.mouse_actions.scroll_down ==
+            MouseAction::kIconify);
+
+    // once fixed, the file is compared against what's running
+    REQUIRE(util::fs::WriteFile(path,
+                                "panel_items = TC\n"
+                                "mouse_scroll_down = shade\n"));
+    REQUIRE(reader.Reload() == config::Reader::ReloadResult::kApplied);
+    REQUIRE(new_panel_config.mouse_actions.scroll_down == MouseAction::kShade);
+  }
+
+  CleanupPanel();  // TODO: decouple from config loading
+}
+
+// Not run by default: use "config_test [benchmark] -d yes" to see how long it
+// takes to tokenize a large configuration file.
+TEST_CASE("Lexer benchmark", "[.][benchmark]") {
+  std::string contents;
+  for (int i = 0; i < 200; ++i) {
+    contents.append(kConfigFile).append("\n");
+  }
+
+  parser::Lexer::Result result;
+  BENCHMARK("tokenize a large tint3rc") {
+    config::kLexer.ProcessContents(contents, &result);
+  }
+  REQUIRE(result.back().symbol == parser::kEOF);
+}
+
+// Not run by default: use "config_test [benchmark] -d yes" to see how long it
+// takes to load all the sample configuration files.
+TEST_CASE("Config loading benchmark", "[.][benchmark]") {
+  std::vector<std::string> configs;
+  for (std::string const& name : util::fs::DirectoryContents{"sample"}) {
+    std::string contents;
+    if (name != "." && name != ".." &&
+        util::fs::ReadFile(util::fs::BuildPath({"sample", name}), &contents)) {
+      configs.push_back(contents);
+    }
+  }
+  REQUIRE(configs.size() > 1);
+
+  test::ostream_capture error_output{&std::cerr};
+  BENCHMARK("load every sample tint3rc") {
+    for (std::string const& contents : configs) {
+      DefaultPanel();  // TODO: decouple from config loading
+      DefaultClock();  // TODO: decouple from config loading
+
+      test::ConfigReader reader;
+      config::Parser config_entry_parser{&reader, ""};
+      parser::Parser p{config::kLexer, &config_entry_parser};
+      p.Parse(contents);
+
+      FakeClock timer{0};
+      CleanupClock(timer);  // TODO: decouple from config loading
+      CleanupPanel();       // TODO: decouple from config loading
+    }
+  }
+}
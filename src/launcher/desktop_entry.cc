@@ -6,6 +6,7 @@
 
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
 
 #include "util/common.hh"
 #include "util/log.hh"
@@ -16,8 +17,7 @@ namespace launcher {
 namespace desktop_entry {
 namespace {
 
-bool IdentifierMatcher(std::string const& buffer, unsigned int* position,
-                       std::string* output) {
+bool IdentifierMatcher(absl::string_view buffer, unsigned int* position) {
   unsigned int begin = (*position);
   if (!isalpha(buffer[*position])) {
     return false;
@@ -28,7 +28,6 @@ bool IdentifierMatcher(std::string const& buffer, unsigned int* position,
     ++end;
   }
   (*position) = end;
-  output->assign(buffer, begin, end - begin);
   return true;
 }
 
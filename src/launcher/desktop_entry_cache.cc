@@ -0,0 +1,180 @@
+#include "launcher/desktop_entry_cache.hh"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "parser/parser.hh"
+#include "util/fs.hh"
+#include "util/log.hh"
+
+launcher::desktop_entry_cache::DesktopEntryCache launcher_desktop_entry_cache;
+
+namespace launcher {
+namespace desktop_entry_cache {
+
+namespace {
+
+bool ParseDesktopFile(std::string const& contents,
+                      desktop_entry::DesktopEntry* output) {
+  desktop_entry::Parser desktop_entry_parser;
+  parser::Parser p{desktop_entry::kLexer, &desktop_entry_parser};
+  if (!p.Parse(contents)) {
+    return false;
+  }
+
+  *output = desktop_entry_parser.GetDesktopEntry();
+  return !output->empty();
+}
+
+// Returns the given directory if it exists, or its closest parent that does.
+std::string NearestExistingDirectory(std::string const& directory) {
+  util::fs::Path path{directory};
+  while (!util::fs::DirectoryExists(path)) {
+    util::fs::Path parent = path.DirectoryName();
+    if (parent == path) {
+      break;
+    }
+    path = parent;
+  }
+  return path;
+}
+
+}  // namespace
+
+DesktopEntryCache::DesktopEntryCache() = default;
+
+DesktopEntryCache::~DesktopEntryCache() = default;
+
+Entry const* DesktopEntryCache::Get(std::string const& path) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    entries_.erase(path);
+    return nullptr;
+  }
+
+  auto it = entries_.find(path);
+  if (it != entries_.end() && it->second.mtime_sec == info.st_mtim.tv_sec &&
+      it->second.mtime_nsec == info.st_mtim.tv_nsec &&
+      it->second.size == info.st_size) {
+    ++stats_.hits;
+    return it->second.valid ? &it->second.entry : nullptr;
+  }
+
+  CachedEntry cached;
+  cached.mtime_sec = info.st_mtim.tv_sec;
+  cached.mtime_nsec = info.st_mtim.tv_nsec;
+  cached.size = info.st_size;
+  cached.entry.path = path;
+  cached.entry.serial = next_serial_++;
+  cached.valid = util::fs::ReadFile(path, [&](std::string const& contents) {
+    return ParseDesktopFile(contents, &cached.entry.contents);
+  });
+  ++stats_.parses;
+
+  // failures are cached too, so that broken files aren't parsed over and over
+  CachedEntry& entry = entries_[path] = std::move(cached);
+  return entry.valid ? &entry.entry : nullptr;
+}
+
+bool DesktopEntryCache::Watch(std::vector<std::string> const& directories) {
+  if (!inotify_) {
+    inotify_.reset(new util::Inotify);
+  }
+  if (!inotify_->IsAlive()) {
+    return false;
+  }
+
+  for (auto const& directory : directories) {
+    if (!IsWanted(directory)) {
+      directories_.push_back(directory);
+    }
+  }
+  ArmWatches(nullptr);
+  return true;
+}
+
+bool DesktopEntryCache::IsWanted(std::string const& directory) const {
+  return std::find(directories_.begin(), directories_.end(), directory) !=
+         directories_.end();
+}
+
+void DesktopEntryCache::ArmWatches(std::vector<std::string>* created) {
+  std::set<std::string> parents;
+  for (auto const& directory : directories_) {
+    if (inotify_->IsWatched(directory)) {
+      continue;
+    }
+    if (util::fs::DirectoryExists(directory)) {
+      if (inotify_->Watch(directory) && created != nullptr) {
+        created->push_back(directory);
+      }
+      continue;
+    }
+    parents.insert(NearestExistingDirectory(directory));
+  }
+
+  for (auto const& parent : parents) {
+    if (!inotify_->IsWatched(parent)) {
+      inotify_->Watch(parent);
+    }
+  }
+  for (auto const& parent : parents_) {
+    if (parents.count(parent) == 0 && !IsWanted(parent)) {
+      inotify_->Unwatch(parent);
+    }
+  }
+  parents_ = std::move(parents);
+}
+
+bool DesktopEntryCache::watching() const {
+  return inotify_ && inotify_->IsAlive();
+}
+
+int DesktopEntryCache::FileDescriptor() const {
+  return watching() ? inotify_->FileDescriptor() : -1;
+}
+
+std::vector<std::string> DesktopEntryCache::ReadChanges() {
+  std::vector<std::string> changes;
+  if (!watching()) {
+    return changes;
+  }
+
+  inotify_->ReadPendingEvents(
+      [&](std::string const& directory, std::string const& name) {
+        // changes in the parents only matter to ArmWatches() below
+        if (!IsWanted(directory)) {
+          return;
+        }
+        std::string path = util::fs::BuildPath({directory, name});
+        if (entries_.erase(path) != 0) {
+          ++stats_.invalidations;
+        }
+        if (std::find(changes.begin(), changes.end(), path) == changes.end()) {
+          changes.push_back(path);
+        }
+      });
+
+  // wanted directories may have been created or removed, along with their
+  // parents
+  ArmWatches(&changes);
+  return changes;
+}
+
+void DesktopEntryCache::Clear() { entries_.clear(); }
+
+DesktopEntryCache::Stats const& DesktopEntryCache::stats() const {
+  return stats_;
+}
+
+std::ostream& operator<<(std::ostream& os,
+                         DesktopEntryCache::Stats const& stats) {
+  return os << "DesktopEntryCache::Stats{hits: " << stats.hits
+            << ", parses: " << stats.parses
+            << ", invalidations: " << stats.invalidations << "}";
+}
+
+}  // namespace desktop_entry_cache
+}  // namespace launcher
@@ -0,0 +1,103 @@
+#ifndef TINT3_LAUNCHER_DESKTOP_ENTRY_CACHE_HH
+#define TINT3_LAUNCHER_DESKTOP_ENTRY_CACHE_HH
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "launcher/desktop_entry.hh"
+#include "util/inotify.hh"
+
+namespace launcher {
+namespace desktop_entry_cache {
+
+struct Entry {
+  std::string path;
+  desktop_entry::DesktopEntry contents;
+  // changes every time the file is parsed again
+  uint64_t serial;
+};
+
+// Keeps parsed .desktop files around, so that they're only read and parsed
+// again once they change on disk.
+//
+// Entries are keyed by path and validated against the file modification time
+// and size. Optionally, the directories holding the files can be watched
+// through inotify: changes are then reported by ReadChanges(), so that users
+// can update whatever was built from the changed entries.
+class DesktopEntryCache {
+ public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t parses = 0;
+    uint64_t invalidations = 0;
+  };
+
+  DesktopEntryCache();
+  ~DesktopEntryCache();
+
+  DesktopEntryCache(DesktopEntryCache const&) = delete;
+  DesktopEntryCache& operator=(DesktopEntryCache const&) = delete;
+
+  // Returns the parsed contents of the .desktop file at the given path, or
+  // nullptr if it can't be read or parsed. The returned pointer is valid until
+  // the next call to Get(), ReadChanges() or Clear().
+  Entry const* Get(std::string const& path);
+
+  // Starts watching the given directories for changes. Directories that don't
+  // exist yet are watched once they're created, through their closest
+  // existing parent. Returns false if inotify isn't available.
+  bool Watch(std::vector<std::string> const& directories);
+  bool watching() const;
+  // Readable when there are changes pending, -1 if not watching.
+  int FileDescriptor() const;
+
+  // Forgets about the files that changed in the watched directories, and
+  // returns their paths, along with the watched directories that were just
+  // created.
+  std::vector<std::string> ReadChanges();
+
+  void Clear();
+
+  Stats const& stats() const;
+
+ private:
+  struct CachedEntry {
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    int64_t size;
+    // false if the file couldn't be parsed
+    bool valid;
+    Entry entry;
+  };
+
+  std::unordered_map<std::string, CachedEntry> entries_;
+  std::unique_ptr<util::Inotify> inotify_;
+  // what Watch() was asked for
+  std::vector<std::string> directories_;
+  // watched in place of the directories that don't exist yet
+  std::set<std::string> parents_;
+  uint64_t next_serial_ = 1;
+  Stats stats_;
+
+  bool IsWanted(std::string const& directory) const;
+  // Watches the wanted directories that exist, and the closest existing
+  // parent of the others. Newly watched wanted directories are added to
+  // created, if given.
+  void ArmWatches(std::vector<std::string>* created);
+};
+
+std::ostream& operator<<(std::ostream& os,
+                         DesktopEntryCache::Stats const& stats);
+
+}  // namespace desktop_entry_cache
+}  // namespace launcher
+
+extern launcher::desktop_entry_cache::DesktopEntryCache
+    launcher_desktop_entry_cache;
+
+#endif  // TINT3_LAUNCHER_DESKTOP_ENTRY_CACHE_HH
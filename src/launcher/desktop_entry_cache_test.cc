@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+#include "launcher/desktop_entry_cache.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+using launcher::desktop_entry_cache::DesktopEntryCache;
+using launcher::desktop_entry_cache::Entry;
+
+namespace {
+
+constexpr char kContents[] =
+    "[Desktop Entry]\n"
+    "Type=Application\n"
+    "Name=Test\n"
+    "Exec=test\n";
+
+void SetModificationTime(std::string const& path, time_t sec) {
+  struct timespec times[2] = {{sec, 0}, {sec, 0}};
+  utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+}  // namespace
+
+TEST_CASE("DesktopEntryCache") {
+  TempDirectory temp;
+  std::string const path = temp / "test.desktop";
+  REQUIRE(util::fs::WriteFile(path, kContents));
+
+  DesktopEntryCache cache;
+
+  SECTION("files are only parsed once") {
+    Entry const* entry = cache.Get(path);
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->path == path);
+    REQUIRE(entry->contents.size() == 1);
+    REQUIRE(entry->contents[0].GetName() == "Desktop Entry");
+    uint64_t serial = entry->serial;
+
+    entry = cache.Get(path);
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->serial == serial);
+    REQUIRE(cache.stats().parses == 1);
+    REQUIRE(cache.stats().hits == 1);
+  }
+
+  SECTION("modified files are parsed again") {
+    uint64_t serial = cache.Get(path)->serial;
+
+    REQUIRE(util::fs::WriteFile(path, absl::StrCat(kContents, "Icon=x\n")));
+    SetModificationTime(path, 1000);
+    Entry const* entry = cache.Get(path);
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->serial != serial);
+    REQUIRE(entry->contents[0].HasEntry("Icon"));
+    REQUIRE(cache.stats().parses == 2);
+  }
+
+  SECTION("missing and broken files") {
+    REQUIRE(cache.Get(temp / "missing.desktop") == nullptr);
+
+    std::string const broken = temp / "broken.desktop";
+    REQUIRE(util::fs::WriteFile(broken, "[Desktop Entry\n"));
+    REQUIRE(cache.Get(broken) == nullptr);
+    REQUIRE(cache.Get(broken) == nullptr);
+    REQUIRE(cache.stats().parses == 1);
+  }
+
+  SECTION("changes in watched directories are reported") {
+    REQUIRE(cache.FileDescriptor() == -1);
+    REQUIRE(cache.Watch({temp.path(), "/tmp/bogus_path"}));
+    REQUIRE(cache.watching());
+    REQUIRE(cache.FileDescriptor() != -1);
+
+    uint64_t serial = cache.Get(path)->serial;
+    REQUIRE(cache.ReadChanges().empty());
+
+    REQUIRE(util::fs::WriteFile(path, kContents));
+    REQUIRE(cache.ReadChanges() == std::vector<std::string>{path});
+    REQUIRE(cache.stats().invalidations == 1);
+    REQUIRE(cache.Get(path)->serial != serial);
+  }
+
+  SECTION("directories created later are watched") {
+    std::string const parent = temp / "share";
+    std::string const directory = parent + "/applications";
+    REQUIRE(cache.Watch({directory}));
+
+    // only the creation of the directory, or its parents, matters
+    REQUIRE(util::fs::WriteFile(temp / "unrelated", ""));
+    REQUIRE(util::fs::CreateDirectory(parent));
+    REQUIRE(cache.ReadChanges().empty());
+    REQUIRE(util::fs::WriteFile(parent + "/unrelated", ""));
+    REQUIRE(util::fs::CreateDirectory(directory));
+    REQUIRE(cache.ReadChanges() == std::vector<std::string>{directory});
+
+    std::string const created = directory + "/created.desktop";
+    REQUIRE(util::fs::WriteFile(created, kContents));
+    REQUIRE(cache.ReadChanges() == std::vector<std::string>{created});
+  }
+}
@@ -345,3 +345,26 @@ TEST_CASE("TrailingWhitespace",
   REQUIRE(groups[0].GetEntry<std::string>("Comment") ==
           "Browse the World Wide Web ");
 }
+
+// Not run by default: use "desktop_entry_test [benchmark] -d yes" to see how
+// long it takes to tokenize and parse many .desktop files.
+TEST_CASE("Lexer benchmark", "[.][benchmark]") {
+  std::string contents;
+  for (int i = 0; i < 1000; ++i) {
+    contents.append(kExampleContents);
+  }
+
+  parser::Lexer::Result result;
+  BENCHMARK("tokenize a large .desktop corpus") {
+    launcher::desktop_entry::kLexer.ProcessContents(contents, &result);
+  }
+  REQUIRE(result.back().symbol == parser::kEOF);
+
+  BENCHMARK("parse 1000 .desktop files") {
+    for (int i = 0; i < 1000; ++i) {
+      launcher::desktop_entry::Parser desktop_entry_parser;
+      parser::Parser p{launcher::desktop_entry::kLexer, &desktop_entry_parser};
+      p.Parse(kExampleContents);
+    }
+  }
+}
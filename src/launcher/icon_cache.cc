@@ -0,0 +1,373 @@
+#include "launcher/icon_cache.hh"
+
+#include <sys/stat.h>
+
+#include <cstring>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/string_view.h"
+
+#include "util/log.hh"
+#include "util/xdg.hh"
+
+namespace launcher {
+namespace icon_cache {
+
+namespace {
+
+// The cache file is laid out as follows, in native byte order, with all the
+// offsets relative to the start of the file:
+//  - a Header;
+//  - directory_count DirectoryRecords;
+//  - for each directory, file_count 32 bit offsets of its file names;
+//  - the NUL-terminated strings for the directory and file names.
+const char kMagic[8] = {'t', 'i', 'n', 't', '3', 'i', 'c', '\0'};
+const uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t directory_count;
+};
+
+struct DirectoryRecord {
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint32_t name_offset;
+  uint32_t file_count;
+  uint32_t files_offset;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(Header) == 16, "unexpected padding in Header");
+static_assert(sizeof(DirectoryRecord) == 32,
+              "unexpected padding in DirectoryRecord");
+
+// modification time recorded for directories that don't exist
+const int64_t kMissing = -1;
+
+// Flags of the images in icon-theme.cache, see gtk-update-icon-cache.
+const uint16_t kGtkHasSuffixXpm = 1 << 0;
+const uint16_t kGtkHasSuffixSvg = 1 << 1;
+const uint16_t kGtkHasSuffixPng = 1 << 2;
+const uint32_t kGtkNoOffset = 0xFFFFFFFF;
+
+void GetModificationTime(std::string const& path, int64_t* sec,
+                         int64_t* nsec) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+    *sec = *nsec = kMissing;
+    return;
+  }
+  *sec = info.st_mtim.tv_sec;
+  *nsec = info.st_mtim.tv_nsec;
+}
+
+std::vector<std::string> ReadDirectory(std::string const& path) {
+  std::vector<std::string> files;
+  for (std::string const& name : util::fs::DirectoryContents{path}) {
+    if (!name.empty() && name != "." && name != "..") {
+      files.push_back(name);
+    }
+  }
+  return files;
+}
+
+std::string CacheFileName(std::string const& theme_path) {
+  return absl::StrCat(
+      absl::StrReplaceAll(theme_path, {{"%", "%25"}, {"/", "%2F"}}), ".cache");
+}
+
+template <typename T>
+void AppendBytes(std::string* output, T const& value) {
+  output->append(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+util::fs::Path CacheDirectory() {
+  return util::xdg::basedir::CacheHome() / "tint3" / "icons";
+}
+
+ThemeCache::ThemeCache(std::string const& cache_directory,
+                       std::string const& theme_path)
+    : path_(util::fs::BuildPath(
+          {cache_directory, CacheFileName(theme_path)})),
+      theme_path_(theme_path) {
+  LoadCacheFile();
+}
+
+ThemeCache::~ThemeCache() = default;
+
+void ThemeCache::LoadCacheFile() {
+  cache_file_.reset(new util::fs::MappedFile{path_});
+  if (!cache_file_->valid()) {
+    return;
+  }
+
+  Header header;
+  if (!cache_file_->Read(0, &header) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < header.directory_count; ++i) {
+    DirectoryRecord record;
+    absl::string_view name;
+    if (!cache_file_->Read(sizeof(Header) + i * sizeof(DirectoryRecord),
+                           &record) ||
+        !cache_file_->ReadString(record.name_offset, &name)) {
+      util::log::Error() << "Ignoring corrupted icon cache \"" << path_
+                         << "\"\n";
+      cached_directories_.clear();
+      return;
+    }
+    cached_directories_[std::string(name)] = i;
+  }
+}
+
+void ThemeCache::LoadGtkCache() {
+  gtk_cache_loaded_ = true;
+
+  // same validity check as GTK: the cache must not be older than the theme;
+  // ListDirectory() also checks it against each directory it's used for
+  std::string gtk_cache_path = util::fs::BuildPath(
+      {theme_path_, "icon-theme.cache"});
+  struct stat cache_info;
+  if (stat(gtk_cache_path.c_str(), &cache_info) != 0) {
+    return;
+  }
+  int64_t theme_mtime_sec, theme_mtime_nsec;
+  GetModificationTime(theme_path_, &theme_mtime_sec, &theme_mtime_nsec);
+  gtk_cache_mtime_sec_ = cache_info.st_mtim.tv_sec;
+  gtk_cache_mtime_nsec_ = cache_info.st_mtim.tv_nsec;
+  if (!IsGtkCacheNewer(theme_mtime_sec, theme_mtime_nsec)) {
+    return;
+  }
+
+  util::fs::MappedFile file{gtk_cache_path};
+  uint16_t major_version;
+  uint32_t hash_offset, directory_list_offset, directory_count;
+  if (!file.valid() || !file.ReadBigEndian(0, &major_version) ||
+      major_version != 1 || !file.ReadBigEndian(4, &hash_offset) ||
+      !file.ReadBigEndian(8, &directory_list_offset) ||
+      !file.ReadBigEndian(directory_list_offset, &directory_count) ||
+      directory_count > file.size() / 4) {
+    return;
+  }
+
+  std::vector<std::string> directory_names;
+  for (uint32_t i = 0; i < directory_count; ++i) {
+    uint32_t name_offset;
+    absl::string_view name;
+    if (!file.ReadBigEndian(directory_list_offset + 4 + 4 * i, &name_offset) ||
+        !file.ReadString(name_offset, &name)) {
+      return;
+    }
+    directory_names.push_back(std::string(name));
+  }
+
+  std::vector<std::vector<std::string>> files(directory_count);
+  uint32_t bucket_count;
+  if (!file.ReadBigEndian(hash_offset, &bucket_count)) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < bucket_count; ++i) {
+    uint32_t icon_offset;
+    if (!file.ReadBigEndian(hash_offset + 4 + 4 * i, &icon_offset)) {
+      return;
+    }
+
+    // each icon takes 12 bytes, so a longer chain must be a loop
+    for (uint32_t length = 0; icon_offset != kGtkNoOffset; ++length) {
+      uint32_t chain_offset, name_offset, image_list_offset, image_count;
+      absl::string_view name;
+      if (length > file.size() / 12 ||
+          !file.ReadBigEndian(icon_offset, &chain_offset) ||
+          !file.ReadBigEndian(icon_offset + 4, &name_offset) ||
+          !file.ReadBigEndian(icon_offset + 8, &image_list_offset) ||
+          !file.ReadString(name_offset, &name) ||
+          !file.ReadBigEndian(image_list_offset, &image_count)) {
+        return;
+      }
+
+      for (uint32_t j = 0; j < image_count; ++j) {
+        uint16_t directory_index, flags;
+        if (!file.ReadBigEndian(image_list_offset + 4 + 8 * j,
+                                &directory_index) ||
+            !file.ReadBigEndian(image_list_offset + 6 + 8 * j, &flags)) {
+          return;
+        }
+        if (directory_index >= directory_count) {
+          continue;
+        }
+        if (flags & kGtkHasSuffixPng) {
+          files[directory_index].push_back(absl::StrCat(name, ".png"));
+        }
+        if (flags & kGtkHasSuffixXpm) {
+          files[directory_index].push_back(absl::StrCat(name, ".xpm"));
+        }
+        if (flags & kGtkHasSuffixSvg) {
+          files[directory_index].push_back(absl::StrCat(name, ".svg"));
+        }
+      }
+
+      icon_offset = chain_offset;
+    }
+  }
+
+  for (uint32_t i = 0; i < directory_count; ++i) {
+    gtk_directories_[directory_names[i]] = std::move(files[i]);
+  }
+}
+
+bool ThemeCache::IsGtkCacheNewer(int64_t mtime_sec, int64_t mtime_nsec) const {
+  return std::make_pair(gtk_cache_mtime_sec_, gtk_cache_mtime_nsec_) >=
+         std::make_pair(mtime_sec, mtime_nsec);
+}
+
+std::vector<std::string> ThemeCache::ListDirectory(std::string const& name) {
+  std::string path = util::fs::BuildPath({theme_path_, name});
+  Directory directory;
+  GetModificationTime(path, &directory.mtime_sec, &directory.mtime_nsec);
+
+  bool cached = false;
+  auto it = cached_directories_.find(name);
+  if (it != cached_directories_.end()) {
+    DirectoryRecord record;
+    cached = cache_file_->Read(
+                 sizeof(Header) + it->second * sizeof(DirectoryRecord),
+                 &record) &&
+             record.mtime_sec == directory.mtime_sec &&
+             record.mtime_nsec == directory.mtime_nsec;
+
+    for (uint32_t i = 0; cached && i < record.file_count; ++i) {
+      uint32_t file_offset;
+      absl::string_view file_name;
+      cached = cache_file_->Read(record.files_offset + 4 * i, &file_offset) &&
+               cache_file_->ReadString(file_offset, &file_name);
+      if (cached) {
+        directory.files.push_back(std::string(file_name));
+      }
+    }
+  }
+
+  if (cached) {
+    ++stats_.hits;
+  } else {
+    dirty_ = true;
+    directory.files.clear();
+
+    if (directory.mtime_sec != kMissing) {
+      if (!gtk_cache_loaded_) {
+        LoadGtkCache();
+      }
+
+      // files added to a directory only change its own modification time
+      auto gtk_it = gtk_directories_.find(name);
+      if (gtk_it != gtk_directories_.end() &&
+          IsGtkCacheNewer(directory.mtime_sec, directory.mtime_nsec)) {
+        directory.files = gtk_it->second;
+        ++stats_.gtk_hits;
+      } else {
+        directory.files = ReadDirectory(path);
+        ++stats_.scans;
+      }
+    } else {
+      ++stats_.scans;
+    }
+  }
+
+  directories_.push_back(std::make_pair(name, directory));
+  return directory.files;
+}
+
+bool ThemeCache::Save() {
+  if (!dirty_) {
+    return true;
+  }
+
+  std::string directory{util::fs::Path{path_}.DirectoryName()};
+  if (!util::fs::DirectoryExists(directory) &&
+      !util::fs::CreateDirectory(directory)) {
+    util::log::Error() << "Failed creating \"" << directory << "\"\n";
+    return false;
+  }
+
+  size_t file_count = 0;
+  for (auto const& entry : directories_) {
+    file_count += entry.second.files.size();
+  }
+
+  size_t files_base =
+      sizeof(Header) + directories_.size() * sizeof(DirectoryRecord);
+  size_t strings_base = files_base + file_count * sizeof(uint32_t);
+
+  std::string records, file_offsets, strings;
+  auto add_string = [&](std::string const& value) -> uint32_t {
+    uint32_t offset = strings_base + strings.size();
+    strings.append(value);
+    strings.push_back('\0');
+    return offset;
+  };
+
+  for (auto const& entry : directories_) {
+    DirectoryRecord record;
+    record.mtime_sec = entry.second.mtime_sec;
+    record.mtime_nsec = entry.second.mtime_nsec;
+    record.name_offset = add_string(entry.first);
+    record.file_count = entry.second.files.size();
+    record.files_offset = files_base + file_offsets.size();
+    record.reserved = 0;
+    AppendBytes(&records, record);
+
+    for (auto const& file_name : entry.second.files) {
+      AppendBytes(&file_offsets, add_string(file_name));
+    }
+  }
+
+  if (strings_base + strings.size() > UINT32_MAX) {
+    util::log::Error() << "Icon cache for \"" << theme_path_
+                       << "\" is too large\n";
+    return false;
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.directory_count = directories_.size();
+
+  std::string contents;
+  contents.reserve(strings_base + strings.size());
+  AppendBytes(&contents, header);
+  contents.append(records);
+  contents.append(file_offsets);
+  contents.append(strings);
+
+  if (!util::fs::WriteFileAtomically(path_, contents)) {
+    util::log::Error() << "Failed writing \"" << path_ << "\"\n";
+    return false;
+  }
+
+  dirty_ = false;
+  return true;
+}
+
+std::string const& ThemeCache::path() const { return path_; }
+
+std::string const& ThemeCache::theme_path() const { return theme_path_; }
+
+ThemeCache::Stats const& ThemeCache::stats() const { return stats_; }
+
+std::ostream& operator<<(std::ostream& os, ThemeCache::Stats const& stats) {
+  return os << "ThemeCache::Stats{hits: " << stats.hits
+            << ", gtk_hits: " << stats.gtk_hits << ", scans: " << stats.scans
+            << "}";
+}
+
+}  // namespace icon_cache
+}  // namespace launcher
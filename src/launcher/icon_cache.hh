@@ -0,0 +1,97 @@
+#ifndef TINT3_LAUNCHER_ICON_CACHE_HH
+#define TINT3_LAUNCHER_ICON_CACHE_HH
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "util/fs.hh"
+
+namespace launcher {
+namespace icon_cache {
+
+// Returns the directory where the icon theme caches are stored.
+util::fs::Path CacheDirectory();
+
+// Remembers the contents of the directories of an icon theme across restarts.
+//
+// The cache is a single binary file per theme, which is memory mapped when
+// opened. For each directory it stores its modification time and the names of
+// the files it contained: as long as the modification time doesn't change, the
+// directory isn't read again.
+// Directories missing from the cache are looked up in the icon-theme.cache
+// file generated by gtk-update-icon-cache, if the theme has one that isn't
+// older than either the theme or the directory, and only read from the file
+// system otherwise.
+//
+// Only the listings are cached, not the icon name -> path index built from
+// them (see IconIndex): indexing a listing is cheap compared to reading the
+// directory, and keeping it in memory allows themes to be combined freely.
+class ThemeCache {
+ public:
+  struct Stats {
+    // directories listed from the cache
+    uint64_t hits = 0;
+    // directories listed from icon-theme.cache
+    uint64_t gtk_hits = 0;
+    // directories read from the file system
+    uint64_t scans = 0;
+  };
+
+  // Opens the cache for the theme in the given directory (for example,
+  // /usr/share/icons/hicolor), stored under cache_directory.
+  ThemeCache(std::string const& cache_directory, std::string const& theme_path);
+  ~ThemeCache();
+
+  ThemeCache(ThemeCache const&) = delete;
+  ThemeCache& operator=(ThemeCache const&) = delete;
+
+  // Returns the names of the files in the given subdirectory of the theme.
+  // A directory that doesn't exist is listed as empty.
+  std::vector<std::string> ListDirectory(std::string const& name);
+
+  // Writes back the cache, if any directory was missing or out of date.
+  // Only the directories listed since the cache was opened are kept.
+  bool Save();
+
+  std::string const& path() const;
+  std::string const& theme_path() const;
+  Stats const& stats() const;
+
+ private:
+  struct Directory {
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    std::vector<std::string> files;
+  };
+
+  std::string path_;
+  std::string theme_path_;
+  std::unique_ptr<util::fs::MappedFile> cache_file_;
+  // directory name -> index of its record in cache_file_
+  std::unordered_map<std::string, uint32_t> cached_directories_;
+  // contents of icon-theme.cache, loaded on first use
+  bool gtk_cache_loaded_ = false;
+  int64_t gtk_cache_mtime_sec_ = 0;
+  int64_t gtk_cache_mtime_nsec_ = 0;
+  std::unordered_map<std::string, std::vector<std::string>> gtk_directories_;
+  // what Save() writes
+  std::vector<std::pair<std::string, Directory>> directories_;
+  bool dirty_ = false;
+  Stats stats_;
+
+  void LoadCacheFile();
+  void LoadGtkCache();
+  bool IsGtkCacheNewer(int64_t mtime_sec, int64_t mtime_nsec) const;
+};
+
+std::ostream& operator<<(std::ostream& os, ThemeCache::Stats const& stats);
+
+}  // namespace icon_cache
+}  // namespace launcher
+
+#endif  // TINT3_LAUNCHER_ICON_CACHE_HH
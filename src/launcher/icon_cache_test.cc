@@ -0,0 +1,206 @@
+#include "catch.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+#include "launcher/icon_cache.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+using launcher::icon_cache::ThemeCache;
+
+namespace {
+
+void Touch(std::string const& path) { util::fs::WriteFile(path, ""); }
+
+void SetModificationTime(std::string const& path, time_t sec) {
+  struct timespec times[2] = {{sec, 0}, {sec, 0}};
+  utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+std::vector<std::string> Sorted(std::vector<std::string> values) {
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+void AppendBigEndian16(std::string* output, uint16_t value) {
+  output->push_back(value >> 8);
+  output->push_back(value & 0xFF);
+}
+
+void AppendBigEndian32(std::string* output, uint32_t value) {
+  AppendBigEndian16(output, value >> 16);
+  AppendBigEndian16(output, value & 0xFFFF);
+}
+
+// Writes an icon-theme.cache listing "gtk-only.png" in "16x16/apps".
+void WriteGtkCache(std::string const& path) {
+  std::string contents;
+  // header: version, hash and directory list offsets
+  AppendBigEndian16(&contents, 1);
+  AppendBigEndian16(&contents, 0);
+  AppendBigEndian32(&contents, 12);
+  AppendBigEndian32(&contents, 44);
+  // hash, with a single bucket
+  AppendBigEndian32(&contents, 1);
+  AppendBigEndian32(&contents, 20);
+  // icon: chain, name and image list offsets
+  AppendBigEndian32(&contents, 0xFFFFFFFF);
+  AppendBigEndian32(&contents, 52);
+  AppendBigEndian32(&contents, 32);
+  // image list: directory 0, .png suffix, no image data
+  AppendBigEndian32(&contents, 1);
+  AppendBigEndian16(&contents, 0);
+  AppendBigEndian16(&contents, 4);
+  AppendBigEndian32(&contents, 0);
+  // directory list
+  AppendBigEndian32(&contents, 1);
+  AppendBigEndian32(&contents, 61);
+  // strings
+  contents.append("gtk-only", 9);
+  contents.append("16x16/apps", 11);
+  util::fs::WriteFile(path, contents);
+}
+
+}  // namespace
+
+TEST_CASE("ThemeCache") {
+  TempDirectory temp;
+  std::string const theme = temp / "theme";
+  std::string const cache_directory = temp / "cache";
+  std::vector<std::string> const kApps{"a.png", "b.xpm"};
+
+  REQUIRE(util::fs::CreateDirectory(theme + "/16x16/apps"));
+  REQUIRE(util::fs::CreateDirectory(theme + "/scalable/apps"));
+  Touch(theme + "/16x16/apps/a.png");
+  Touch(theme + "/16x16/apps/b.xpm");
+
+  SECTION("directories are only read once") {
+    {
+      ThemeCache cache{cache_directory, theme};
+      REQUIRE(Sorted(cache.ListDirectory("16x16/apps")) == kApps);
+      REQUIRE(cache.ListDirectory("missing").empty());
+      REQUIRE(cache.stats().scans == 2);
+      REQUIRE(cache.Save());
+      REQUIRE(util::fs::FileExists(cache.path()));
+    }
+
+    ThemeCache cache{cache_directory, theme};
+    REQUIRE(Sorted(cache.ListDirectory("16x16/apps")) == kApps);
+    REQUIRE(cache.ListDirectory("missing").empty());
+    REQUIRE(cache.stats().hits == 2);
+    REQUIRE(cache.stats().scans == 0);
+  }
+
+  SECTION("changed directories are read again") {
+    {
+      ThemeCache cache{cache_directory, theme};
+      cache.ListDirectory("16x16/apps");
+      cache.ListDirectory("scalable/apps");
+      REQUIRE(cache.Save());
+    }
+
+    Touch(theme + "/scalable/apps/c.png");
+    SetModificationTime(theme + "/scalable/apps", 1000);
+
+    ThemeCache cache{cache_directory, theme};
+    REQUIRE(Sorted(cache.ListDirectory("16x16/apps")) == kApps);
+    REQUIRE(cache.ListDirectory("scalable/apps") ==
+            std::vector<std::string>{"c.png"});
+    REQUIRE(cache.stats().hits == 1);
+    REQUIRE(cache.stats().scans == 1);
+  }
+
+  SECTION("an up to date icon-theme.cache is used") {
+    WriteGtkCache(theme + "/icon-theme.cache");
+
+    ThemeCache cache{cache_directory, theme};
+    REQUIRE(cache.ListDirectory("16x16/apps") ==
+            std::vector<std::string>{"gtk-only.png"});
+    REQUIRE(cache.ListDirectory("scalable/apps").empty());
+    REQUIRE(cache.stats().gtk_hits == 1);
+    REQUIRE(cache.stats().scans == 1);
+  }
+
+  SECTION("an outdated icon-theme.cache is ignored") {
+    WriteGtkCache(theme + "/icon-theme.cache");
+    SetModificationTime(theme + "/icon-theme.cache", 1000);
+
+    ThemeCache cache{cache_directory, theme};
+    REQUIRE(Sorted(cache.ListDirectory("16x16/apps")) == kApps);
+    REQUIRE(cache.stats().gtk_hits == 0);
+  }
+
+  SECTION("directories changed after icon-theme.cache are read again") {
+    WriteGtkCache(theme + "/icon-theme.cache");
+    SetModificationTime(theme + "/icon-theme.cache", 2000);
+    SetModificationTime(theme, 1000);
+    SetModificationTime(theme + "/16x16/apps", 3000);
+
+    ThemeCache cache{cache_directory, theme};
+    REQUIRE(Sorted(cache.ListDirectory("16x16/apps")) == kApps);
+    REQUIRE(cache.stats().gtk_hits == 0);
+    REQUIRE(cache.stats().scans == 1);
+  }
+
+  SECTION("corrupted caches are ignored") {
+    std::string path;
+    {
+      ThemeCache cache{cache_directory, theme};
+      cache.ListDirectory("16x16/apps");
+      REQUIRE(cache.Save());
+      path = cache.path();
+    }
+    util::fs::WriteFile(path, "garbage");
+
+    ThemeCache cache{cache_directory, theme};
+    REQUIRE(Sorted(cache.ListDirectory("16x16/apps")) == kApps);
+    REQUIRE(cache.stats().scans == 1);
+  }
+}
+
+// Not run by default: use "icon_cache_test [benchmark] -d yes" to see how long
+// it takes to list a large theme, with and without a cache.
+TEST_CASE("ThemeCache benchmark", "[.][benchmark]") {
+  constexpr int kDirectories = 100;
+  constexpr int kFiles = 200;
+
+  TempDirectory temp;
+  std::string const theme = temp / "theme";
+  std::string const cache_directory = temp / "cache";
+
+  std::vector<std::string> names;
+  for (int i = 0; i < kDirectories; ++i) {
+    names.push_back(absl::StrCat(i, "x", i, "/apps"));
+    std::string path = util::fs::BuildPath({theme, names.back()});
+    REQUIRE(util::fs::CreateDirectory(path));
+    for (int j = 0; j < kFiles; ++j) {
+      Touch(util::fs::BuildPath({path, absl::StrCat("icon-", j, ".png")}));
+    }
+  }
+
+  BENCHMARK("cold start") {
+    RemoveTree(cache_directory);
+    ThemeCache cache{cache_directory, theme};
+    for (auto const& name : names) {
+      cache.ListDirectory(name);
+    }
+    cache.Save();
+  }
+
+  BENCHMARK("warm start") {
+    ThemeCache cache{cache_directory, theme};
+    for (auto const& name : names) {
+      cache.ListDirectory(name);
+    }
+    cache.Save();
+  }
+}
@@ -32,13 +32,21 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 
 #include "launcher.hh"
 #include "launcher/desktop_entry.hh"
+#include "launcher/desktop_entry_cache.hh"
+#include "launcher/icon_cache.hh"
+#include "launcher/raster_cache.hh"
 #include "panel.hh"
 #include "server.hh"
 #include "startup_notification.hh"
@@ -60,6 +68,65 @@ XSettingsClient* xsettings_client;
 namespace {
 
 const char kIconFallback[] = "application-x-executable";
+const char* const kIconExtensions[] = {".png", ".xpm"};
+// adjustments for hovered and pressed icons found in the theme
+const util::imlib2::Asb kHoverAsb{100, 0, 10};
+const util::imlib2::Asb kPressedAsb{100, 0, -10};
+
+// Directories where icon themes, and unthemed icons, are looked up.
+std::vector<std::string> IconBaseDirectories() {
+  return {
+      util::fs::HomeDirectory() / ".icons",
+      util::fs::HomeDirectory() / ".local" / "share" / "icons",
+      "/usr/local/share/icons",
+      "/usr/local/share/pixmaps",
+      "/usr/share/icons",
+      "/usr/share/pixmaps",
+  };
+}
+
+// Directories where .desktop files are looked up, in order of precedence.
+std::vector<std::string> ApplicationDirectories() {
+  std::vector<std::string> directories = {
+      util::xdg::basedir::DataHome() / "applications",
+      util::fs::HomeDirectory() / ".local" / "share" / "applications",
+      "/usr/local/share/applications",
+      "/usr/share/applications",
+      "/opt/share/applications",
+  };
+  for (auto const& dir : util::xdg::basedir::DataDirs()) {
+    directories.push_back(util::fs::Path{dir} / "applications");
+  }
+  return directories;
+}
+
+// launcher_item_app values -> resolved .desktop file paths, only kept while
+// the application directories are being watched for changes
+std::unordered_map<std::string, std::string> desktop_entry_paths;
+
+bool ResolveDesktopEntry(std::string const& name, std::string* output_path) {
+  if (launcher_desktop_entry_cache.watching()) {
+    auto it = desktop_entry_paths.find(name);
+    if (it != desktop_entry_paths.end()) {
+      output_path->assign(it->second);
+      return true;
+    }
+  }
+
+  if (!FindDesktopEntry(name, output_path)) {
+    return false;
+  }
+  if (launcher_desktop_entry_cache.watching()) {
+    desktop_entry_paths[name] = *output_path;
+  }
+  return true;
+}
+
+// Icon themes loaded so far, by name, along with the icons found directly in
+// the base directories: these are shared by all the panels, and kept across
+// theme switches until the launcher is cleaned up.
+std::unordered_map<std::string, std::shared_ptr<IconTheme>> icon_themes;
+std::unique_ptr<IconIndex> unthemed_icons;
 
 void XSettingsNotifyCallback(const char* name, XSettingsAction action,
                              XSettingsSetting* setting, void* data) {
@@ -80,12 +147,8 @@ void XSettingsNotifyCallback(const char* name, XSettingsAction action,
     return;
 
   icon_theme_name = setting->data.v_string;
-  for (Panel& p : panels) {
-    Launcher& launcher = p.launcher_;
-    launcher.CleanupTheme();
-    launcher.LoadThemes();
-    launcher.LoadIcons();
-    launcher.need_resize_ = true;
+  for (auto& p : panels) {
+    p->launcher_.ReloadThemes();
   }
 }
 
@@ -108,6 +171,10 @@ void DefaultLauncher() {
 
 void InitLauncher() {
   if (launcher_enabled) {
+    launcher_raster_cache.set_directory(util::xdg::basedir::CacheHome() /
+                                        "tint3" / "launcher");
+    launcher_desktop_entry_cache.Watch(ApplicationDirectories());
+
     // if XSETTINGS manager running, tint3 read the icon_theme_name.
     xsettings_client =
         xsettings_client_new(server.dsp, server.root_window(),
@@ -146,8 +213,18 @@ void Launcher::InitPanel(Panel* panel) {
 void CleanupLauncher() {
   if (xsettings_client) xsettings_client_destroy(xsettings_client);
 
-  for (Panel& p : panels) {
-    p.launcher_.CleanupTheme();
+  if (launcher_enabled) {
+    util::log::Debug() << "Launcher icons: " << launcher_raster_cache.stats()
+                       << '\n';
+    util::log::Debug() << "Desktop entries: "
+                       << launcher_desktop_entry_cache.stats() << '\n';
+  }
+  desktop_entry_paths.clear();
+  icon_themes.clear();
+  unthemed_icons.reset();
+
+  for (auto& p : panels) {
+    p->launcher_.CleanupTheme();
   }
 
   panel_config.launcher_.list_apps_.clear();
@@ -155,6 +232,43 @@ void CleanupLauncher() {
   launcher_enabled = false;
 }
 
+void LauncherReadDesktopEntryChanges() {
+  if (launcher_desktop_entry_cache.ReadChanges().empty()) {
+    return;
+  }
+
+  // files being added or removed may change which one a name resolves to
+  desktop_entry_paths.clear();
+  for (auto& p : panels) {
+    Launcher& launcher = p->launcher_;
+    if (!launcher.list_apps_.empty() && launcher.LoadIcons()) {
+      launcher.need_resize_ = true;
+      panel_refresh = true;
+    }
+  }
+}
+
+bool LauncherReloadItems() {
+  std::vector<std::string> const& list_apps = panel_config.launcher_.list_apps_;
+  for (auto& p : panels) {
+    Launcher& launcher = p->launcher_;
+    if (launcher_enabled &&
+        launcher.list_apps_.empty() != list_apps.empty()) {
+      return false;
+    }
+  }
+
+  for (auto& p : panels) {
+    Launcher& launcher = p->launcher_;
+    launcher.list_apps_ = list_apps;
+    if (launcher_enabled && !list_apps.empty() && launcher.LoadIcons()) {
+      launcher.need_resize_ = true;
+      panel_refresh = true;
+    }
+  }
+  return true;
+}
+
 void Launcher::CleanupTheme() {
   FreeArea();
 
@@ -163,12 +277,26 @@ void Launcher::CleanupTheme() {
   }
   list_icons_.clear();
 
-  for (auto const& theme : list_themes_) {
-    if (theme) delete theme;
-  }
   list_themes_.clear();
 }
 
+void Launcher::ReloadThemes() {
+  list_themes_.clear();
+  LoadThemes();
+
+  // Only the icons that resolve to a different file need to be loaded again,
+  // which happens on the next resize.
+  for (auto& launcher_icon : list_icons_) {
+    if (launcher_icon->icon_scaled_ &&
+        GetIconPath(launcher_icon->icon_name_, launcher_icon->icon_size_) !=
+            launcher_icon->icon_path_) {
+      launcher_icon->icon_scaled_.Free();
+      launcher_icon->SetRedraw();
+    }
+  }
+  need_resize_ = true;
+}
+
 int Launcher::GetIconSize() const {
   Border const& b = bg_.border();
   const int left_right_border =
@@ -193,7 +321,7 @@ bool Launcher::Resize() {
   // Resize icons if necessary
   for (auto& launcher_icon : list_icons_) {
     if (launcher_icon->icon_size_ != icon_size ||
-        !launcher_icon->icon_original_) {
+        !launcher_icon->icon_scaled_) {
       launcher_icon->icon_size_ = icon_size;
       launcher_icon->width_ = launcher_icon->icon_size_;
       launcher_icon->height_ = launcher_icon->icon_size_;
@@ -203,65 +331,28 @@ bool Launcher::Resize() {
           GetIconPath(launcher_icon->icon_name_, launcher_icon->icon_size_);
 
       if (new_icon_path.empty()) {
-        // Draw a blank icon
-        launcher_icon->icon_original_.Free();
-        launcher_icon->icon_scaled_.Free();
-        launcher_icon->icon_hover_.Free();
-        launcher_icon->icon_pressed_.Free();
+        // Draw the fallback icon, or a blank one
         new_icon_path = GetIconPath(kIconFallback, launcher_icon->icon_size_);
 
-        if (!new_icon_path.empty()) {
-          launcher_icon->icon_original_ =
-              imlib_load_image(new_icon_path.c_str());
-
-          util::log::Error() << __FILE__ << ':' << __LINE__ << ": Using icon "
-                             << new_icon_path.c_str() << '\n';
-        }
-
-        launcher_icon->icon_scaled_ =
-            ScaleIcon(launcher_icon->icon_original_, icon_size);
-        launcher_icon->icon_hover_ = launcher_icon->icon_scaled_;
+        util::imlib2::Asb hover_asb, pressed_asb;
         if (new_panel_config.mouse_effects) {
-          launcher_icon->icon_hover_.AdjustASB(
+          hover_asb = util::imlib2::Asb{
               new_panel_config.mouse_hover_alpha,
-              new_panel_config.mouse_hover_saturation / 100.0f,
-              new_panel_config.mouse_hover_brightness / 100.0f);
-        }
-        launcher_icon->icon_pressed_ = launcher_icon->icon_scaled_;
-        if (new_panel_config.mouse_effects) {
-          launcher_icon->icon_pressed_.AdjustASB(
+              new_panel_config.mouse_hover_saturation,
+              new_panel_config.mouse_hover_brightness};
+          pressed_asb = util::imlib2::Asb{
               new_panel_config.mouse_pressed_alpha,
-              new_panel_config.mouse_pressed_saturation / 100.0f,
-              new_panel_config.mouse_pressed_brightness / 100.0f);
+              new_panel_config.mouse_pressed_saturation,
+              new_panel_config.mouse_pressed_brightness};
         }
-        continue;
-      }
-
-      if (!launcher_icon->icon_path_.empty() &&
-          new_icon_path == launcher_icon->icon_path_) {
-        // If it's the same file just rescale
-        launcher_icon->icon_scaled_ =
-            ScaleIcon(launcher_icon->icon_original_, icon_size);
-        launcher_icon->icon_hover_ = launcher_icon->icon_scaled_;
-        launcher_icon->icon_hover_.AdjustASB(100, 0.0, +0.1);
-        launcher_icon->icon_pressed_ = launcher_icon->icon_scaled_;
-        launcher_icon->icon_pressed_.AdjustASB(100, 0.0, -0.1);
-
-        util::log::Error() << __FILE__ << ':' << __LINE__ << ": Using icon "
-                           << launcher_icon->icon_path_ << '\n';
+        launcher_icon->LoadIcon(new_icon_path, hover_asb, pressed_asb);
       } else {
-        // Load the new file and scale
-        launcher_icon->icon_original_ = imlib_load_image(new_icon_path.c_str());
-        launcher_icon->icon_scaled_ =
-            ScaleIcon(launcher_icon->icon_original_, launcher_icon->icon_size_);
-        launcher_icon->icon_hover_ = launcher_icon->icon_scaled_;
-        launcher_icon->icon_hover_.AdjustASB(100, 0.0, +0.1);
-        launcher_icon->icon_pressed_ = launcher_icon->icon_scaled_;
-        launcher_icon->icon_pressed_.AdjustASB(100, 0.0, -0.1);
-        launcher_icon->icon_path_ = new_icon_path;
+        launcher_icon->LoadIcon(new_icon_path, kHoverAsb, kPressedAsb);
+      }
 
+      if (!new_icon_path.empty()) {
         util::log::Error() << __FILE__ << ':' << __LINE__ << ": Using icon "
-                           << launcher_icon->icon_path_ << '\n';
+                           << new_icon_path << '\n';
       }
     }
   }
@@ -363,6 +454,51 @@ void LauncherIcon::DrawForeground(cairo_t* c) {
   if (image) RenderImage(&server, pix_, image, 0, 0);
 }
 
+void LauncherIcon::LoadIcon(std::string const& path,
+                            util::imlib2::Asb const& hover_asb,
+                            util::imlib2::Asb const& pressed_asb) {
+  launcher::raster_cache::Key key;
+  key.path = path;
+  key.size = icon_size_;
+  key.asb = util::imlib2::Asb{launcher_alpha, launcher_saturation,
+                              launcher_brightness};
+  key.hover_asb = hover_asb;
+  key.pressed_asb = pressed_asb;
+  bool cacheable =
+      !path.empty() && launcher::raster_cache::UpdateModificationTime(&key);
+
+  launcher::raster_cache::Rasters rasters;
+  if (cacheable && launcher_raster_cache.Find(key, &rasters)) {
+    icon_scaled_ = std::move(rasters.normal);
+    icon_hover_ = std::move(rasters.hover);
+    icon_pressed_ = std::move(rasters.pressed);
+    // the original image is only needed to produce new rasters, which is
+    // unlikely to happen again soon
+    icon_original_.Free();
+    icon_path_ = path;
+    return;
+  }
+
+  if (path.empty()) {
+    icon_original_.Free();
+  } else if (path != icon_path_ || !icon_original_) {
+    icon_original_ = imlib_load_image(path.c_str());
+  }
+  icon_path_ = path;
+
+  icon_scaled_ = ScaleIcon(icon_original_, icon_size_);
+  icon_hover_ = icon_scaled_;
+  icon_hover_.AdjustASB(hover_asb);
+  icon_pressed_ = icon_scaled_;
+  icon_pressed_.AdjustASB(pressed_asb);
+
+  if (cacheable && icon_original_) {
+    launcher_raster_cache.Insert(key, launcher::raster_cache::Rasters{
+                                          icon_scaled_, icon_hover_,
+                                          icon_pressed_});
+  }
+}
+
 bool LauncherIcon::OnClick(XEvent* event) {
   if (!Area::OnClick(event)) {
     return false;
@@ -438,6 +574,51 @@ bool ParseThemeLine(std::string const& line, std::string& key,
   return (found && !key.empty() && !value.empty());
 }
 
+void IconIndex::AddDirectory(std::string const& path, IconThemeDir* dir) {
+  std::vector<std::string> file_names;
+  for (std::string const& file_name : util::fs::DirectoryContents{path}) {
+    file_names.push_back(file_name);
+  }
+  AddFiles(path, file_names, dir);
+}
+
+void IconIndex::AddFiles(std::string const& path,
+                         std::vector<std::string> const& file_names,
+                         IconThemeDir* dir) {
+  // (name, file name) pairs for the .png files, the .xpm files, and the files
+  // matched by their full name, in this order
+  std::vector<std::pair<std::string, std::string>> matches[3];
+
+  for (std::string const& file_name : file_names) {
+    for (size_t i = 0; i < 2; ++i) {
+      absl::string_view name{file_name};
+      if (absl::ConsumeSuffix(&name, kIconExtensions[i]) && !name.empty()) {
+        matches[i].emplace_back(std::string(name), file_name);
+        matches[2].emplace_back(file_name, file_name);
+        break;
+      }
+    }
+  }
+
+  for (auto const& files : matches) {
+    for (auto const& file : files) {
+      files_[file.first].push_back(
+          IconFile{dir, util::fs::BuildPath({path, file.second})});
+    }
+  }
+}
+
+std::vector<IconFile> const& IconIndex::Find(
+    std::string const& icon_name) const {
+  static const std::vector<IconFile> kNoFiles;
+
+  auto it = files_.find(icon_name);
+  if (it == files_.end()) {
+    return kNoFiles;
+  }
+  return it->second;
+}
+
 IconTheme::~IconTheme() {
   for (auto const& dir : list_directories) {
     delete dir;
@@ -642,20 +823,6 @@ void ExpandExec(launcher::desktop_entry::Group* group,
   group->AddEntry("Exec", expanded);
 }
 
-bool ParseDesktopFile(std::string const& contents,
-                      launcher::desktop_entry::DesktopEntry* output) {
-  launcher::desktop_entry::Parser desktop_entry_parser;
-  parser::Parser p{launcher::desktop_entry::kLexer, &desktop_entry_parser};
-  if (!p.Parse(contents)) {
-    return false;
-  }
-
-  launcher::desktop_entry::DesktopEntry desktop_entry{
-      desktop_entry_parser.GetDesktopEntry()};
-  output->assign(desktop_entry.begin(), desktop_entry.end());
-  return true;
-}
-
 }  // namespace
 
 bool FindDesktopEntry(std::string const& name, std::string* output_path) {
@@ -666,24 +833,8 @@ bool FindDesktopEntry(std::string const& name, std::string* output_path) {
   }
 
   // Second, try and find the given .desktop entry name in a standard location
-  std::vector<std::string> candidates = {
-      util::xdg::basedir::DataHome() / "applications" / name,
-      util::fs::HomeDirectory() / ".local" / "share" / "applications" / name,
-      util::fs::Path("/usr/local/share/applications") / name,
-      util::fs::Path("/usr/share/applications") / name,
-      util::fs::Path("/opt/share/applications") / name,
-  };
-
-  auto it = std::find_if(
-      candidates.begin(), candidates.end(),
-      [](util::fs::Path const& item) { return util::fs::FileExists(item); });
-  if (it != candidates.end()) {
-    output_path->assign(*it);
-    return true;
-  }
-
-  for (auto const& dir : util::xdg::basedir::DataDirs()) {
-    std::string resolved_path = util::fs::Path{dir} / "applications" / name;
+  for (auto const& dir : ApplicationDirectories()) {
+    std::string resolved_path = util::fs::Path{dir} / name;
     if (util::fs::FileExists(resolved_path)) {
       output_path->assign(resolved_path);
       return true;
@@ -695,69 +846,153 @@ bool FindDesktopEntry(std::string const& name, std::string* output_path) {
 }
 
 // Populates the list_icons list
-void Launcher::LoadIcons() {
+bool Launcher::LoadIcons() {
+  std::vector<LauncherIcon*> old_icons;
+  old_icons.swap(list_icons_);
+  bool changed = false;
+
   // Load apps (.desktop style launcher items)
   for (auto const& path : list_apps_) {
     std::string resolved_path;
-    if (!FindDesktopEntry(path, &resolved_path)) {
+    if (!ResolveDesktopEntry(path, &resolved_path)) {
       util::log::Error() << "File \"" << path << "\" not found, skipping\n";
       continue;
     }
 
-    util::fs::ReadFile(resolved_path, [&](std::string const& contents) {
-      launcher::desktop_entry::DesktopEntry entry;
-      if (!ParseDesktopFile(contents, &entry)) {
-        util::log::Error() << "Failed parsing \"" << path << "\", skipping.\n";
-        return false;
-      }
+    auto entry = launcher_desktop_entry_cache.Get(resolved_path);
+    if (entry == nullptr) {
+      util::log::Error() << "Failed parsing \"" << path << "\", skipping.\n";
+      continue;
+    }
 
-      // Reference to the first group, "Desktop Entry".
-      auto& de = entry[0];
+    // Icons built from the very same parsed file are kept as they are.
+    auto it = std::find_if(
+        old_icons.begin(), old_icons.end(), [&](LauncherIcon* icon) {
+          return icon != nullptr &&
+                 icon->desktop_entry_serial_ == entry->serial;
+        });
+    if (it != old_icons.end()) {
+      list_icons_.push_back(*it);
+      *it = nullptr;
+      continue;
+    }
 
-      if (!de.IsEntry<std::string>("Type") ||
-          de.GetEntry<std::string>("Type") != "Application") {
-        util::log::Error() << "Desktop entry \"" << path << "\" not of type "
-                           << "\"Application\", skipping.\n";
-        return false;
-      }
+    LauncherIcon* launcher_icon = NewIcon(path, *entry);
+    if (launcher_icon != nullptr) {
+      list_icons_.push_back(launcher_icon);
+      changed = true;
+    }
+  }
 
-      if (de.IsEntry<std::string>("Exec")) {
-        ExpandExec(&de, path);
-
-        auto launcher_icon = new LauncherIcon();
-        launcher_icon->parent_ = this;
-        launcher_icon->panel_ = panel_;
-        launcher_icon->size_mode_ = SizeMode::kByContent;
-        launcher_icon->need_resize_ = false;
-        launcher_icon->need_redraw_ = true;
-        launcher_icon->bg_ = backgrounds.front();
-        launcher_icon->on_screen_ = true;
-
-        launcher_icon->is_app_desktop_ = true;
-        launcher_icon->cmd_ = de.GetEntry<std::string>("Exec");
-        launcher_icon->icon_name_ = de.HasEntry("Icon")
-                                        ? de.GetEntry<std::string>("Icon")
-                                        : kIconFallback;
-        launcher_icon->icon_size_ = 1;
-        if (de.HasEntry("Comment")) {
-          launcher_icon->icon_tooltip_ =
-              launcher::desktop_entry::BestLocalizedEntry(de, "Comment");
-        } else if (de.HasEntry("Name")) {
-          launcher_icon->icon_tooltip_ =
-              launcher::desktop_entry::BestLocalizedEntry(de, "Name");
-        } else {
-          launcher_icon->icon_tooltip_ = de.GetEntry<std::string>("Exec");
-        }
+  for (auto const& icon : old_icons) {
+    if (icon) {
+      icon->FreeArea();
+      delete icon;
+      changed = true;
+    }
+  }
 
-        list_icons_.push_back(launcher_icon);
-        AddChild(launcher_icon);
-      }
+  children_.assign(list_icons_.begin(), list_icons_.end());
+  if (changed) {
+    SetRedraw();
+  }
+  return changed;
+}
 
-      return true;
-    });
+LauncherIcon* Launcher::NewIcon(
+    std::string const& path,
+    launcher::desktop_entry_cache::Entry const& entry) {
+  // Copy of the first group, "Desktop Entry".
+  auto de = entry.contents[0];
+
+  if (!de.IsEntry<std::string>("Type") ||
+      de.GetEntry<std::string>("Type") != "Application") {
+    util::log::Error() << "Desktop entry \"" << path << "\" not of type "
+                       << "\"Application\", skipping.\n";
+    return nullptr;
+  }
+
+  if (!de.IsEntry<std::string>("Exec")) {
+    return nullptr;
+  }
+
+  ExpandExec(&de, path);
+
+  auto launcher_icon = new LauncherIcon();
+  launcher_icon->parent_ = this;
+  launcher_icon->panel_ = panel_;
+  launcher_icon->size_mode_ = SizeMode::kByContent;
+  launcher_icon->need_resize_ = false;
+  launcher_icon->need_redraw_ = true;
+  launcher_icon->bg_ = backgrounds.front();
+  launcher_icon->on_screen_ = true;
+
+  launcher_icon->is_app_desktop_ = true;
+  launcher_icon->desktop_entry_serial_ = entry.serial;
+  launcher_icon->cmd_ = de.GetEntry<std::string>("Exec");
+  launcher_icon->icon_name_ =
+      de.HasEntry("Icon") ? de.GetEntry<std::string>("Icon") : kIconFallback;
+  launcher_icon->icon_size_ = 1;
+  if (de.HasEntry("Comment")) {
+    launcher_icon->icon_tooltip_ =
+        launcher::desktop_entry::BestLocalizedEntry(de, "Comment");
+  } else if (de.HasEntry("Name")) {
+    launcher_icon->icon_tooltip_ =
+        launcher::desktop_entry::BestLocalizedEntry(de, "Name");
+  } else {
+    launcher_icon->icon_tooltip_ = de.GetEntry<std::string>("Exec");
   }
+  return launcher_icon;
 }
 
+namespace {
+
+// Returns the theme with the given name, loading it and indexing its contents
+// unless another panel, or a previous theme switch, already did.
+std::shared_ptr<IconTheme> GetIconTheme(
+    std::string const& name, std::vector<std::string> const& base_names) {
+  auto it = icon_themes.find(name);
+  if (it != icon_themes.end()) {
+    return it->second;
+  }
+
+  std::shared_ptr<IconTheme> theme{LoadTheme(name)};
+  if (!theme) {
+    return nullptr;
+  }
+
+  // list the theme contents once, so that looking up icons later on doesn't
+  // need to stat() a file for every directory and extension; the listings
+  // are cached across restarts
+  std::string cache_directory = launcher::icon_cache::CacheDirectory();
+  std::vector<std::unique_ptr<launcher::icon_cache::ThemeCache>> caches;
+  for (auto const& base_name : base_names) {
+    std::string theme_path = util::fs::BuildPath({base_name, theme->name});
+    if (util::fs::DirectoryExists(theme_path)) {
+      caches.emplace_back(
+          new launcher::icon_cache::ThemeCache{cache_directory, theme_path});
+    }
+  }
+
+  for (auto const& dir : theme->list_directories) {
+    for (auto const& cache : caches) {
+      std::string path = util::fs::BuildPath({cache->theme_path(), dir->name});
+      theme->index.AddFiles(path, cache->ListDirectory(dir->name), dir);
+    }
+  }
+
+  for (auto const& cache : caches) {
+    cache->Save();
+    util::log::Debug() << "Icon theme \"" << cache->theme_path()
+                       << "\": " << cache->stats() << '\n';
+  }
+
+  icon_themes[name] = theme;
+  return theme;
+}
+
+}  // namespace
+
 // Populates the list_themes list
 bool Launcher::LoadThemes() {
   // load the user theme, all the inherited themes recursively (DFS), and the
@@ -770,6 +1005,14 @@ bool Launcher::LoadThemes() {
     util::log::Error() << "Loading \"" << icon_theme_name << "\". Icon theme:";
   }
 
+  std::vector<std::string> base_names = IconBaseDirectories();
+  if (!unthemed_icons) {
+    unthemed_icons.reset(new IconIndex);
+    for (auto const& base_name : base_names) {
+      unthemed_icons->AddDirectory(base_name, nullptr);
+    }
+  }
+
   std::list<std::string> queue{icon_theme_name};
   std::set<std::string> queued{icon_theme_name};
   bool icon_theme_name_loaded = false;
@@ -789,7 +1032,7 @@ bool Launcher::LoadThemes() {
     queue.pop_front();
 
     util::log::Error() << " '" << name << "',";
-    auto theme = LoadTheme(name);
+    auto theme = GetIconTheme(name, base_names);
     if (theme == nullptr) {
       continue;
     }
@@ -860,28 +1103,6 @@ std::string Launcher::GetIconPath(std::string const& icon_name, int size) {
     return std::string();
   }
 
-  std::vector<std::string> basenames{
-      util::fs::HomeDirectory() / ".icons",
-      util::fs::HomeDirectory() / ".local" / "share" / "icons",
-      "/usr/local/share/icons",
-      "/usr/local/share/pixmaps",
-      "/usr/share/icons",
-      "/usr/share/pixmaps",
-  };
-
-  std::vector<std::string> extensions{".png", ".xpm"};
-
-  // if the icon name already contains one of the extensions (e.g. vlc.png
-  // instead of vlc) add a special entry
-  for (auto const& extension : extensions) {
-    if (icon_name.length() > extension.length() &&
-        icon_name.substr(icon_name.length() - extension.length()) ==
-            extension) {
-      extensions.push_back("");
-      break;
-    }
-  }
-
   // Stage 1: best size match
   // Contrary to the freedesktop spec, we are not choosing the closest icon in
   // size, but the next larger icon
@@ -902,32 +1123,24 @@ std::string Launcher::GetIconPath(std::string const& icon_name, int size) {
   IconTheme* next_larger_theme = nullptr;
 
   for (auto const& theme : list_themes_) {
-    for (auto const& dir : theme->list_directories) {
-      for (auto const& base_name : basenames) {
-        for (auto const& extension : extensions) {
-          std::string icon_file_name(icon_name + extension);
-          std::string file_name = util::fs::BuildPath(
-              {base_name, theme->name, dir->name, icon_file_name});
-
-          if (util::fs::FileExists(file_name)) {
-            // Closest match
-            if (DirectorySizeDistance(dir, size) < minimal_size &&
-                (!best_file_theme || theme == best_file_theme)) {
-              best_file_name = file_name;
-              minimal_size = DirectorySizeDistance(dir, size);
-              best_file_theme = theme;
-            }
-
-            // Next larger match
-            if (dir->size >= size &&
-                (next_larger_size == -1 || dir->size < next_larger_size) &&
-                (!next_larger_theme || theme == next_larger_theme)) {
-              next_larger = file_name;
-              next_larger_size = dir->size;
-              next_larger_theme = theme;
-            }
-          }
-        }
+    for (IconFile const& file : theme->index.Find(icon_name)) {
+      IconThemeDir* dir = file.dir;
+
+      // Closest match
+      if (DirectorySizeDistance(dir, size) < minimal_size &&
+          (!best_file_theme || theme.get() == best_file_theme)) {
+        best_file_name = file.path;
+        minimal_size = DirectorySizeDistance(dir, size);
+        best_file_theme = theme.get();
+      }
+
+      // Next larger match
+      if (dir->size >= size &&
+          (next_larger_size == -1 || dir->size < next_larger_size) &&
+          (!next_larger_theme || theme.get() == next_larger_theme)) {
+        next_larger = file.path;
+        next_larger_size = dir->size;
+        next_larger_theme = theme.get();
       }
     }
   }
@@ -941,14 +1154,11 @@ std::string Launcher::GetIconPath(std::string const& icon_name, int size) {
   }
 
   // Stage 2: look in unthemed icons
-  for (auto const& base_name : basenames) {
-    for (auto const& extension : extensions) {
-      std::string icon_file_name(icon_name + extension);
-      std::string file_name = util::fs::BuildPath({base_name, icon_file_name});
-
-      if (util::fs::FileExists(file_name)) {
-        return file_name;
-      }
+  if (unthemed_icons) {
+    std::vector<IconFile> const& unthemed_files =
+        unthemed_icons->Find(icon_name);
+    if (!unthemed_files.empty()) {
+      return unthemed_files.front().path;
     }
   }
 
@@ -2,9 +2,13 @@
 #define TINT3_LAUNCHER_LAUNCHER_HH
 
 #include <xsettings-client.h>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "launcher/desktop_entry_cache.hh"
 #include "util/area.hh"
 #include "util/common.hh"
 #include "util/imlib2.hh"
@@ -21,11 +25,19 @@ class LauncherIcon : public Area {
   std::string icon_tooltip_;
   int icon_size_ = 0;
   bool is_app_desktop_ = false;
+  // serial of the parsed .desktop file this icon was built from
+  uint64_t desktop_entry_serial_ = 0;
   int x_ = 0;
   int y_ = 0;
 
   LauncherIcon();
 
+  // Loads the icon from the given file, at the current icon_size_, along with
+  // its hover and pressed variants. Goes through launcher_raster_cache, so
+  // the file is only decoded when the rasters aren't cached yet.
+  void LoadIcon(std::string const& path, util::imlib2::Asb const& hover_asb,
+                util::imlib2::Asb const& pressed_asb);
+
   void DrawForeground(cairo_t*) override;
   std::string GetTooltipText() override;
   void OnChangeLayout() override;
@@ -56,6 +68,34 @@ struct IconThemeDir {
   int threshold;
 };
 
+struct IconFile {
+  // nullptr for icons that don't belong to a theme
+  IconThemeDir* dir;
+  std::string path;
+};
+
+// Maps icon names to the .png and .xpm files providing them, so that icons can
+// be looked up without touching the file system.
+//
+// Names are indexed both with and without the extension, so that "vlc" and
+// "vlc.png" both find "vlc.png", while only the latter finds "vlc.png.png".
+class IconIndex {
+ public:
+  // Indexes the icons in the given directory, which may not exist.
+  // Icons from directories added earlier take precedence over the ones added
+  // later; within the same directory, .png files win over .xpm ones.
+  void AddDirectory(std::string const& path, IconThemeDir* dir);
+  // Same as above, for a directory whose contents are already known.
+  void AddFiles(std::string const& path,
+                std::vector<std::string> const& file_names, IconThemeDir* dir);
+
+  // Returns the files for the given icon name, in order of precedence.
+  std::vector<IconFile> const& Find(std::string const& icon_name) const;
+
+ private:
+  std::unordered_map<std::string, std::vector<IconFile>> files_;
+};
+
 class IconTheme {
  public:
   ~IconTheme();
@@ -63,15 +103,19 @@ class IconTheme {
   std::string name;
   std::vector<std::string> list_inherits;
   std::vector<IconThemeDir*> list_directories;
+  IconIndex index;
 };
 
 class Launcher : public Area {
   std::string GetIconPath(std::string const& icon_name, int size);
+  LauncherIcon* NewIcon(std::string const& path,
+                        launcher::desktop_entry_cache::Entry const& entry);
 
  public:
   std::vector<std::string> list_apps_;  // paths to .desktop files
   std::vector<LauncherIcon*> list_icons_;
-  std::vector<IconTheme*> list_themes_;
+  // shared with the other panels
+  std::vector<std::shared_ptr<IconTheme>> list_themes_;
 
   int GetIconSize() const;
 
@@ -80,8 +124,14 @@ class Launcher : public Area {
   // Populates the list_themes list
   bool LoadThemes();
 
-  // Populates the list_icons list
-  void LoadIcons();
+  // Switches to the current icon_theme_name, keeping the icons and reloading
+  // only the ones that resolve to a different file.
+  void ReloadThemes();
+
+  // Populates the list_icons list, keeping the icons whose .desktop file
+  // didn't change since they were built. Returns true if any icon was added,
+  // removed or replaced.
+  bool LoadIcons();
 
   bool Resize() override;
 
@@ -110,6 +160,16 @@ void DefaultLauncher();
 void InitLauncher();
 void CleanupLauncher();
 
+// Rebuilds the launcher icons whose .desktop files changed on disk.
+// Meant to be run when launcher_desktop_entry_cache.FileDescriptor() becomes
+// readable.
+void LauncherReadDesktopEntryChanges();
+
+// Updates the launcher items of the running panels with the ones currently
+// configured. Returns false if that requires adding or removing the launcher
+// from the panels.
+bool LauncherReloadItems();
+
 // Looks up for the given desktop entry in well known paths.
 // The desktop entry can be a relative or absolute path to a file, or it can
 // be simply the file name that will be resolved against standard XDG dirs.
@@ -48,6 +48,35 @@ TEST_CASE("FindDesktopEntry") {
   }
 }
 
+TEST_CASE("IconIndex") {
+  const std::string kAppsPath =
+      "src/launcher/testdata/.icons/UnitTestTheme/16x16/apps";
+
+  IconThemeDir dir;
+  IconIndex index;
+  index.AddDirectory(kAppsPath, &dir);
+  index.AddDirectory("/tmp/bogus_path", nullptr);
+
+  SECTION("png files are preferred") {
+    auto const& files = index.Find("unit-test");
+    REQUIRE(files.size() == 2);
+    REQUIRE(files[0].dir == &dir);
+    REQUIRE(files[0].path == kAppsPath + "/unit-test.png");
+    REQUIRE(files[1].path == kAppsPath + "/unit-test.xpm");
+  }
+
+  SECTION("names with an extension") {
+    auto const& files = index.Find("unit-test.xpm");
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].path == kAppsPath + "/unit-test.xpm");
+  }
+
+  SECTION("missing icons") {
+    REQUIRE(index.Find("unit-test.svg").empty());
+    REQUIRE(index.Find("missing").empty());
+  }
+}
+
 TEST_CASE("Launcher::LoadThemes") {
   auto data_home =
       environment::MakeScopedOverride("HOME", "src/launcher/testdata");
@@ -57,6 +86,14 @@ TEST_CASE("Launcher::LoadThemes") {
   //  src/launcher/testdata/.icons/UnitTestTheme/index.theme
   Launcher l;
   REQUIRE(l.LoadThemes());
+
+  // Themes are only loaded once, and shared by all the panels.
+  Launcher other;
+  REQUIRE(other.LoadThemes());
+  REQUIRE_FALSE(other.list_themes_.empty());
+  REQUIRE(other.list_themes_.front() == l.list_themes_.front());
+
+  other.CleanupTheme();
   l.CleanupTheme();
 }
 
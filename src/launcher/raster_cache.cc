@@ -0,0 +1,268 @@
+#include "launcher/raster_cache.hh"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+#include "util/fs.hh"
+#include "util/hash.hh"
+#include "util/log.hh"
+
+launcher::raster_cache::RasterCache launcher_raster_cache;
+
+namespace launcher {
+namespace raster_cache {
+
+namespace {
+
+// Each file is laid out as follows, in native byte order:
+//  - a Header;
+//  - the serialized key, padded to a multiple of 4 bytes;
+//  - raster_count rasters of size * size ARGB pixels, as stored by imlib2:
+//    normal, hover and pressed, in this order.
+const char kMagic[8] = {'t', 'i', 'n', 't', '3', 'r', 'a', '\0'};
+const uint32_t kVersion = 1;
+const uint32_t kRasterCount = 3;
+const char kExtension[] = ".argb";
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t size;
+  uint32_t key_length;
+  uint32_t raster_count;
+};
+
+static_assert(sizeof(Header) == 24, "unexpected padding in Header");
+
+size_t PixelsOffset(size_t key_length) {
+  return sizeof(Header) + (key_length + 3) / 4 * 4;
+}
+
+std::string Serialize(Key const& key) {
+  auto asb = [](util::imlib2::Asb const& asb) {
+    return absl::StrCat(asb.alpha, " ", asb.saturation, " ", asb.brightness);
+  };
+  return absl::StrCat(key.path, "\n", key.mtime_sec, ".", key.mtime_nsec,
+                      "\n", key.size, "\n", asb(key.asb), "\n",
+                      asb(key.hover_asb), "\n", asb(key.pressed_asb));
+}
+
+}  // namespace
+
+bool UpdateModificationTime(Key* key) {
+  struct stat info;
+  if (stat(key->path.c_str(), &info) != 0) {
+    return false;
+  }
+  key->mtime_sec = info.st_mtim.tv_sec;
+  key->mtime_nsec = info.st_mtim.tv_nsec;
+  return true;
+}
+
+constexpr size_t RasterCache::kDefaultCapacity;
+constexpr uint64_t RasterCache::kDefaultMaxDiskBytes;
+
+RasterCache::RasterCache(size_t capacity, uint64_t max_disk_bytes)
+    : entries_(capacity), max_disk_bytes_(max_disk_bytes) {}
+
+void RasterCache::set_directory(std::string const& directory) {
+  directory_ = directory;
+  if (!directory_.empty()) {
+    Prune();
+  }
+}
+
+bool RasterCache::Find(Key const& key, Rasters* rasters) {
+  std::string serialized_key = Serialize(key);
+
+  Rasters* entry = entries_.Get(serialized_key);
+  if (entry != nullptr) {
+    *rasters = *entry;
+    ++stats_.memory_hits;
+    return true;
+  }
+
+  if (!directory_.empty() && ReadFile(serialized_key, key.size, rasters)) {
+    entries_.Put(serialized_key, *rasters);
+    ++stats_.disk_hits;
+    return true;
+  }
+
+  ++stats_.misses;
+  return false;
+}
+
+void RasterCache::Insert(Key const& key, Rasters const& rasters) {
+  std::string serialized_key = Serialize(key);
+  entries_.Put(serialized_key, rasters);
+
+  if (!directory_.empty()) {
+    WriteFile(serialized_key, key.size, rasters);
+  }
+}
+
+void RasterCache::Clear() { entries_.Clear(); }
+
+RasterCache::Stats const& RasterCache::stats() const { return stats_; }
+
+std::string RasterCache::FilePath(std::string const& key) const {
+  return util::fs::BuildPath(
+      {directory_, absl::StrCat(absl::Hex(util::Fnv1aHash(key),
+                                          absl::kZeroPad16),
+                                kExtension)});
+}
+
+void RasterCache::Prune() {
+  struct File {
+    std::string path;
+    struct timespec atime;
+    uint64_t size;
+  };
+
+  std::vector<File> files;
+  disk_bytes_ = 0;
+  for (std::string const& name : util::fs::DirectoryContents{directory_}) {
+    if (!absl::EndsWith(name, kExtension)) {
+      continue;
+    }
+    std::string path = util::fs::BuildPath({directory_, name});
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+      continue;
+    }
+    files.push_back(File{path, info.st_atim, uint64_t(info.st_size)});
+    disk_bytes_ += info.st_size;
+  }
+  if (disk_bytes_ <= max_disk_bytes_) {
+    return;
+  }
+
+  // drop the least recently used files, leaving some room so that the next
+  // few writes don't need to go through the directory again
+  std::sort(files.begin(), files.end(), [](File const& lhs, File const& rhs) {
+    if (lhs.atime.tv_sec != rhs.atime.tv_sec) {
+      return lhs.atime.tv_sec < rhs.atime.tv_sec;
+    }
+    return lhs.atime.tv_nsec < rhs.atime.tv_nsec;
+  });
+  uint64_t target = max_disk_bytes_ / 4 * 3;
+  for (File const& file : files) {
+    if (disk_bytes_ <= target) {
+      break;
+    }
+    if (util::fs::Unlink(file.path)) {
+      disk_bytes_ -= file.size;
+    }
+  }
+}
+
+bool RasterCache::ReadFile(std::string const& key, unsigned int size,
+                           Rasters* rasters) {
+  util::fs::MappedFile file{FilePath(key)};
+  Header header;
+  if (!file.Read(0, &header) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.size != size ||
+      header.raster_count != kRasterCount ||
+      header.key_length != key.length()) {
+    return false;
+  }
+
+  size_t raster_bytes = size_t{size} * size * sizeof(DATA32);
+  size_t pixels_offset = PixelsOffset(header.key_length);
+  if (file.size() != pixels_offset + kRasterCount * raster_bytes ||
+      absl::string_view(file.data() + sizeof(Header), header.key_length) !=
+          key) {
+    // a different key with the same hash, or a damaged file
+    return false;
+  }
+
+  util::imlib2::ScopedCurrentImageRestorer restorer;
+  util::imlib2::Image* images[] = {&rasters->normal, &rasters->hover,
+                                   &rasters->pressed};
+  for (uint32_t i = 0; i < kRasterCount; ++i) {
+    // imlib2 copies the data, so it doesn't matter that it's read-only
+    DATA32* data = reinterpret_cast<DATA32*>(const_cast<char*>(
+        file.data() + pixels_offset + i * raster_bytes));
+    *images[i] = imlib_create_image_using_copied_data(size, size, data);
+    if (*images[i] == nullptr) {
+      return false;
+    }
+    imlib_context_set_image(*images[i]);
+    imlib_image_set_has_alpha(1);
+  }
+
+  // access times are what pruning goes by, and mounting with relatime (the
+  // default) mostly leaves them alone on reads
+  struct timespec const times[] = {{0, UTIME_NOW}, {0, UTIME_OMIT}};
+  utimensat(AT_FDCWD, FilePath(key).c_str(), times, 0);
+  return true;
+}
+
+void RasterCache::WriteFile(std::string const& key, unsigned int size,
+                            Rasters const& rasters) {
+  if (!util::fs::DirectoryExists(directory_) &&
+      !util::fs::CreateDirectory(directory_)) {
+    util::log::Error() << "Failed creating \"" << directory_ << "\"\n";
+    directory_.clear();
+    return;
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.size = size;
+  header.key_length = key.length();
+  header.raster_count = kRasterCount;
+
+  size_t raster_bytes = size_t{size} * size * sizeof(DATA32);
+  std::string contents(reinterpret_cast<char const*>(&header), sizeof(header));
+  contents.append(key);
+  contents.resize(PixelsOffset(key.length()), '\0');
+
+  util::imlib2::ScopedCurrentImageRestorer restorer;
+  for (Imlib_Image image : {static_cast<Imlib_Image>(rasters.normal),
+                            static_cast<Imlib_Image>(rasters.hover),
+                            static_cast<Imlib_Image>(rasters.pressed)}) {
+    if (image == nullptr) {
+      return;
+    }
+    imlib_context_set_image(image);
+    if (imlib_image_get_width() != static_cast<int>(size) ||
+        imlib_image_get_height() != static_cast<int>(size)) {
+      return;
+    }
+    contents.append(
+        reinterpret_cast<char const*>(imlib_image_get_data_for_reading_only()),
+        raster_bytes);
+  }
+
+  std::string path = FilePath(key);
+  if (!util::fs::WriteFileAtomically(path, contents)) {
+    util::log::Error() << "Failed writing \"" << path << "\"\n";
+    return;
+  }
+
+  disk_bytes_ += contents.size();
+  if (disk_bytes_ > max_disk_bytes_) {
+    Prune();
+  }
+}
+
+std::ostream& operator<<(std::ostream& os, RasterCache::Stats const& stats) {
+  return os << "RasterCache::Stats{memory_hits: " << stats.memory_hits
+            << ", disk_hits: " << stats.disk_hits
+            << ", misses: " << stats.misses << "}";
+}
+
+}  // namespace raster_cache
+}  // namespace launcher
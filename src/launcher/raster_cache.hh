@@ -0,0 +1,104 @@
+#ifndef TINT3_LAUNCHER_RASTER_CACHE_HH
+#define TINT3_LAUNCHER_RASTER_CACHE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "util/imlib2.hh"
+#include "util/lru_cache.hh"
+
+namespace launcher {
+namespace raster_cache {
+
+// Identifies the rasters of a launcher icon: the source file, as it was when
+// last modified, and everything that affects scaling and color adjustment.
+struct Key {
+  std::string path;
+  int64_t mtime_sec = 0;
+  int64_t mtime_nsec = 0;
+  unsigned int size = 0;
+  // applied to all the rasters
+  util::imlib2::Asb asb;
+  // applied on top of asb for the hover and pressed rasters
+  util::imlib2::Asb hover_asb;
+  util::imlib2::Asb pressed_asb;
+};
+
+// Fills in the modification time of key->path. Returns false if the file
+// can't be accessed.
+bool UpdateModificationTime(Key* key);
+
+struct Rasters {
+  util::imlib2::Image normal;
+  util::imlib2::Image hover;
+  util::imlib2::Image pressed;
+};
+
+// Keeps the decoded, scaled and adjusted launcher icons around, so that they
+// aren't produced again on panel reinitialization or when switching back to
+// a previously used icon size.
+//
+// The most recently used rasters are kept in memory. If a directory is set,
+// they're also stored on disk, one file per key, as the raw ARGB data imlib2
+// works with; such files are memory mapped and copied straight into new
+// images, so that icon files don't need to be decoded again after a restart.
+// The least recently used files are removed once they take more than
+// max_disk_bytes in total.
+class RasterCache {
+ public:
+  struct Stats {
+    uint64_t memory_hits = 0;
+    uint64_t disk_hits = 0;
+    uint64_t misses = 0;
+  };
+
+  static constexpr size_t kDefaultCapacity = 64;
+  static constexpr uint64_t kDefaultMaxDiskBytes = 16 << 20;
+
+  explicit RasterCache(size_t capacity = kDefaultCapacity,
+                       uint64_t max_disk_bytes = kDefaultMaxDiskBytes);
+
+  RasterCache(RasterCache const&) = delete;
+  RasterCache& operator=(RasterCache const&) = delete;
+
+  // Sets where the rasters are stored on disk, pruning what's already there.
+  // Empty disables the disk cache.
+  void set_directory(std::string const& directory);
+
+  // Copies the rasters stored for the given key, returning false if there's
+  // none.
+  bool Find(Key const& key, Rasters* rasters);
+
+  // Stores the given rasters, which must all be key.size pixels wide and high.
+  void Insert(Key const& key, Rasters const& rasters);
+
+  // Drops the rasters kept in memory.
+  void Clear();
+
+  Stats const& stats() const;
+
+ private:
+  util::LruCache<std::string, Rasters> entries_;
+  std::string directory_;
+  uint64_t max_disk_bytes_;
+  // as of the last pruning, plus what was written since
+  uint64_t disk_bytes_ = 0;
+  Stats stats_;
+
+  std::string FilePath(std::string const& key) const;
+  void Prune();
+  bool ReadFile(std::string const& key, unsigned int size, Rasters* rasters);
+  void WriteFile(std::string const& key, unsigned int size,
+                 Rasters const& rasters);
+};
+
+std::ostream& operator<<(std::ostream& os, RasterCache::Stats const& stats);
+
+}  // namespace raster_cache
+}  // namespace launcher
+
+extern launcher::raster_cache::RasterCache launcher_raster_cache;
+
+#endif  // TINT3_LAUNCHER_RASTER_CACHE_HH
@@ -0,0 +1,141 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include "launcher/raster_cache.hh"
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+
+using launcher::raster_cache::Key;
+using launcher::raster_cache::RasterCache;
+using launcher::raster_cache::Rasters;
+
+namespace {
+
+constexpr char kIconPath[] =
+    "src/launcher/testdata/.icons/UnitTestTheme/16x16/apps/unit-test.png";
+
+util::imlib2::Image CreateFilledImage(int size, DATA32 color) {
+  Imlib_Image image = imlib_create_image(size, size);
+  imlib_context_set_image(image);
+  imlib_image_set_has_alpha(1);
+  DATA32* data = imlib_image_get_data();
+  for (int i = 0; i < size * size; ++i) {
+    data[i] = color;
+  }
+  imlib_image_put_back_data(data);
+  return util::imlib2::Image{image};
+}
+
+DATA32 FirstPixel(util::imlib2::Image const& image) {
+  imlib_context_set_image(image);
+  return imlib_image_get_data_for_reading_only()[0];
+}
+
+}  // namespace
+
+TEST_CASE("RasterCache") {
+  Key key;
+  key.path = kIconPath;
+  key.size = 4;
+  key.hover_asb = util::imlib2::Asb{100, 0, 10};
+  key.pressed_asb = util::imlib2::Asb{100, 0, -10};
+  REQUIRE(launcher::raster_cache::UpdateModificationTime(&key));
+
+  Rasters const rasters{CreateFilledImage(4, 0xff102030),
+                        CreateFilledImage(4, 0xff203040),
+                        CreateFilledImage(4, 0xff001020)};
+
+  SECTION("stored rasters are found in memory") {
+    RasterCache cache;
+    Rasters found;
+    REQUIRE_FALSE(cache.Find(key, &found));
+    cache.Insert(key, rasters);
+    REQUIRE(cache.Find(key, &found));
+    REQUIRE(FirstPixel(found.normal) == 0xff102030);
+    REQUIRE(FirstPixel(found.hover) == 0xff203040);
+    REQUIRE(FirstPixel(found.pressed) == 0xff001020);
+    REQUIRE(cache.stats().memory_hits == 1);
+    REQUIRE(cache.stats().misses == 1);
+  }
+
+  SECTION("any change to the key is a miss") {
+    RasterCache cache;
+    cache.Insert(key, rasters);
+
+    Rasters found;
+    Key other = key;
+    other.size = 8;
+    REQUIRE_FALSE(cache.Find(other, &found));
+    other = key;
+    other.mtime_sec += 1;
+    REQUIRE_FALSE(cache.Find(other, &found));
+    other = key;
+    other.hover_asb = util::imlib2::Asb{100, 0, 20};
+    REQUIRE_FALSE(cache.Find(other, &found));
+    REQUIRE(cache.stats().misses == 3);
+  }
+
+  SECTION("stored rasters survive a restart") {
+    TempDirectory temp;
+    {
+      RasterCache cache;
+      cache.set_directory(temp.path());
+      cache.Insert(key, rasters);
+    }
+
+    RasterCache cache;
+    cache.set_directory(temp.path());
+    Rasters found;
+    REQUIRE(cache.Find(key, &found));
+    REQUIRE(cache.stats().disk_hits == 1);
+    REQUIRE(FirstPixel(found.normal) == 0xff102030);
+    REQUIRE(FirstPixel(found.hover) == 0xff203040);
+    REQUIRE(FirstPixel(found.pressed) == 0xff001020);
+
+    // now it's kept in memory too
+    REQUIRE(cache.Find(key, &found));
+    REQUIRE(cache.stats().memory_hits == 1);
+
+    Key other = key;
+    other.mtime_nsec += 1;
+    REQUIRE_FALSE(cache.Find(other, &found));
+  }
+
+  SECTION("rasters of the wrong size aren't stored on disk") {
+    TempDirectory temp;
+    {
+      RasterCache cache;
+      cache.set_directory(temp.path());
+      Key other = key;
+      other.size = 8;
+      cache.Insert(other, rasters);
+    }
+
+    RasterCache cache;
+    cache.set_directory(temp.path());
+    Key other = key;
+    other.size = 8;
+    Rasters found;
+    REQUIRE_FALSE(cache.Find(other, &found));
+  }
+
+  SECTION("the least recently used files are pruned") {
+    TempDirectory temp;
+    Key other = key;
+    other.mtime_sec += 1;
+    {
+      // room for a single file
+      RasterCache cache{RasterCache::kDefaultCapacity, 512};
+      cache.set_directory(temp.path());
+      cache.Insert(key, rasters);
+      cache.Insert(other, rasters);
+    }
+
+    RasterCache cache;
+    cache.set_directory(temp.path());
+    Rasters found;
+    REQUIRE_FALSE(cache.Find(key, &found));
+    REQUIRE(cache.Find(other, &found));
+  }
+}
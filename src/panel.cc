@@ -27,6 +27,11 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "config.hh"
 #include "panel.hh"
@@ -49,7 +54,7 @@ bool task_dragged;
 Panel panel_config;
 PanelConfig new_panel_config;
 // panels (one panel per monitor)
-std::vector<Panel> panels;
+std::vector<std::unique_ptr<Panel>> panels;
 
 std::vector<Background> backgrounds;
 std::vector<Executor> executors;
@@ -96,16 +101,16 @@ void CleanupPanel() {
 
   CleanupTaskbar();
 
-  for (Panel& p : panels) {
-    p.FreeArea();
-    if (p.temp_pmap) {
-      XFreePixmap(server.dsp, p.temp_pmap);
+  for (auto& p : panels) {
+    p->FreeArea();
+    if (p->temp_pmap) {
+      XFreePixmap(server.dsp, p->temp_pmap);
     }
-    if (p.hidden_pixmap_) {
-      XFreePixmap(server.dsp, p.hidden_pixmap_);
+    if (p->hidden_pixmap_) {
+      XFreePixmap(server.dsp, p->hidden_pixmap_);
     }
-    if (p.main_win_) {
-      XDestroyWindow(server.dsp, p.main_win_);
+    if (p->main_win_) {
+      XDestroyWindow(server.dsp, p->main_win_);
     }
   }
 
@@ -115,6 +120,153 @@ void CleanupPanel() {
   gradients.clear();
 }
 
+namespace {
+
+// names of the monitor the panel is configured to be shown on, if it's not
+// shown on all of them, so that it can be found again when monitors change
+std::vector<std::string> panel_monitor_names;
+
+// Creates the window of a panel, with the visual and depth of the server.
+void CreatePanelWindow(Panel* p) {
+  {
+    // catch some events
+    XSetWindowAttributes attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.colormap = server.colormap;
+    attr.background_pixel = 0;
+    attr.border_pixel = 0;
+
+    unsigned long mask = CWEventMask | CWColormap | CWBackPixel | CWBorderPixel;
+    p->main_win_ = util::x11::CreateWindow(
+        server.root_window(), p->root_x_, p->root_y_, p->width_, p->height_, 0,
+        server.depth, InputOutput, server.visual, mask, &attr);
+  }
+
+  long event_mask =
+      ExposureMask | ButtonPressMask | ButtonReleaseMask | ButtonMotionMask;
+
+  if (p->g_task.tooltip_enabled ||
+      (launcher_enabled && launcher_tooltip_enabled)) {
+    event_mask |= PointerMotionMask | LeaveWindowMask;
+  }
+
+  if (p->autohide()) {
+    event_mask |= LeaveWindowMask | EnterWindowMask;
+  }
+
+  {
+    XSetWindowAttributes attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.event_mask = event_mask;
+    XChangeWindowAttributes(server.dsp, p->main_win_, CWEventMask, &attr);
+  }
+}
+
+// Sets up a panel created from panel_config, already in its place in panels,
+// and shows it. Returns the function that starts updating the batteries.
+std::function<void()> SetUpPanel(Panel* p, unsigned int index, Timer& timer) {
+  std::function<void()> maybe_update_batteries = [] {};
+
+  p->UseConfig(new_panel_config, index);
+
+  p->parent_ = p;
+  p->panel_ = p;
+  p->on_screen_ = true;
+  p->need_resize_ = true;
+  p->size_mode_ = SizeMode::kByLayout;
+  p->InitSizeAndPosition();
+
+  // add children according to panel_items
+  util::log::Debug() << "Setting panel items: "
+                     << new_panel_config.items_order << '\n';
+
+  for (char item : new_panel_config.items_order) {
+    if (item == 'L') {
+      Launcher::InitPanel(p);
+    }
+
+    if (item == 'T') {
+      Taskbar::InitPanel(p);
+    }
+
+#ifdef ENABLE_BATTERY
+
+    if (item == 'B') {
+      maybe_update_batteries = Battery::InitPanel(p, &timer);
+    }
+
+#endif
+
+    if (item == 'S' && p == panels.front().get()) {
+      // TODO : check systray is only on 1 panel
+      // at the moment only on panels[0] allowed
+      systray.SetParentPanel(p);
+      systray.set_should_refresh(true);
+    }
+
+    if (item == 'C') {
+      Clock::InitPanel(p);
+    }
+  }
+
+  p->SetItemsOrder();
+
+  CreatePanelWindow(p);
+  server.InitGC(p->main_win_);
+  p->SetProperties();
+  p->SetBackground();
+  XMapWindow(server.dsp, p->main_win_);
+
+  if (p->autohide()) {
+    p->AutohideTriggerHide(timer);
+  }
+  p->UpdateTaskbarVisibility();
+  return maybe_update_batteries;
+}
+
+// Frees a panel, whose tasks must have been moved to other panels already.
+void DestroyPanel(std::unique_ptr<Panel> p, Timer& timer) {
+  if (p->autohide_timeout_) {
+    timer.ClearInterval(p->autohide_timeout_);
+  }
+  for (Taskbar& tskbar : p->taskbars) {
+    tskbar.FreeArea();
+  }
+  p->launcher_.CleanupTheme();
+  p->FreeArea();
+  if (p->temp_pmap) {
+    XFreePixmap(server.dsp, p->temp_pmap);
+  }
+  if (p->hidden_pixmap_) {
+    XFreePixmap(server.dsp, p->hidden_pixmap_);
+  }
+  XDestroyWindow(server.dsp, p->main_win_);
+}
+
+// Returns the monitor the panel should be shown on, when it's not shown on all
+// of them.
+unsigned int FindPanelMonitor(std::vector<int> const& matches,
+                              unsigned int previous_monitor) {
+  if (!panel_monitor_names.empty()) {
+    for (unsigned int i = 0; i < server.monitor.size(); ++i) {
+      if (server.monitor[i].names == panel_monitor_names) {
+        return i;
+      }
+    }
+    // like at startup, fall back to the first monitor while it's missing
+    return 0;
+  }
+
+  for (unsigned int i = 0; i < matches.size(); ++i) {
+    if (matches[i] == static_cast<int>(previous_monitor)) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
 void InitPanel(Timer& timer) {
   if (new_panel_config.monitor != Panel::kAllMonitors &&
       new_panel_config.monitor > server.num_monitors - 1) {
@@ -124,6 +276,11 @@ void InitPanel(Timer& timer) {
     new_panel_config.monitor = 0;
   }
 
+  panel_monitor_names.clear();
+  if (new_panel_config.monitor != Panel::kAllMonitors) {
+    panel_monitor_names = server.monitor[new_panel_config.monitor].names;
+  }
+
   InitSystray(timer);
   InitLauncher();
   InitClock(timer);
@@ -138,105 +295,18 @@ void InitPanel(Timer& timer) {
     num_panels = 1;
   }
 
-  panels.resize(num_panels);
-  panels.shrink_to_fit();
-  std::fill(panels.begin(), panels.end(), panel_config);
+  panels.clear();
+  for (unsigned int i = 0; i < num_panels; ++i) {
+    panels.emplace_back(new Panel(panel_config));
+  }
 
   util::log::Debug() << "tint3: num_monitors " << server.num_monitors
                      << ", num_monitors used " << panels.size()
                      << ", num_desktops " << server.num_desktops() << '\n';
 
   std::function<void()> maybe_update_batteries = [] {};
-
   for (unsigned int i = 0; i < num_panels; ++i) {
-    Panel& p = panels[i];
-    p.UseConfig(new_panel_config, i);
-
-    p.parent_ = &p;
-    p.panel_ = &p;
-    p.on_screen_ = true;
-    p.need_resize_ = true;
-    p.size_mode_ = SizeMode::kByLayout;
-    p.InitSizeAndPosition();
-
-    // add children according to panel_items
-    util::log::Debug() << "Setting panel items: "
-                       << new_panel_config.items_order << '\n';
-
-    for (char item : new_panel_config.items_order) {
-      if (item == 'L') {
-        Launcher::InitPanel(&p);
-      }
-
-      if (item == 'T') {
-        Taskbar::InitPanel(&p);
-      }
-
-#ifdef ENABLE_BATTERY
-
-      if (item == 'B') {
-        maybe_update_batteries = Battery::InitPanel(&p, &timer);
-      }
-
-#endif
-
-      if (item == 'S' && i == 0) {
-        // TODO : check systray is only on 1 panel
-        // at the moment only on panels[0] allowed
-        systray.SetParentPanel(&p);
-        systray.set_should_refresh(true);
-      }
-
-      if (item == 'C') {
-        Clock::InitPanel(&p);
-      }
-    }
-
-    p.SetItemsOrder();
-
-    {
-      // catch some events
-      XSetWindowAttributes attr;
-      std::memset(&attr, 0, sizeof(attr));
-      attr.colormap = server.colormap;
-      attr.background_pixel = 0;
-      attr.border_pixel = 0;
-
-      unsigned long mask =
-          CWEventMask | CWColormap | CWBackPixel | CWBorderPixel;
-      p.main_win_ = util::x11::CreateWindow(
-          server.root_window(), p.root_x_, p.root_y_, p.width_, p.height_, 0,
-          server.depth, InputOutput, server.visual, mask, &attr);
-    }
-
-    long event_mask =
-        ExposureMask | ButtonPressMask | ButtonReleaseMask | ButtonMotionMask;
-
-    if (p.g_task.tooltip_enabled ||
-        (launcher_enabled && launcher_tooltip_enabled)) {
-      event_mask |= PointerMotionMask | LeaveWindowMask;
-    }
-
-    if (p.autohide()) {
-      event_mask |= LeaveWindowMask | EnterWindowMask;
-    }
-
-    {
-      XSetWindowAttributes attr;
-      std::memset(&attr, 0, sizeof(attr));
-      attr.event_mask = event_mask;
-      XChangeWindowAttributes(server.dsp, p.main_win_, CWEventMask, &attr);
-    }
-
-    server.InitGC(p.main_win_);
-    p.SetProperties();
-    p.SetBackground();
-    XMapWindow(server.dsp, p.main_win_);
-
-    if (p.autohide()) {
-      p.AutohideTriggerHide(timer);
-    }
-    p.UpdateTaskbarVisibility();
+    maybe_update_batteries = SetUpPanel(panels[i].get(), i, timer);
   }
 
   maybe_update_batteries();
@@ -315,6 +385,33 @@ void Panel::InitSizeAndPosition() {
   }
 }
 
+bool Panel::MoveToMonitor(unsigned int monitor) {
+  int root_x = root_x_, root_y = root_y_;
+  unsigned int width = width_, height = height_;
+
+  config_.monitor = monitor;
+  InitSizeAndPosition();
+  if ((config_.horizontal ? height_ : width_) !=
+      (config_.horizontal ? height : width)) {
+    return false;
+  }
+  if (root_x_ == root_x && root_y_ == root_y && width_ == width &&
+      height_ == height) {
+    return true;
+  }
+
+  XMoveResizeWindow(server.dsp, main_win_, root_x_, root_y_, width_, height_);
+  if (hidden_) {
+    AutohideHide();
+  }
+  UpdateSizeHints();
+
+  need_resize_ = true;
+  SetBackground();
+  panel_refresh = true;
+  return true;
+}
+
 bool Panel::Resize() {
   ResizeByLayout(0);
 
@@ -336,6 +433,7 @@ bool Panel::Resize() {
 void Panel::Render() {
   SizeByContent();
   SizeByLayout(0, 1);
+  PublishIconGeometries();
   Refresh();
 }
 
@@ -362,7 +460,7 @@ void Panel::SetItemsOrder() {
 
 #endif
 
-    if (item == 'S' && this == &panels.front()) {
+    if (item == 'S' && this == panels.front().get()) {
       // TODO : check systray is only on 1 panel
       // at the moment only on panels[0] allowed
       children_.push_back(&systray);
@@ -447,7 +545,16 @@ void Panel::SetProperties() {
                   PropModeReplace, (unsigned char*)&version, 1);
 
   UpdateNetWMStrut();
+  UpdateSizeHints();
 
+  // Set WM_CLASS
+  util::x11::ClientData<XClassHint> classhint(XAllocClassHint());
+  classhint->res_name = kClassHintName;
+  classhint->res_class = kClassHintClass;
+  XSetClassHint(server.dsp, main_win_, classhint.get());
+}
+
+void Panel::UpdateSizeHints() {
   // Fixed position and non-resizable window
   // Allow panel move and resize when tint3 reload config file
   int minwidth = autohide() ? hidden_width_ : width_;
@@ -459,12 +566,6 @@ void Panel::SetProperties() {
   size_hints.min_height = minheight;
   size_hints.max_height = height_;
   XSetWMNormalHints(server.dsp, main_win_, &size_hints);
-
-  // Set WM_CLASS
-  util::x11::ClientData<XClassHint> classhint(XAllocClassHint());
-  classhint->res_name = kClassHintName;
-  classhint->res_class = kClassHintClass;
-  XSetClassHint(server.dsp, main_win_, classhint.get());
 }
 
 void Panel::SetBackground() {
@@ -521,6 +622,10 @@ void Panel::SetBackground() {
     child->SetRedraw();
   }
 
+  if (systray.panel_ == this) {
+    systray.InvalidateBackground();
+  }
+
   // reset task/taskbar 'state_pix'
   for (unsigned int i = 0; i < num_desktops_; i++) {
     auto& tskbar = taskbars[i];
@@ -638,15 +743,163 @@ void Panel::UseConfig(PanelConfig const& cfg, unsigned int num_desktop) {
   height_ = cfg.height(cfg.horizontal ? monitor().height : monitor().width);
 }
 
+void Panel::UpdateMouseActions(MouseActionConfig const& mouse_actions) {
+  config_.mouse_actions = mouse_actions;
+}
+
 Panel* GetPanel(Window win) {
-  for (Panel& p : panels) {
-    if (p.main_win_ == win) {
-      return &p;
+  for (auto& p : panels) {
+    if (p->main_win_ == win) {
+      return p.get();
     }
   }
   return nullptr;
 }
 
+std::vector<int> MatchMonitors(std::vector<Monitor> const& previous,
+                               std::vector<Monitor> const& current) {
+  std::vector<int> matches(current.size(), -1);
+  std::vector<bool> matched(previous.size(), false);
+
+  auto match = [&](std::function<bool(unsigned int, unsigned int)> same) {
+    for (unsigned int i = 0; i < current.size(); ++i) {
+      for (unsigned int j = 0; j < previous.size() && matches[i] == -1; ++j) {
+        if (!matched[j] && same(i, j)) {
+          matches[i] = j;
+          matched[j] = true;
+        }
+      }
+    }
+  };
+  auto unnamed = [&](unsigned int i, unsigned int j) {
+    return current[i].names.empty() && previous[j].names.empty();
+  };
+
+  match([&](unsigned int i, unsigned int j) {
+    return !current[i].names.empty() && current[i].names == previous[j].names;
+  });
+  match([&](unsigned int i, unsigned int j) {
+    return unnamed(i, j) && current[i] == previous[j];
+  });
+  match([&](unsigned int i, unsigned int j) {
+    return unnamed(i, j) && i == j;
+  });
+  return matches;
+}
+
+bool UpdatePanelMonitors(Timer& timer, std::vector<Panel*>* new_panels) {
+  new_panels->clear();
+
+  std::vector<Monitor> previous = server.monitor;
+  GetMonitors();
+  if (server.monitor == previous) {
+    return false;
+  }
+
+  std::vector<int> matches = MatchMonitors(previous, server.monitor);
+  bool all_monitors = (new_panel_config.monitor == Panel::kAllMonitors);
+  if (!all_monitors) {
+    new_panel_config.monitor =
+        FindPanelMonitor(matches, new_panel_config.monitor);
+  }
+
+  // Panels whose monitor is still around are moved to its new place, the
+  // others are replaced by new ones.
+  std::vector<std::unique_ptr<Panel>> previous_panels;
+  previous_panels.swap(panels);
+  std::vector<unsigned int> created;
+  unsigned int num_panels = (all_monitors ? server.num_monitors : 1);
+  for (unsigned int i = 0; i < num_panels; ++i) {
+    unsigned int monitor = (all_monitors ? i : new_panel_config.monitor);
+    int previous_index = (all_monitors ? matches[i] : 0);
+    if (previous_index != -1 &&
+        previous_panels[previous_index]->MoveToMonitor(monitor)) {
+      panels.push_back(std::move(previous_panels[previous_index]));
+    } else {
+      panels.emplace_back(new Panel(panel_config));
+      created.push_back(i);
+    }
+  }
+
+  util::log::Debug() << "tint3: num_monitors " << server.num_monitors
+                     << ", " << created.size() << " new panels\n";
+
+  Panel* systray_panel = systray.panel_;
+  std::function<void()> maybe_update_batteries = [] {};
+  for (unsigned int i : created) {
+    maybe_update_batteries = SetUpPanel(panels[i].get(), i, timer);
+    new_panels->push_back(panels[i].get());
+  }
+
+  // the systray stays on the first panel, and takes its icons along
+  Panel* front = panels.front().get();
+  if (front != systray_panel &&
+      new_panel_config.items_order.find('S') != std::string::npos) {
+    if (systray.panel_ != front) {
+      systray.SetParentPanel(front);
+      systray.set_should_refresh(true);
+    }
+    systray.ReparentIcons();
+  }
+  for (auto& p : panels) {
+    p->SetItemsOrder();
+    p->need_resize_ = true;
+  }
+
+  TaskRefreshMonitors(timer);
+  for (auto& p : previous_panels) {
+    if (p) {
+      DestroyPanel(std::move(p), timer);
+    }
+  }
+  TaskRefreshTasklist(timer);
+  ActiveTask();
+  maybe_update_batteries();
+
+  // struts are relative to the edges of the screen, which may have moved even
+  // if the monitor of the panel didn't
+  for (auto& p : panels) {
+    p->UpdateNetWMStrut();
+  }
+  panel_refresh = true;
+  return true;
+}
+
+void UpdatePanelVisual() {
+  // the graphics context can only be used on drawables of the depth it was
+  // created for
+  if (server.gc) {
+    XFreeGC(server.dsp, server.gc);
+    server.gc = nullptr;
+  }
+
+  std::vector<Window> previous_windows;
+  for (auto& p : panels) {
+    previous_windows.push_back(p->main_win_);
+    CreatePanelWindow(p.get());
+    server.InitGC(p->main_win_);
+    p->SetProperties();
+    if (p->temp_pmap) {
+      XFreePixmap(server.dsp, p->temp_pmap);
+      p->temp_pmap = None;
+    }
+    p->SetBackground();
+    if (p->hidden()) {
+      p->AutohideHide();
+    }
+    XMapWindow(server.dsp, p->main_win_);
+  }
+
+  // the icons must leave the previous windows before these are destroyed
+  if (systray.panel_ != nullptr) {
+    systray.ReembedIcons();
+  }
+  for (Window win : previous_windows) {
+    XDestroyWindow(server.dsp, win);
+  }
+  panel_refresh = true;
+}
+
 #ifdef ENABLE_BATTERY
 Battery* Panel::battery() { return &battery_; }
 #endif  // ENABLE_BATTERY
@@ -728,12 +981,34 @@ MouseAction Panel::FindMouseActionForEvent(XEvent* event) {
   return MouseAction::kNone;
 }
 
+Taskbar* Panel::FindTaskbarToScroll(XEvent* event) {
+  XButtonEvent* e = &event->xbutton;
+  if (e->button != 4 && e->button != 5) {
+    return nullptr;
+  }
+
+  // explicitly configured scroll actions take precedence
+  if (FindMouseActionForEvent(event) != MouseAction::kNone) {
+    return nullptr;
+  }
+
+  Taskbar* tskbar = ClickTaskbar(e->x, e->y);
+  if (tskbar == nullptr || !tskbar->overflowing()) {
+    return nullptr;
+  }
+  return tskbar;
+}
+
 bool Panel::HandlesClick(XEvent* event) {
   if (!Area::HandlesClick(event)) {
     // don't even bother checking the rest if the click is outside the panel
     return false;
   }
 
+  if (FindTaskbarToScroll(event) != nullptr) {
+    return true;
+  }
+
   XButtonEvent* e = &event->xbutton;
   Task* task = ClickTask(e->x, e->y);
   if (task) {
@@ -770,6 +1045,10 @@ PanelLayer Panel::layer() const { return config_.layer; }
 
 TaskbarMode Panel::taskbar_mode() const { return config_.taskbar_mode; }
 
+TaskbarSortOrder Panel::taskbar_sort_order() const {
+  return config_.taskbar_sort_order;
+}
+
 PanelHorizontalPosition Panel::horizontal_position() const {
   return config_.horizontal_position;
 }
@@ -823,8 +1102,11 @@ bool Panel::AutohideShow() {
     }
   }
 
-  // ugly hack, because we actually only need to call XSetBackgroundPixmap
-  systray.set_should_refresh(true);
+  // the systray icons were mapped on top of the hidden pixmap, so they must be
+  // repainted on the full one
+  if (systray.panel_ == this) {
+    systray.InvalidateBackground();
+  }
   panel_refresh = true;
   return false;
 }
@@ -5,6 +5,7 @@
 #include <sys/time.h>
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -63,6 +64,7 @@ struct PanelConfig {
 
   PanelLayer layer = PanelLayer::kBottom;
   TaskbarMode taskbar_mode = TaskbarMode::kSingleDesktop;
+  TaskbarSortOrder taskbar_sort_order = TaskbarSortOrder::kNone;
 
   unsigned int monitor = 0;
 
@@ -99,6 +101,7 @@ struct PanelConfig {
   bool horizontal = true;
   bool wm_menu = false;
   int max_urgent_blinks = 14;
+  int title_update_interval = 100;
 };
 
 extern PanelConfig new_panel_config;
@@ -146,6 +149,9 @@ class Panel : public Area {
   bool ClickPadding(int x, int y);
 
   MouseAction FindMouseActionForEvent(XEvent* event);
+  // Returns the overflowing taskbar the given scroll wheel event should page
+  // through, or nullptr if the event is meant for something else.
+  Taskbar* FindTaskbarToScroll(XEvent* event);
   bool HandlesClick(XEvent* event) override;
 
   void Render();
@@ -153,12 +159,17 @@ class Panel : public Area {
 
   // TODO: this should be private
   void InitSizeAndPosition();
+  // Moves and resizes the panel to fit the given monitor, after the monitor
+  // layout changed. Returns false if the panel would get thicker or thinner,
+  // which its items can't follow without being recreated.
+  bool MoveToMonitor(unsigned int monitor);
 
   // draw background panel
   void SetBackground();
 
   void SetItemsOrder();
   void SetProperties();
+  void UpdateNetWMStrut();
 
   // show/hide taskbar according to current desktop
   void UpdateTaskbarVisibility();
@@ -172,6 +183,7 @@ class Panel : public Area {
 
   PanelLayer layer() const;
   TaskbarMode taskbar_mode() const;
+  TaskbarSortOrder taskbar_sort_order() const;
   PanelHorizontalPosition horizontal_position() const;
   PanelVerticalPosition vertical_position() const;
   Monitor const& monitor() const;
@@ -179,6 +191,7 @@ class Panel : public Area {
   bool window_manager_menu() const;
   int max_urgent_blinks() const;
   void UseConfig(PanelConfig const& cfg, unsigned int num_desktop);
+  void UpdateMouseActions(MouseActionConfig const& mouse_actions);
 
 #ifdef _TINT3_DEBUG
 
@@ -196,11 +209,12 @@ class Panel : public Area {
   Battery battery_;
 #endif  // ENABLE_BATTERY
 
-  void UpdateNetWMStrut();
+  void UpdateSizeHints();
 };
 
 extern Panel panel_config;
-extern std::vector<Panel> panels;
+// held by pointer, since their items point back at them
+extern std::vector<std::unique_ptr<Panel>> panels;
 
 // default global data
 void DefaultPanel();
@@ -215,4 +229,20 @@ void InitPanel(Timer& timer);
 // detect wich panel
 Panel* GetPanel(Window win);
 
+// Matches the monitors of two layouts: returns, for each of the current
+// monitors, the index of the same monitor in the previous layout, or -1 if it's
+// a new one. Monitors are recognized by the names of their outputs or, when
+// XRandR doesn't name them, by their geometry or their place in the layout.
+std::vector<int> MatchMonitors(std::vector<Monitor> const& previous,
+                               std::vector<Monitor> const& current);
+
+// Detects the monitors again, then creates, destroys, moves or resizes panels
+// to follow the changes, leaving the others alone. Returns false if nothing
+// changed; otherwise, fills in the panels that were created.
+bool UpdatePanelMonitors(Timer& timer, std::vector<Panel*>* new_panels);
+
+// Replaces the windows of the panels with ones using the visual and depth of
+// the server, after they changed because a compositor started or stopped.
+void UpdatePanelVisual();
+
 #endif  // TINT3_PANEL_HH
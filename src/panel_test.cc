@@ -2,6 +2,9 @@
 
 #include <X11/Xlib.h>
 
+#include <utility>
+#include <vector>
+
 #include "panel.hh"
 #include "server.hh"
 
@@ -232,3 +235,54 @@ TEST_CASE("HandlesClick_ClickTask") {
     REQUIRE(p.HandlesClick(&test_event));
   }
 }
+
+TEST_CASE("MatchMonitors") {
+  Monitor left = TestMonitor();
+  Monitor right = TestMonitor();
+  right.x = left.width;
+  right.names = {"right"};
+
+  std::vector<Monitor> previous{left, right};
+  std::vector<Monitor> current = previous;
+
+  SECTION("unchanged layout") {
+    REQUIRE(MatchMonitors(previous, current) == (std::vector<int>{0, 1}));
+  }
+
+  SECTION("resized monitor") {
+    current[1].width = 1280;
+    REQUIRE(MatchMonitors(previous, current) == (std::vector<int>{0, 1}));
+  }
+
+  SECTION("removed monitor") {
+    current.pop_back();
+    REQUIRE(MatchMonitors(previous, current) == (std::vector<int>{0}));
+    current = {right};
+    REQUIRE(MatchMonitors(previous, current) == (std::vector<int>{1}));
+  }
+
+  SECTION("added monitor") {
+    Monitor top = TestMonitor();
+    top.y = left.height;
+    top.names = {"top"};
+    current.insert(current.begin(), top);
+    REQUIRE(MatchMonitors(previous, current) == (std::vector<int>{-1, 0, 1}));
+  }
+
+  SECTION("reordered monitors") {
+    std::swap(current[0], current[1]);
+    REQUIRE(MatchMonitors(previous, current) == (std::vector<int>{1, 0}));
+  }
+
+  SECTION("unnamed monitors") {
+    previous[0].names.clear();
+    previous[1].names.clear();
+    current = {previous[1], previous[0]};
+    REQUIRE(MatchMonitors(previous, current) == (std::vector<int>{1, 0}));
+
+    // when resized, only their place in the layout is left
+    current = previous;
+    current[0].width = 1280;
+    REQUIRE(MatchMonitors(previous, current) == (std::vector<int>{0, 1}));
+  }
+}
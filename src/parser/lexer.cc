@@ -1,13 +1,12 @@
 #include "parser/lexer.hh"
 
-#include <regex>
+#include <cctype>
 #include <utility>
 
 namespace parser {
 namespace matcher {
 
-bool NewLine(std::string const& buffer, unsigned int* position,
-             std::string* output) {
+bool NewLine(absl::string_view buffer, unsigned int* position) {
   unsigned int begin = (*position);
   unsigned int end = begin;
   if (end < buffer.length() && buffer[end] == '\r') {
@@ -17,90 +16,163 @@ bool NewLine(std::string const& buffer, unsigned int* position,
     ++end;
   }
   (*position) = end;
-  output->assign(buffer, begin, end - begin);
-  return !output->empty();
+  return end != begin;
 }
 
-bool Whitespace(std::string const& buffer, unsigned int* position,
-                std::string* output) {
+bool Whitespace(absl::string_view buffer, unsigned int* position) {
   unsigned int begin = (*position);
   unsigned int end = begin;
   while (end < buffer.length() && isspace(buffer[end]) && buffer[end] != '\n') {
     ++end;
   }
   (*position) = end;
-  output->assign(buffer, begin, end - begin);
-  return !output->empty();
+  return end != begin;
 }
 
-bool Any(std::string const& buffer, unsigned int* position,
-         std::string* output) {
+bool Any(absl::string_view buffer, unsigned int* position) {
   if (*position >= buffer.length()) {
     return false;
   }
-  output->assign(buffer, (*position)++, 1);
+  ++(*position);
   return true;
 }
 
 }  // namespace matcher
 
-TokenMatcher::TokenMatcher(TokenMatcher const& other)
-    : matcher_(other.matcher_) {}
+namespace {
+
+// Adds the characters matched by the escape sequence "\c" to the given set.
+void AddEscapedCharacters(char c, std::bitset<256>* characters) {
+  std::bitset<256> escaped;
+  int (*predicate)(int) = nullptr;
+  switch (tolower(c)) {
+    case 's':
+      predicate = isspace;
+      break;
+    case 'd':
+      predicate = isdigit;
+      break;
+    case 'w':
+      predicate = [](int ch) { return (isalnum(ch) || ch == '_') ? 1 : 0; };
+      break;
+  }
 
-TokenMatcher::TokenMatcher(TokenMatcher&& other)
-    : matcher_(std::move(other.matcher_)) {}
+  if (predicate == nullptr) {
+    characters->set(static_cast<unsigned char>(c));
+    return;
+  }
+  for (int ch = 0; ch < 128; ++ch) {
+    escaped.set(ch, predicate(ch) != 0);
+  }
+  if (isupper(c)) {
+    escaped.flip();
+  }
+  (*characters) |= escaped;
+}
 
-TokenMatcher::TokenMatcher(MatcherCallback matcher) : matcher_(matcher) {}
+}  // namespace
 
-TokenMatcher::TokenMatcher(char c) : matcher_(MakeCharacterMatcher(c)) {}
+TokenMatcher::TokenMatcher(MatcherCallback* matcher) : callback_(matcher) {}
 
-TokenMatcher::TokenMatcher(const char* regexp)
-    : matcher_(MakeRegexpMatcher(regexp)) {}
+TokenMatcher::TokenMatcher(char c) : pattern_(1) {
+  pattern_[0].characters.set(static_cast<unsigned char>(c));
+  pattern_[0].optional = false;
+  pattern_[0].repeated = false;
+}
 
-TokenMatcher::TokenMatcher(std::string const& regexp)
-    : matcher_(MakeRegexpMatcher(regexp)) {}
+TokenMatcher::TokenMatcher(const char* pattern)
+    : pattern_(CompilePattern(pattern)) {}
 
-TokenMatcher& TokenMatcher::operator=(TokenMatcher other) {
-  std::swap(matcher_, other.matcher_);
-  return *this;
-}
+TokenMatcher::TokenMatcher(std::string const& pattern)
+    : pattern_(CompilePattern(pattern)) {}
 
-bool TokenMatcher::operator()(std::string const& buffer, unsigned int* position,
-                              std::string* output) const {
-  return matcher_(buffer, position, output);
-}
+bool TokenMatcher::operator()(absl::string_view buffer,
+                              unsigned int* position) const {
+  if (callback_ != nullptr) {
+    return callback_(buffer, position);
+  }
 
-TokenMatcher::MatcherFunction TokenMatcher::MakeCharacterMatcher(char c) {
-  return [c](std::string const& buffer, unsigned int* position,
-             std::string* output) -> bool {
-    if (buffer[*position] == c) {
-      output->assign(1, c);
-      (*position) += 1;
-      return true;
+  unsigned int end = (*position);
+  for (CharacterClass const& cc : pattern_) {
+    unsigned int begin = end;
+    while (end < buffer.length() &&
+           cc.characters[static_cast<unsigned char>(buffer[end])] &&
+           (cc.repeated || end == begin)) {
+      ++end;
+    }
+    if (end == begin && !cc.optional) {
+      return false;
     }
+  }
+  if (end == (*position)) {
     return false;
-  };
+  }
+  (*position) = end;
+  return true;
 }
 
-TokenMatcher::MatcherFunction TokenMatcher::MakeRegexpMatcher(
-    std::string const& pattern) {
-  std::regex regexp{pattern};
-  return [regexp](std::string const& buffer, unsigned int* position,
-                  std::string* output) -> bool {
-    std::string remainder{buffer, (*position)};
-    std::smatch match;
-    if (std::regex_search(remainder, match, regexp,
-                          std::regex_constants::match_continuous)) {
-      output->assign(match.str());
-      (*position) += match.length();
-      return true;
+std::vector<TokenMatcher::CharacterClass> TokenMatcher::CompilePattern(
+    absl::string_view pattern) {
+  std::vector<CharacterClass> result;
+
+  for (size_t i = 0; i < pattern.length(); ++i) {
+    CharacterClass cc;
+    cc.optional = false;
+    cc.repeated = false;
+
+    if (pattern[i] == '[') {
+      bool negated = (i + 1 < pattern.length() && pattern[i + 1] == '^');
+      if (negated) {
+        ++i;
+      }
+      // a ']' right after the opening bracket is taken literally
+      for (size_t first = ++i; i < pattern.length(); ++i) {
+        if (pattern[i] == ']' && i != first) {
+          break;
+        }
+        if (pattern[i] == '\\' && i + 1 < pattern.length()) {
+          AddEscapedCharacters(pattern[++i], &cc.characters);
+        } else if (i + 2 < pattern.length() && pattern[i + 1] == '-' &&
+                   pattern[i + 2] != ']') {
+          for (int ch = static_cast<unsigned char>(pattern[i]);
+               ch <= static_cast<unsigned char>(pattern[i + 2]); ++ch) {
+            cc.characters.set(ch);
+          }
+          i += 2;
+        } else {
+          cc.characters.set(static_cast<unsigned char>(pattern[i]));
+        }
+      }
+      if (negated) {
+        cc.characters.flip();
+      }
+    } else if (pattern[i] == '\\' && i + 1 < pattern.length()) {
+      AddEscapedCharacters(pattern[++i], &cc.characters);
+    } else if (pattern[i] == '.') {
+      cc.characters.set();
+      cc.characters.reset('\n');
+      cc.characters.reset('\r');
+    } else {
+      cc.characters.set(static_cast<unsigned char>(pattern[i]));
     }
-    return false;
-  };
+
+    if (i + 1 < pattern.length()) {
+      char quantifier = pattern[i + 1];
+      if (quantifier == '+' || quantifier == '*' || quantifier == '?') {
+        cc.optional = (quantifier != '+');
+        cc.repeated = (quantifier != '?');
+        ++i;
+      }
+    }
+
+    result.push_back(cc);
+  }
+
+  return result;
 }
 
 Token::Token(Symbol symbol, unsigned int begin, unsigned int end,
-             std::string const& match)
+             absl::string_view match)
     : symbol(symbol), begin(begin), end(end), match(match) {}
 
 Lexer::Lexer(Lexer const& other)
@@ -117,7 +189,7 @@ Lexer& Lexer::operator=(Lexer other) {
   return *this;
 }
 
-bool Lexer::ProcessContents(std::string const& buffer, Result* result) const {
+bool Lexer::ProcessContents(absl::string_view buffer, Result* result) const {
   unsigned int length = buffer.length();
   unsigned int i = 0;
 
@@ -125,15 +197,12 @@ bool Lexer::ProcessContents(std::string const& buffer, Result* result) const {
 
   while (i < length) {
     bool found_match = false;
-    for (auto& pair : matcher_to_symbol_) {
-      TokenMatcher matcher = pair.first;
-      Symbol symbol = pair.second;
-
-      std::string output;
+    for (auto const& pair : matcher_to_symbol_) {
       unsigned int begin = i;
-      if (matcher(buffer, &i, &output)) {
+      if (pair.first(buffer, &i)) {
         found_match = true;
-        result->push_back(Token(symbol, begin, i, output));
+        result->push_back(
+            Token(pair.second, begin, i, buffer.substr(begin, i - begin)));
         break;
       }
     }
@@ -142,7 +211,7 @@ bool Lexer::ProcessContents(std::string const& buffer, Result* result) const {
     }
   }
 
-  result->push_back(Token(kEOF, length, length, ""));
+  result->push_back(Token(kEOF, length, length, buffer.substr(length)));
   return true;
 }
 
@@ -1,29 +1,32 @@
 #ifndef TINT3_PARSER_LEXER_HH
 #define TINT3_PARSER_LEXER_HH
 
-#include <functional>
+#include <bitset>
 #include <initializer_list>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+
 namespace parser {
 namespace matcher {
 
+// Matchers look for a token at the given position of the buffer. On success,
+// they advance the position past the end of the token, which must not be
+// empty, and return true; on failure, they leave the position untouched.
+
 // NewLine matcher accepts DOS-style (<CR><LF>), Macintosh-style (<CR>) or
 // Unix-style (<LF>) newline sequences.
-bool NewLine(std::string const& buffer, unsigned int* position,
-             std::string* output);
+bool NewLine(absl::string_view buffer, unsigned int* position);
 
 // Whitespace matcher accepts all the characters accepted by isspace(), except
 // for the newline character (which is usually to be accepted as a separate
 // token, and not swallowed by this matcher).
-bool Whitespace(std::string const& buffer, unsigned int* position,
-                std::string* output);
+bool Whitespace(absl::string_view buffer, unsigned int* position);
 
 // Any matcher accepts any single character.
-bool Any(std::string const& buffer, unsigned int* position,
-         std::string* output);
+bool Any(absl::string_view buffer, unsigned int* position);
 
 }  // namespace matcher
 
@@ -33,37 +36,54 @@ static constexpr Symbol kEOF = 0;
 
 class TokenMatcher {
  public:
-  using MatcherCallback = bool(std::string const&, unsigned int*, std::string*);
-  using MatcherFunction = std::function<MatcherCallback>;
+  using MatcherCallback = bool(absl::string_view, unsigned int*);
 
-  TokenMatcher(TokenMatcher const& other);
-  TokenMatcher(TokenMatcher&& other);
+  TokenMatcher(TokenMatcher const& other) = default;
+  TokenMatcher(TokenMatcher&& other) = default;
 
-  TokenMatcher(MatcherCallback matcher);
+  TokenMatcher(MatcherCallback* matcher);
   TokenMatcher(char c);
-  TokenMatcher(const char* regexp);
-  TokenMatcher(std::string const& regexp);
-
-  TokenMatcher& operator=(TokenMatcher other);
-  bool operator()(std::string const& buffer, unsigned int* position,
-                  std::string* output) const;
+  // Patterns use a subset of the regular expression syntax, and are compiled
+  // once into a sequence of character classes:
+  //  - "[a-z_]" and "[^a-z_]" match (or don't match) the listed characters;
+  //  - "\s", "\d" and "\w", and their negated uppercase versions, match the
+  //    usual classes of characters; any other escaped character matches
+  //    itself;
+  //  - "." matches anything but a newline;
+  //  - "+", "*" and "?" repeat the previous class;
+  //  - anything else, including the characters with a special meaning in full
+  //    regular expressions such as "(" or "|", matches itself.
+  // Repetitions are greedy, and never backtrack: "[a-z]+a" matches nothing.
+  TokenMatcher(const char* pattern);
+  TokenMatcher(std::string const& pattern);
+
+  TokenMatcher& operator=(TokenMatcher const& other) = default;
+  TokenMatcher& operator=(TokenMatcher&& other) = default;
+  bool operator()(absl::string_view buffer, unsigned int* position) const;
 
  private:
-  MatcherFunction matcher_;
+  struct CharacterClass {
+    std::bitset<256> characters;
+    bool optional;
+    bool repeated;
+  };
+
+  MatcherCallback* callback_ = nullptr;
+  std::vector<CharacterClass> pattern_;
 
-  static MatcherFunction MakeCharacterMatcher(char c);
-  static MatcherFunction MakeRegexpMatcher(std::string const& pattern);
+  static std::vector<CharacterClass> CompilePattern(absl::string_view pattern);
 };
 
+// Tokens refer to the buffer they were read from, which must outlive them.
 class Token {
  public:
   Symbol const symbol;
   unsigned int const begin;
   unsigned int const end;
-  std::string const match;
+  absl::string_view const match;
 
   Token(Symbol symbol, unsigned int begin, unsigned int end,
-        std::string const& match);
+        absl::string_view match);
 };
 
 class Lexer {
@@ -77,7 +97,7 @@ class Lexer {
 
   Lexer& operator=(Lexer other);
 
-  bool ProcessContents(std::string const& buffer, Result* result) const;
+  bool ProcessContents(absl::string_view buffer, Result* result) const;
 
  private:
   // This could be an std::map for brevity, but we want to preserve the
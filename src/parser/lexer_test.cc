@@ -6,42 +6,33 @@ TEST_CASE("matchers::NewLine", "NewLine matcher is sane") {
   SECTION("<CR><LF>") {
     std::string cr_lf{"\r\n"};
     unsigned int position = 0;
-    std::string output;
-    REQUIRE(parser::matcher::NewLine(cr_lf, &position, &output));
+    REQUIRE(parser::matcher::NewLine(cr_lf, &position));
     REQUIRE(position == cr_lf.length());
-    REQUIRE(output == cr_lf);
   }
 
   SECTION("<CR>") {
     std::string cr{"\r"};
     unsigned int position = 0;
-    std::string output;
-    REQUIRE(parser::matcher::NewLine(cr, &position, &output));
+    REQUIRE(parser::matcher::NewLine(cr, &position));
     REQUIRE(position == cr.length());
-    REQUIRE(output == cr);
   }
 
   SECTION("<LF>") {
     std::string lf{"\n"};
     unsigned int position = 0;
-    std::string output;
-    REQUIRE(parser::matcher::NewLine(lf, &position, &output));
+    REQUIRE(parser::matcher::NewLine(lf, &position));
     REQUIRE(position == lf.length());
-    REQUIRE(output == lf);
   }
 
   SECTION("<LF><CR><LF>") {
     std::string mixed{"\n\r\n"};
     unsigned int position = 0;
-    std::string output;
     // First pass: consume only '\n'
-    REQUIRE(parser::matcher::NewLine(mixed, &position, &output));
+    REQUIRE(parser::matcher::NewLine(mixed, &position));
     REQUIRE(position == 1);
-    REQUIRE(output == "\n");
     // Second pass: consume '\r\n'
-    REQUIRE(parser::matcher::NewLine(mixed, &position, &output));
+    REQUIRE(parser::matcher::NewLine(mixed, &position));
     REQUIRE(position == mixed.length());
-    REQUIRE(output == "\r\n");
   }
 }
 
@@ -49,39 +40,31 @@ TEST_CASE("matchers::Whitespace", "Whitespace matcher is sane") {
   SECTION("All spaces") {
     std::string all_spaces{"   "};
     unsigned int position = 0;
-    std::string output;
-    REQUIRE(parser::matcher::Whitespace(all_spaces, &position, &output));
+    REQUIRE(parser::matcher::Whitespace(all_spaces, &position));
     REQUIRE(position == all_spaces.length());
-    REQUIRE(output == all_spaces);
   }
 
   SECTION("Mixed spaces") {
     std::string mixed_spaces{" \t \r"};
     unsigned int position = 0;
-    std::string output;
-    REQUIRE(parser::matcher::Whitespace(mixed_spaces, &position, &output));
+    REQUIRE(parser::matcher::Whitespace(mixed_spaces, &position));
     REQUIRE(position == mixed_spaces.length());
-    REQUIRE(output == mixed_spaces);
   }
 
   SECTION("Leading spaces") {
     std::string test_string{"   test"};
     unsigned int position = 0;
-    std::string output;
-    REQUIRE(parser::matcher::Whitespace(test_string, &position, &output));
+    REQUIRE(parser::matcher::Whitespace(test_string, &position));
     REQUIRE(position == 3);
-    REQUIRE(output == "   ");
   }
 
   SECTION("Trailing spaces") {
     std::string test_string{"test   "};
     unsigned int position = 0;
-    std::string output;
     // Since we're starting from position=0, there's no whitespace that matches
     // at that position, so we expect to fail here.
-    REQUIRE_FALSE(parser::matcher::Whitespace(test_string, &position, &output));
+    REQUIRE_FALSE(parser::matcher::Whitespace(test_string, &position));
     REQUIRE(position == 0);
-    REQUIRE(output.empty());
   }
 }
 
@@ -89,19 +72,15 @@ TEST_CASE("matchers::Any", "Whitespace matcher is sane") {
   SECTION("Inside a string") {
     std::string test_string{"test"};
     unsigned int position = 0;
-    std::string output;
-    REQUIRE(parser::matcher::Any(test_string, &position, &output));
+    REQUIRE(parser::matcher::Any(test_string, &position));
     REQUIRE(position == 1);
-    REQUIRE(output == "t");
   }
 
   SECTION("At the end of a string") {
     std::string test_string{"test"};
     unsigned int position = test_string.length();
-    std::string output;
-    REQUIRE_FALSE(parser::matcher::Any(test_string, &position, &output));
+    REQUIRE_FALSE(parser::matcher::Any(test_string, &position));
     REQUIRE(position == test_string.length());
-    REQUIRE(output.empty());
   }
 }
 
@@ -158,4 +137,60 @@ key=value
   for (unsigned int i = 0; i < kExpectedSequenceLength; ++i) {
     REQUIRE(result[i].symbol == kExpectedSequence[i]);
   }
+
+  // tokens point into the original buffer
+  REQUIRE(result[8].match == "section");
+  REQUIRE(result[8].match.data() == kTestContents + result[8].begin);
+  REQUIRE(result.back().match.empty());
+}
+
+TEST_CASE("TokenMatcher", "Patterns are compiled into character classes") {
+  auto match = [](parser::TokenMatcher const& matcher,
+                  std::string const& buffer) -> std::string {
+    unsigned int position = 0;
+    if (!matcher(buffer, &position)) {
+      return "<no match>";
+    }
+    return buffer.substr(0, position);
+  };
+
+  SECTION("single characters") {
+    REQUIRE(match('#', "# comment") == "#");
+    REQUIRE(match('#', "comment") == "<no match>");
+  }
+
+  SECTION("literals") {
+    REQUIRE(match("@import", "@import file") == "@import");
+    REQUIRE(match("@import", "@impo") == "<no match>");
+  }
+
+  SECTION("character classes") {
+    REQUIRE(match("[A-Za-z0-9-]+", "key-1=value") == "key-1");
+    REQUIRE(match("[^=]+", "key-1=value") == "key-1");
+    REQUIRE(match("[a-]", "-") == "-");
+    REQUIRE(match("[]]", "]") == "]");
+  }
+
+  SECTION("escapes") {
+    REQUIRE(match("\\s+", " \t\nx") == " \t\n");
+    REQUIRE(match("\\d*x", "123x") == "123x");
+    REQUIRE(match("\\d*x", "x") == "x");
+    REQUIRE(match("\\w+", "snake_case-1") == "snake_case");
+    REQUIRE(match("\\S+", "abc def") == "abc");
+    REQUIRE(match("\\.", ".") == ".");
+  }
+
+  SECTION("quantifiers") {
+    REQUIRE(match("ab?c", "ac") == "ac");
+    REQUIRE(match("ab?c", "abc") == "abc");
+    REQUIRE(match("ab?c", "abbc") == "<no match>");
+    REQUIRE(match(".*", "line\nnext") == "line");
+    // repetitions never backtrack
+    REQUIRE(match("[a-z]+a", "banana") == "<no match>");
+  }
+
+  SECTION("empty matches are failures") {
+    REQUIRE(match("x*", "abc") == "<no match>");
+    REQUIRE(match("", "abc") == "<no match>");
+  }
 }
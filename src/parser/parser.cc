@@ -1,3 +1,5 @@
+#include <utility>
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 
@@ -7,7 +9,8 @@
 
 namespace parser {
 
-TokenList::TokenList(Lexer::Result tokens) : tokens_(tokens), current_(0) {}
+TokenList::TokenList(Lexer::Result tokens)
+    : tokens_(std::move(tokens)), current_(0) {}
 
 Token const& TokenList::Current() const { return tokens_.at(current_); }
 
@@ -70,7 +73,7 @@ bool Parser::Parse(std::string const& buffer) const {
     return false;
   }
 
-  TokenList tokens{result};
+  TokenList tokens{std::move(result)};
   if (!(*parser_entry_fn_)(&tokens)) {
     return false;
   }
@@ -40,7 +40,7 @@ class SimpleArithmeticParser : public parser::ParseCallback {
 
   bool Expression(parser::TokenList* tokens) {
     if (tokens->Current().symbol == kNumber) {
-      op_stack_.emplace(std::stoul(tokens->Current().match));
+      op_stack_.emplace(std::stoul(std::string(tokens->Current().match)));
       tokens->Next();
     } else if (tokens->Current().symbol == kLeftBracket) {
       if (!WrappedExpression(tokens)) {
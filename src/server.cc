@@ -184,6 +184,15 @@ void Server::GetRootPixmap() {
   XChangeGC(dsp, gc, mask, &gcv);
 }
 
+bool operator==(Monitor const& lhs, Monitor const& rhs) {
+  return lhs.x == rhs.x && lhs.y == rhs.y && lhs.width == rhs.width &&
+         lhs.height == rhs.height && lhs.names == rhs.names;
+}
+
+bool operator!=(Monitor const& lhs, Monitor const& rhs) {
+  return !(lhs == rhs);
+}
+
 bool MonitorIncludes(Monitor const& m1, Monitor const& m2) {
   bool inside_x = (m1.x >= m2.x) && ((m1.x + m1.width) <= (m2.x + m2.width));
   bool inside_y = (m1.y >= m2.y) && ((m1.y + m1.height) <= (m2.y + m2.height));
@@ -198,6 +207,8 @@ void GetMonitors() {
       std::unique_ptr<XRRScreenResources, decltype(&XRRFreeScreenResources)>;
 
   int num_monitors = 0;
+  // monitors may be queried again after a change in the layout
+  server.num_monitors = 0;
 
   if (XineramaIsActive(server.dsp)) {
     util::x11::ClientData<XineramaScreenInfo> info(
@@ -365,16 +376,26 @@ void Server::InitGC(Window win) {
   }
 }
 
-void Server::InitVisual() {
+bool Server::InitVisual() {
   // check composite manager
   composite_manager = XGetSelectionOwner(dsp, atoms_["_NET_WM_CM_SCREEN"]);
 
   Visual* xvi_visual = util::x11::GetTrueColorVisual(dsp, screen);
-  if (xvi_visual && composite_manager != None) {
+  bool real_transparency = (xvi_visual && composite_manager != None);
+  if (real_transparency) {
     XSetWindowAttributes attrs;
     attrs.event_mask = StructureNotifyMask;
     XChangeWindowAttributes(dsp, composite_manager, CWEventMask, &attrs);
+  }
+
+  // Nothing to do if, e.g., one compositor was replaced by another.
+  Visual* new_visual =
+      real_transparency ? xvi_visual : DefaultVisual(dsp, screen);
+  if (visual == new_visual && colormap != None) {
+    return false;
+  }
 
+  if (real_transparency) {
     depth = 32;
     colormap =
         util::x11::Colormap::Create(dsp, root_window_, xvi_visual, AllocNone);
@@ -387,6 +408,7 @@ void Server::InitVisual() {
     visual = DefaultVisual(dsp, screen);
     std::cout << "Real transparency: off, depth: " << depth << '\n';
   }
+  return true;
 }
 
 void Server::InitX11() {
@@ -22,6 +22,11 @@ struct Monitor {
   std::vector<std::string> names;
 };
 
+// Monitors are equal if they have the same geometry and outputs, regardless of
+// the CRTC they are driven by.
+bool operator==(Monitor const& lhs, Monitor const& rhs);
+bool operator!=(Monitor const& lhs, Monitor const& rhs);
+
 class Server {
  public:
   Display* dsp = nullptr;
@@ -50,7 +55,9 @@ class Server {
   void InitGC(Window win);
   void InitAtoms();
   void InitDesktops();
-  void InitVisual();
+  // Picks the visual, depth and colormap for tint3's windows according to
+  // whether a compositor is running. Returns true if they changed.
+  bool InitVisual();
   void InitX11();
 
   util::x11::Pixmap CreatePixmap(unsigned int width, unsigned int height) const;
@@ -68,6 +75,19 @@ class Server {
   template <typename T>
   util::x11::ClientData<T> GetProperty(Window win, Atom at, Atom type,
                                        int* num_results) {
+    return GetPropertyRange<T>(win, at, type, 0, 0x7fffffff, num_results,
+                               nullptr);
+  }
+
+  // Fetches only part of a property: offset and length are expressed in
+  // 32 bit units, as for XGetWindowProperty. If bytes_after is not null, it
+  // receives the number of bytes left in the property after the returned
+  // range.
+  template <typename T>
+  util::x11::ClientData<T> GetPropertyRange(Window win, Atom at, Atom type,
+                                            long offset, long length,
+                                            int* num_results,
+                                            unsigned long* bytes_after) {
     if (!win) {
       return util::x11::ClientData<T>(nullptr);
     }
@@ -77,15 +97,19 @@ class Server {
     unsigned long nitems_ret = 0;
     unsigned long bafter_ret = 0;
     unsigned char* prop_value = nullptr;
-    int result =
-        XGetWindowProperty(dsp, win, at, 0, 0x7fffffff, False, type, &type_ret,
-                           &format_ret, &nitems_ret, &bafter_ret, &prop_value);
+    int result = XGetWindowProperty(dsp, win, at, offset, length, False, type,
+                                    &type_ret, &format_ret, &nitems_ret,
+                                    &bafter_ret, &prop_value);
 
     // Send back resultcount
     if (num_results != nullptr) {
       (*num_results) = static_cast<int>(nitems_ret);
     }
 
+    if (bytes_after != nullptr) {
+      (*bytes_after) = (result == Success) ? bafter_ret : 0;
+    }
+
     if (result == Success && prop_value != nullptr) {
       return util::x11::ClientData<T>(prop_value);
     }
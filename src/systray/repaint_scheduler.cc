@@ -0,0 +1,157 @@
+#include "systray/repaint_scheduler.hh"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// icons changing sooner than this after a repaint are considered animated
+const absl::Duration kBusyGap = absl::Milliseconds(100);
+// after this long without changes, an icon is considered static again
+const absl::Duration kQuietGap = absl::Seconds(1);
+// bounds of the interval between repaints of busy icons
+const absl::Duration kMinBackoff = absl::Milliseconds(25);
+const absl::Duration kMaxBackoff = absl::Seconds(1);
+
+}  // namespace
+
+RepaintScheduler::RepaintScheduler(Timer& timer,
+                                   unsigned int frames_per_second,
+                                   Callback callback)
+    : timer_(timer),
+      frames_per_second_(frames_per_second),
+      callback_(std::move(callback)),
+      frame_tokens_(frames_per_second),
+      last_refill_(timer.Now()) {}
+
+RepaintScheduler::~RepaintScheduler() {
+  if (batch_timeout_) {
+    timer_.ClearInterval(batch_timeout_);
+  }
+}
+
+void RepaintScheduler::Request(Window win) {
+  absl::Time now = timer_.Now();
+  IconState& icon = icons_[win];
+  ++icon.stats.requests;
+
+  if (icon.pending) {
+    // the pending repaint will pick up this change too
+    return;
+  }
+
+  // Icons are only reported as damaged again once they have been repainted,
+  // so the time between requests mostly reflects our own pace: how soon the
+  // icon changes after its last repaint is what tells whether it's busy.
+  absl::Duration since_render = now - icon.last_render;
+  absl::Duration& backoff = icon.stats.backoff;
+  if (since_render < kBusyGap) {
+    backoff = std::min(std::max(backoff * 2, kMinBackoff), kMaxBackoff);
+  } else if (since_render >= kQuietGap) {
+    backoff = absl::ZeroDuration();
+  } else {
+    backoff /= 2;
+    if (backoff < kMinBackoff) {
+      backoff = absl::ZeroDuration();
+    }
+  }
+
+  icon.pending = true;
+  icon.due = std::max(now, icon.last_render + backoff);
+  ScheduleBatch(icon.due);
+}
+
+void RepaintScheduler::Forget(Window win) { icons_.erase(win); }
+
+RepaintScheduler::Stats const* RepaintScheduler::stats(Window win) const {
+  auto it = icons_.find(win);
+  if (it == icons_.end()) {
+    return nullptr;
+  }
+  return &it->second.stats;
+}
+
+uint64_t RepaintScheduler::batches() const { return batches_; }
+
+void RepaintScheduler::RefillTokens(absl::Time now) {
+  double elapsed = absl::ToDoubleSeconds(now - last_refill_);
+  frame_tokens_ = std::min<double>(
+      frames_per_second_, frame_tokens_ + elapsed * frames_per_second_);
+  last_refill_ = now;
+}
+
+void RepaintScheduler::RunBatch() {
+  batch_timeout_.reset();
+  batch_time_ = absl::InfiniteFuture();
+  ++batches_;
+
+  absl::Time now = timer_.Now();
+  RefillTokens(now);
+
+  std::vector<std::pair<absl::Time, Window>> due_icons;
+  for (auto const& entry : icons_) {
+    if (entry.second.pending && entry.second.due <= now) {
+      due_icons.push_back(std::make_pair(entry.second.due, entry.first));
+    }
+  }
+  std::sort(due_icons.begin(), due_icons.end());
+
+  for (auto const& due_icon : due_icons) {
+    if (frames_per_second_ != 0 && frame_tokens_ < 1.0) {
+      break;
+    }
+
+    // an earlier repaint may have removed this icon
+    auto it = icons_.find(due_icon.second);
+    if (it == icons_.end() || !it->second.pending) {
+      continue;
+    }
+
+    it->second.pending = false;
+    it->second.last_render = now;
+    ++it->second.stats.renders;
+    frame_tokens_ -= 1.0;
+    callback_(due_icon.second);
+  }
+
+  // whatever didn't fit in the budget goes into a later batch
+  absl::Time next = absl::InfiniteFuture();
+  for (auto const& entry : icons_) {
+    if (entry.second.pending) {
+      next = std::min(next, entry.second.due);
+    }
+  }
+  if (next == absl::InfiniteFuture()) {
+    return;
+  }
+  if (frames_per_second_ != 0 && frame_tokens_ < 1.0) {
+    absl::Duration until_next_frame =
+        absl::Seconds((1.0 - frame_tokens_) / frames_per_second_);
+    next = std::max(next, now + until_next_frame);
+  }
+  ScheduleBatch(next);
+}
+
+void RepaintScheduler::ScheduleBatch(absl::Time when) {
+  if (batch_timeout_) {
+    if (batch_time_ <= when) {
+      return;
+    }
+    timer_.ClearInterval(batch_timeout_);
+  }
+
+  batch_time_ = when;
+  absl::Duration delay = std::max(when - timer_.Now(), absl::ZeroDuration());
+  batch_timeout_ = timer_.SetTimeout(delay, [this]() -> bool {
+    RunBatch();
+    return false;
+  });
+}
+
+std::ostream& operator<<(std::ostream& os,
+                         RepaintScheduler::Stats const& stats) {
+  return os << "RepaintScheduler::Stats{requests: " << stats.requests
+            << ", renders: " << stats.renders << ", backoff: " << stats.backoff
+            << "}";
+}
@@ -0,0 +1,82 @@
+#ifndef TINT3_SYSTRAY_REPAINT_SCHEDULER_HH
+#define TINT3_SYSTRAY_REPAINT_SCHEDULER_HH
+
+#include <X11/Xlib.h>
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <unordered_map>
+
+#include "absl/time/time.h"
+
+#include "util/timer.hh"
+
+// Decides when systray icons get repainted.
+//
+// Icons that change once in a while are repainted in the next batch, but the
+// ones that keep changing (network monitors, CPU graphs, ...) back off to
+// longer and longer intervals between repaints, up to one second, and come
+// back to instant repaints as they calm down. On top of that, the total
+// number of repaints per second is capped by a frame budget.
+//
+// All the repaints that are due are done in a single batch, from one timer.
+class RepaintScheduler {
+ public:
+  using Callback = std::function<void(Window)>;
+
+  struct Stats {
+    // repaints requested
+    uint64_t requests = 0;
+    // repaints done, the difference was merged into later ones
+    uint64_t renders = 0;
+    // current minimum interval between repaints
+    absl::Duration backoff = absl::ZeroDuration();
+  };
+
+  RepaintScheduler(Timer& timer, unsigned int frames_per_second,
+                   Callback callback);
+  ~RepaintScheduler();
+
+  RepaintScheduler(RepaintScheduler const&) = delete;
+  RepaintScheduler& operator=(RepaintScheduler const&) = delete;
+
+  // Signals that the given icon needs to be repainted.
+  void Request(Window win);
+
+  // Drops any state associated with the given icon, including a pending
+  // repaint. Must be called when the icon goes away.
+  void Forget(Window win);
+
+  // Returns nullptr if the icon is unknown.
+  Stats const* stats(Window win) const;
+  uint64_t batches() const;
+
+ private:
+  struct IconState {
+    absl::Time last_render = absl::InfinitePast();
+    absl::Time due = absl::InfiniteFuture();
+    bool pending = false;
+    Stats stats;
+  };
+
+  Timer& timer_;
+  unsigned int frames_per_second_;
+  Callback callback_;
+  std::unordered_map<Window, IconState> icons_;
+  // token bucket enforcing the frame budget
+  double frame_tokens_;
+  absl::Time last_refill_;
+  Interval::Id batch_timeout_;
+  absl::Time batch_time_ = absl::InfiniteFuture();
+  uint64_t batches_ = 0;
+
+  void RefillTokens(absl::Time now);
+  void RunBatch();
+  void ScheduleBatch(absl::Time when);
+};
+
+std::ostream& operator<<(std::ostream& os,
+                         RepaintScheduler::Stats const& stats);
+
+#endif  // TINT3_SYSTRAY_REPAINT_SCHEDULER_HH
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include "systray/repaint_scheduler.hh"
+#include "util/timer.hh"
+#include "util/timer_test_utils.hh"
+
+TEST_CASE("RepaintScheduler", "Repaints are batched and throttled") {
+  FakeClock fake_clock{0};
+  Timer timer{[&]() { return fake_clock.Now(); }};
+  std::vector<Window> renders;
+  RepaintScheduler scheduler{timer, 10,
+                             [&](Window win) { renders.push_back(win); }};
+
+  SECTION("static icons are repainted in the next batch") {
+    scheduler.Request(1);
+    scheduler.Request(2);
+    REQUIRE(renders.empty());
+
+    timer.ProcessExpiredIntervals();
+    REQUIRE(renders.size() == 2);
+    REQUIRE(scheduler.batches() == 1);
+    REQUIRE(scheduler.stats(1)->backoff == absl::ZeroDuration());
+    REQUIRE_FALSE(timer.GetNextInterval());
+  }
+
+  SECTION("requests before the batch are merged") {
+    scheduler.Request(1);
+    scheduler.Request(1);
+    timer.ProcessExpiredIntervals();
+    REQUIRE(renders == (std::vector<Window>{1}));
+    REQUIRE(scheduler.stats(1)->requests == 2);
+    REQUIRE(scheduler.stats(1)->renders == 1);
+  }
+
+  SECTION("busy icons back off, and recover once quiet") {
+    // An icon changing every 10 ms: as with XDamageReportNonEmpty, a new
+    // request only comes after the previous one was repainted.
+    bool damaged = false;
+    for (int i = 0; i < 500; ++i) {
+      if (!damaged) {
+        scheduler.Request(1);
+        damaged = true;
+      }
+      fake_clock.AdvanceBy(absl::Milliseconds(10));
+      size_t count = renders.size();
+      timer.ProcessExpiredIntervals();
+      if (renders.size() != count) {
+        damaged = false;
+      }
+    }
+    // 5 seconds of animation at 100 frames per second
+    REQUIRE(scheduler.stats(1)->backoff == absl::Seconds(1));
+    REQUIRE(renders.size() < 20);
+
+    // the last change gets repainted, then the icon stays still
+    fake_clock.AdvanceBy(absl::Seconds(1));
+    timer.ProcessExpiredIntervals();
+    fake_clock.AdvanceBy(absl::Seconds(2));
+    size_t count = renders.size();
+    scheduler.Request(1);
+    REQUIRE(scheduler.stats(1)->backoff == absl::ZeroDuration());
+    timer.ProcessExpiredIntervals();
+    REQUIRE(renders.size() == count + 1);
+  }
+
+  SECTION("icons calming down back off less") {
+    scheduler.Request(1);
+    timer.ProcessExpiredIntervals();
+    for (int i = 0; i < 3; ++i) {
+      scheduler.Request(1);
+      fake_clock.AdvanceBy(absl::Seconds(1));
+      timer.ProcessExpiredIntervals();
+    }
+    absl::Duration backoff = scheduler.stats(1)->backoff;
+    REQUIRE(backoff > absl::ZeroDuration());
+
+    // changes coming 500 ms after each repaint
+    fake_clock.AdvanceBy(absl::Milliseconds(500));
+    scheduler.Request(1);
+    REQUIRE(scheduler.stats(1)->backoff == backoff / 2);
+  }
+
+  SECTION("the frame budget is shared by all icons") {
+    for (Window win = 1; win <= 15; ++win) {
+      scheduler.Request(win);
+    }
+    timer.ProcessExpiredIntervals();
+    REQUIRE(renders.size() == 10);
+
+    // the rest is done as soon as the budget allows
+    auto next = timer.GetNextInterval();
+    REQUIRE(next);
+    fake_clock.AdvanceBy(absl::Seconds(1));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(renders.size() == 15);
+  }
+
+  SECTION("forgotten icons aren't repainted") {
+    scheduler.Request(1);
+    scheduler.Forget(1);
+    timer.ProcessExpiredIntervals();
+    REQUIRE(renders.empty());
+    REQUIRE(scheduler.stats(1) == nullptr);
+  }
+}
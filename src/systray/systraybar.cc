@@ -23,12 +23,14 @@
 #include <X11/Xatom.h>
 #include <X11/Xutil.h>
 #include <X11/extensions/Xcomposite.h>
+#include <X11/extensions/Xfixes.h>
 #include <X11/extensions/Xrender.h>
 
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 #include "absl/strings/ascii.h"
 #include "absl/time/time.h"
@@ -54,6 +56,13 @@ Systraybar systray;
 bool systray_enabled;
 int systray_max_icon_size;
 
+namespace {
+
+// upper bound on the number of icon repaints per second, over all icons
+const unsigned int kSystrayFrameBudget = 30;
+
+}  // namespace
+
 // background pixmap if we render ourselves the icons
 static Pixmap render_background;
 
@@ -117,6 +126,38 @@ void Systraybar::SetParentPanel(Panel* panel) {
   }
 
   set_should_refresh(false);
+  InvalidateBackground();
+}
+
+void Systraybar::ReparentIcons() {
+  for (TrayWindow* traywin : list_icons_) {
+    XReparentWindow(server.dsp, traywin->tray_id, panel_->main_win_,
+                    traywin->x, traywin->y);
+  }
+  need_resize_ = true;
+  InvalidateBackground();
+  panel_refresh = true;
+}
+
+void Systraybar::InvalidateBackground() {
+  background_invalid_ = true;
+  need_redraw_ = true;
+}
+
+void Systraybar::Draw() {
+  util::Rect rect{panel_x_, panel_y_, width_, height_};
+  if (pix_ != None && !background_invalid_ && rect == background_rect_ &&
+      mouse_state() == background_mouse_state_) {
+    // the background looks the same as before: keep the current pixmap, which
+    // also has the icons on it
+    return;
+  }
+
+  background_invalid_ = false;
+  background_rect_ = rect;
+  background_mouse_state_ = mouse_state();
+  ++background_serial_;
+  Area::Draw();
 }
 
 void Systraybar::DrawForeground(cairo_t* /* c */) {
@@ -249,6 +290,30 @@ Window GetSystemTrayOwner() {
   return XGetSelectionOwner(server.dsp, server.atom("_NET_SYSTEM_TRAY_SCREEN"));
 }
 
+// Tells the icons which visual to use for their windows.
+void SetSystemTrayVisual() {
+  VisualID vid = XVisualIDFromVisual(server.visual);
+  XChangeProperty(server.dsp, net_sel_win,
+                  server.atom("_NET_SYSTEM_TRAY_VISUAL"), XA_VISUALID, 32,
+                  PropModeReplace, (unsigned char*)&vid, 1);
+}
+
+void SendEmbeddedNotify(Window id, Window parent_window) {
+  XEvent e;
+  e.xclient.type = ClientMessage;
+  e.xclient.serial = 0;
+  e.xclient.send_event = True;
+  e.xclient.message_type = server.atom("_XEMBED");
+  e.xclient.window = id;
+  e.xclient.format = 32;
+  e.xclient.data.l[0] = CurrentTime;
+  e.xclient.data.l[1] = XEMBED_EMBEDDED_NOTIFY;
+  e.xclient.data.l[2] = 0;
+  e.xclient.data.l[3] = parent_window;
+  e.xclient.data.l[4] = 0;
+  XSendEvent(server.dsp, id, False, 0xFFFFFF, &e);
+}
+
 }  // namespace
 
 void Systraybar::StartNet(Timer& timer) {
@@ -289,10 +354,7 @@ void Systraybar::StartNet(Timer& timer) {
                   server.atom("_NET_SYSTEM_TRAY_ORIENTATION"), XA_CARDINAL, 32,
                   PropModeReplace, &orient, 1);
 
-  VisualID vid = XVisualIDFromVisual(server.visual);
-  XChangeProperty(server.dsp, net_sel_win,
-                  server.atom("_NET_SYSTEM_TRAY_VISUAL"), XA_VISUALID, 32,
-                  PropModeReplace, (unsigned char*)&vid, 1);
+  SetSystemTrayVisual();
 
   XSetSelectionOwner(server.dsp, server.atom("_NET_SYSTEM_TRAY_SCREEN"),
                      net_sel_win, CurrentTime);
@@ -364,14 +426,7 @@ bool CompareTrayWindows(TrayWindow const* traywin_a,
                                              : (name_a < name_b);
 }
 
-bool Systraybar::AddIcon(Window id) {
-  error = false;
-  XWindowAttributes attr;
-
-  if (XGetWindowAttributes(server.dsp, id, &attr) == False) {
-    return false;
-  }
-
+Window Systraybar::CreateIconWindow(XWindowAttributes const& attr) {
   unsigned long mask = 0;
   XSetWindowAttributes set_attr;
   Visual* visual = server.visual;
@@ -387,9 +442,20 @@ bool Systraybar::AddIcon(Window id) {
     mask = CWBackPixmap;
   }
 
-  Window parent_window =
-      util::x11::CreateWindow(panel_->main_win_, 0, 0, 30, 30, 0, attr.depth,
-                              InputOutput, visual, mask, &set_attr);
+  return util::x11::CreateWindow(panel_->main_win_, 0, 0, 30, 30, 0,
+                                 attr.depth, InputOutput, visual, mask,
+                                 &set_attr);
+}
+
+bool Systraybar::AddIcon(Window id) {
+  error = false;
+  XWindowAttributes attr;
+
+  if (XGetWindowAttributes(server.dsp, id, &attr) == False) {
+    return false;
+  }
+
+  Window parent_window = CreateIconWindow(attr);
 
   {
     error = false;
@@ -427,21 +493,7 @@ bool Systraybar::AddIcon(Window id) {
     }
   }
 
-  {
-    XEvent e;
-    e.xclient.type = ClientMessage;
-    e.xclient.serial = 0;
-    e.xclient.send_event = True;
-    e.xclient.message_type = server.atom("_XEMBED");
-    e.xclient.window = id;
-    e.xclient.format = 32;
-    e.xclient.data.l[0] = CurrentTime;
-    e.xclient.data.l[1] = XEMBED_EMBEDDED_NOTIFY;
-    e.xclient.data.l[2] = 0;
-    e.xclient.data.l[3] = parent_window;
-    e.xclient.data.l[4] = 0;
-    XSendEvent(server.dsp, id, False, 0xFFFFFF, &e);
-  }
+  SendEmbeddedNotify(id, parent_window);
 
   auto traywin = new TrayWindow(&server, parent_window, id);
   traywin->hide = false;
@@ -453,7 +505,7 @@ bool Systraybar::AddIcon(Window id) {
   }
 
   if (sort == 3) {
-    list_icons_.push_front(traywin);
+    list_icons_.insert(list_icons_.begin(), traywin);
   } else if (sort == 2) {
     list_icons_.push_back(traywin);
   } else {
@@ -461,10 +513,12 @@ bool Systraybar::AddIcon(Window id) {
                                CompareTrayWindows);
     list_icons_.insert(it, traywin);
   }
+  icons_by_window_[traywin->child_id] = traywin;
+  icons_by_window_[traywin->tray_id] = traywin;
 
   if (server.real_transparency() || needs_true_color()) {
     traywin->damage =
-        XDamageCreate(server.dsp, traywin->tray_id, XDamageReportRawRectangles);
+        XDamageCreate(server.dsp, traywin->tray_id, XDamageReportNonEmpty);
     XCompositeRedirectWindow(server.dsp, traywin->tray_id,
                              CompositeRedirectManual);
   }
@@ -484,32 +538,188 @@ bool Systraybar::AddIcon(Window id) {
   return true;
 }
 
-TrayWindow* Systraybar::FindTrayWindow(Window window_id) {
-  for (TrayWindow* traywin : list_icons_) {
-    if (traywin->child_id == window_id) {
-      return traywin;
+void Systraybar::ReembedIcons() {
+  if (net_sel_win != None) {
+    SetSystemTrayVisual();
+  }
+
+  for (auto it = list_icons_.begin(); it != list_icons_.end();) {
+    TrayWindow* traywin = *it;
+    XWindowAttributes attr;
+    if (XGetWindowAttributes(server.dsp, traywin->child_id, &attr) == False) {
+      it = list_icons_.erase(it);
+      RemoveIconInternal(traywin);
+      continue;
+    }
+
+    Window parent_window = CreateIconWindow(attr);
+    if (traywin->damage != None) {
+      XDamageDestroy(server.dsp, traywin->damage);
+      traywin->damage = None;
     }
+
+    {
+      error = false;
+      util::x11::ScopedErrorHandler error_handler(WindowErrorHandler);
+      // moving the icon unmaps it, which mustn't be taken for it going away
+      XSelectInput(server.dsp, traywin->child_id, NoEventMask);
+      XReparentWindow(server.dsp, traywin->child_id, parent_window, 0, 0);
+      XSelectInput(server.dsp, traywin->child_id, StructureNotifyMask);
+      XSync(server.dsp, False);
+    }
+
+    icons_by_window_.erase(traywin->tray_id);
+    XDestroyWindow(server.dsp, traywin->tray_id);
+    traywin->tray_id = parent_window;
+    icons_by_window_[traywin->tray_id] = traywin;
+
+    if (error) {
+      util::log::Error() << "tint3: can't embed icon " << traywin->child_id
+                         << " again\n";
+      it = list_icons_.erase(it);
+      RemoveIconInternal(traywin);
+      continue;
+    }
+
+    SendEmbeddedNotify(traywin->child_id, parent_window);
+    if (server.real_transparency() || needs_true_color()) {
+      traywin->damage =
+          XDamageCreate(server.dsp, traywin->tray_id, XDamageReportNonEmpty);
+      XCompositeRedirectWindow(server.dsp, traywin->tray_id,
+                               CompositeRedirectManual);
+    }
+
+    traywin->full_render = true;
+    XMoveResizeWindow(server.dsp, traywin->tray_id, traywin->x, traywin->y,
+                      traywin->width, traywin->height);
+    if (!traywin->hide) {
+      XMapWindow(server.dsp, traywin->child_id);
+    }
+    if (!traywin->hide && !panel_->hidden()) {
+      XMapRaised(server.dsp, traywin->tray_id);
+    }
+    ++it;
+  }
+
+  if (VisibleIcons() == 0) {
+    Hide();
   }
-  return nullptr;
+  need_resize_ = true;
+  InvalidateBackground();
+  panel_refresh = true;
+}
+
+TrayWindow* Systraybar::FindTrayWindow(Window window_id) {
+  auto it = icons_by_window_.find(window_id);
+  if (it == icons_by_window_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+bool Systraybar::IconBackgroundChanged(TrayWindow const* traywin) const {
+  util::Rect rect{traywin->x, traywin->y,
+                  static_cast<unsigned int>(traywin->width),
+                  static_cast<unsigned int>(traywin->height)};
+  return traywin->background_serial != background_serial_ ||
+         !(traywin->background_rect == rect);
 }
 
 void Systraybar::RefreshIcons(Timer& timer) {
   for (auto& traywin : list_icons_) {
-    if (!traywin->hide) {
-      RenderIcon(traywin, timer);
+    if (traywin->hide || !IconBackgroundChanged(traywin)) {
+      continue;
     }
+
+    traywin->background_rect =
+        util::Rect{traywin->x, traywin->y,
+                   static_cast<unsigned int>(traywin->width),
+                   static_cast<unsigned int>(traywin->height)};
+    traywin->background_serial = background_serial_;
+    RenderIcon(traywin, timer);
   }
 }
 
 namespace {
 
+// Returns the parts of the icon that changed since the last rendering, in icon
+// coordinates, and resets the damage. That's the whole icon if a full
+// rendering was requested.
+std::vector<XRectangle> TakeDamagedRects(TrayWindow* traywin) {
+  XRectangle whole_icon{0, 0, static_cast<unsigned short>(traywin->width),
+                        static_cast<unsigned short>(traywin->height)};
+  std::vector<XRectangle> rects;
+
+  if (traywin->damage) {
+    XserverRegion parts = XFixesCreateRegion(server.dsp, nullptr, 0);
+    XDamageSubtract(server.dsp, traywin->damage, None, parts);
+
+    if (!traywin->full_render) {
+      int count = 0;
+      util::x11::ClientData<XRectangle> data{
+          XFixesFetchRegion(server.dsp, parts, &count)};
+      for (int i = 0; data && i < count; ++i) {
+        XRectangle r = data.get()[i];
+        // the damage is tracked on the parent window, which can't be smaller
+        // than the icon but may be larger for a moment while resizing
+        int right = std::min(r.x + r.width, traywin->width);
+        int bottom = std::min(r.y + r.height, traywin->height);
+        if (r.x >= 0 && r.y >= 0 && right > r.x && bottom > r.y) {
+          r.width = static_cast<unsigned short>(right - r.x);
+          r.height = static_cast<unsigned short>(bottom - r.y);
+          rects.push_back(r);
+        }
+      }
+    }
+
+    XFixesDestroyRegion(server.dsp, parts);
+  }
+
+  traywin->full_render = false;
+  if (rects.empty()) {
+    rects.push_back(whole_icon);
+  }
+  return rects;
+}
+
+// Composites a 32 bit icon straight onto the systray, entirely on the X
+// server. Only the given rectangles are touched.
+void SystrayCompositeIcon(TrayWindow* traywin,
+                          std::vector<XRectangle> const& rects) {
+  Panel* panel = systray.panel_;
+  int x = traywin->x - systray.panel_x_;
+  int y = traywin->y - systray.panel_y_;
+
+  for (XRectangle const& r : rects) {
+    XCopyArea(server.dsp, render_background, systray.pix_, server.gc, x + r.x,
+              y + r.y, r.width, r.height, x + r.x, y + r.y);
+  }
+
+  Picture pict_image = XRenderCreatePicture(
+      server.dsp, traywin->child_id,
+      XRenderFindStandardFormat(server.dsp, PictStandardARGB32), 0, 0);
+  Picture pict_drawable = XRenderCreatePicture(
+      server.dsp, systray.pix_,
+      XRenderFindVisualFormat(server.dsp, server.visual), 0, 0);
+  XRenderSetPictureClipRectangles(server.dsp, pict_drawable, x, y,
+                                  rects.data(), rects.size());
+  XRenderComposite(server.dsp, PictOpOver, pict_image, None, pict_drawable, 0,
+                   0, 0, 0, x, y, traywin->width, traywin->height);
+  XRenderFreePicture(server.dsp, pict_image);
+  XRenderFreePicture(server.dsp, pict_drawable);
+
+  for (XRectangle const& r : rects) {
+    XCopyArea(server.dsp, systray.pix_, panel->main_win_, server.gc, x + r.x,
+              y + r.y, r.width, r.height, traywin->x + r.x, traywin->y + r.y);
+  }
+  XFlush(server.dsp);
+}
+
 void SystrayRenderIconNow(TrayWindow* traywin, Timer& timer) {
   // we end up in this function only in real transparency mode or if
   // systray_task_asb != 100 0 0
   // we made also sure, that we always have a 32 bit visual, i.e. we can safely
   // create 32 bit pixmaps here
-  traywin->render_timeout.reset();
-
   if (traywin->width == 0 || traywin->height == 0) {
     // reschedule rendering since the geometry information has not yet been
     // processed (can happen on slow cpu)
@@ -517,6 +727,18 @@ void SystrayRenderIconNow(TrayWindow* traywin, Timer& timer) {
     return;
   }
 
+  std::vector<XRectangle> rects = TakeDamagedRects(traywin);
+
+  // icons with an alpha channel only need to be blended on the background,
+  // which XRender does without any round trip through client memory
+  if (traywin->depth == 32 && !systray.needs_true_color()) {
+    SystrayCompositeIcon(traywin, rects);
+    return;
+  }
+
+  // Otherwise the icon is processed on the CPU, which needs all of its
+  // pixels: 24 bit icons get a mask based on their top left pixel.
+
   // good systray icons support 32 bit depth, but some icons are still 24 bit.
   // We create a heuristic mask for these icons, i.e. we get the rgb value in
   // the top left corner, and
@@ -592,26 +814,34 @@ void SystrayRenderIconNow(TrayWindow* traywin, Timer& timer) {
   imlib_context_set_visual(server.visual);
   imlib_context_set_colormap(server.colormap);
 
-  if (traywin->damage) {
-    XDamageSubtract(server.dsp, traywin->damage, None, None);
-  }
-
   XFlush(server.dsp);
 }
 
 }  // namespace
 
 void Systraybar::RenderIcon(TrayWindow* traywin, Timer& timer) {
+  traywin->full_render = true;
+  ScheduleRender(traywin, timer);
+}
+
+void Systraybar::RenderDamage(TrayWindow* traywin, Timer& timer) {
+  ScheduleRender(traywin, timer);
+}
+
+void Systraybar::ScheduleRender(TrayWindow* traywin, Timer& timer) {
   if (server.real_transparency() || needs_true_color()) {
-    // wine tray icons update whenever mouse is over them, so we limit the
-    // updates to 50 ms
-    if (!traywin->render_timeout) {
-      traywin->render_timeout =
-          timer.SetTimeout(absl::Milliseconds(50), [traywin, &timer]() -> bool {
-            SystrayRenderIconNow(traywin, timer);
-            return true;
-          });
+    // wine tray icons update whenever mouse is over them, and some icons
+    // animate continuously, so repaints are paced by the scheduler
+    if (!repaint_scheduler_) {
+      repaint_scheduler_.reset(new RepaintScheduler{
+          timer, kSystrayFrameBudget, [this, &timer](Window win) {
+            TrayWindow* traywin = FindTrayWindow(win);
+            if (traywin != nullptr) {
+              SystrayRenderIconNow(traywin, timer);
+            }
+          }});
     }
+    repaint_scheduler_->Request(traywin->child_id);
   } else {
     // comment by andreas: I'm still not sure, what exactly we need to do
     // here... Somehow trayicons which do not
@@ -628,16 +858,25 @@ void Systraybar::RenderIcon(TrayWindow* traywin, Timer& timer) {
   }
 }
 
-void Systraybar::RemoveIconInternal(TrayWindow* traywin, Timer& timer) {
-  if (traywin->render_timeout) {
-    timer.ClearInterval(traywin->render_timeout);
+void Systraybar::RemoveIconInternal(TrayWindow* traywin) {
+  icons_by_window_.erase(traywin->child_id);
+  icons_by_window_.erase(traywin->tray_id);
+
+  if (repaint_scheduler_) {
+    RepaintScheduler::Stats const* stats =
+        repaint_scheduler_->stats(traywin->child_id);
+    if (stats != nullptr) {
+      util::log::Debug() << "systray: icon " << traywin->child_id
+                         << " removed, " << *stats << '\n';
+    }
+    repaint_scheduler_->Forget(traywin->child_id);
   }
   delete traywin;
 }
 
 void Systraybar::RemoveIcon(TrayWindow* traywin, Timer& timer) {
   erase(list_icons_, traywin);
-  RemoveIconInternal(traywin, timer);
+  RemoveIconInternal(traywin);
 
   if (VisibleIcons() == 0) {
     Hide();
@@ -648,9 +887,11 @@ void Systraybar::RemoveIcon(TrayWindow* traywin, Timer& timer) {
 
 void Systraybar::RemoveAllIcons(Timer& timer) {
   for (auto& traywin : list_icons_) {
-    RemoveIconInternal(traywin, timer);
+    RemoveIconInternal(traywin);
   }
   list_icons_.clear();
+  // the timer may not outlive a restart
+  repaint_scheduler_.reset();
 }
 
 void Systraybar::Clear(Timer& timer) {
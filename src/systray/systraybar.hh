@@ -3,11 +3,15 @@
 
 #include <X11/extensions/Xdamage.h>
 
-#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
+#include "systray/repaint_scheduler.hh"
 #include "systray/tray_window.hh"
 #include "util/area.hh"
 #include "util/common.hh"
+#include "util/geometry.hh"
 #include "util/timer.hh"
 
 // XEMBED messages
@@ -16,7 +20,7 @@
 #define XEMBED_MAPPED (1 << 0)
 
 class Systraybar : public Area {
-  void RemoveIconInternal(TrayWindow* traywin, Timer& timer);
+  void RemoveIconInternal(TrayWindow* traywin);
 
  public:
   int sort;
@@ -28,16 +32,33 @@ class Systraybar : public Area {
   void set_should_refresh(bool should_refresh);
 
   void SetParentPanel(Panel* panel);
-
+  // Moves the icons already embedded into the window of the panel the systray
+  // is on, after it changed.
+  void ReparentIcons();
+  // Embeds the icons again into windows using the visual and depth of the
+  // server, after they changed. The panel window must have been replaced
+  // already.
+  void ReembedIcons();
+
+  void Draw() override;
   void DrawForeground(cairo_t*) override;
   void OnChangeLayout() override;
   bool Resize() override;
 
   size_t VisibleIcons() const;
   bool AddIcon(Window id);
+  // Looks up an icon by either its own window or the one tint3 embeds it in.
   TrayWindow* FindTrayWindow(Window window_id);
+  // Renders again the icons whose background changed since they were last
+  // rendered.
   void RefreshIcons(Timer& timer);
+  // Signals that the panel background behind the systray changed, so the icons
+  // must be rendered again even if the systray didn't move.
+  void InvalidateBackground();
   void RenderIcon(TrayWindow* traywin, Timer& timer);
+  // Like RenderIcon(), but only repaints the parts of the icon reported as
+  // damaged since the last rendering, if possible.
+  void RenderDamage(TrayWindow* traywin, Timer& timer);
   void RemoveIcon(TrayWindow* traywin, Timer& timer);
   void RemoveAllIcons(Timer& timer);
   void Clear(Timer& timer);
@@ -56,7 +77,24 @@ class Systraybar : public Area {
 
  private:
   bool should_refresh_;
-  std::list<TrayWindow*> list_icons_;
+  // what the systray background was last drawn for; as long as none of it
+  // changes the pixmap, and the icons rendered on it, are kept as they are
+  bool background_invalid_ = true;
+  util::Rect background_rect_{0, 0, 0, 0};
+  MouseState background_mouse_state_ = MouseState::kMouseNormal;
+  // bumped whenever the background is drawn again
+  unsigned int background_serial_ = 1;
+
+  // Creates the window an icon is embedded into, on the panel window.
+  Window CreateIconWindow(XWindowAttributes const& attr);
+  bool IconBackgroundChanged(TrayWindow const* traywin) const;
+  void ScheduleRender(TrayWindow* traywin, Timer& timer);
+  // in display order
+  std::vector<TrayWindow*> list_icons_;
+  // indexes list_icons_ by both child_id and tray_id
+  std::unordered_map<Window, TrayWindow*> icons_by_window_;
+  // paces the repaints done in real transparency mode, created on first use
+  std::unique_ptr<RepaintScheduler> repaint_scheduler_;
 };
 
 // net_sel_win != None when protocol started
@@ -13,6 +13,9 @@ TrayWindow::TrayWindow(Server* server, Window tray_id, Window child_id)
       hide(false),
       depth(0),
       damage(0),
+      full_render(true),
+      background_rect(0, 0, 0, 0),
+      background_serial(0),
       server_(server) {}
 
 TrayWindow::~TrayWindow() {
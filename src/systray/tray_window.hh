@@ -4,7 +4,7 @@
 #include <X11/Xlib.h>
 #include <X11/extensions/Xdamage.h>
 
-#include "util/timer.hh"
+#include "util/geometry.hh"
 
 // forward declaration
 class Server;
@@ -23,7 +23,13 @@ class TrayWindow {
   bool hide;
   int depth;
   Damage damage;
-  Interval::Id render_timeout;
+  // set when the next rendering must cover the whole icon, rather than just
+  // the damaged parts
+  bool full_render;
+  // where the icon was and which systray background it was on the last time
+  // it was rendered, to skip repaints when neither changed
+  util::Rect background_rect;
+  unsigned int background_serial;
 
  private:
   Server* server_;
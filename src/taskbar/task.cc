@@ -27,10 +27,13 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <iterator>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "absl/time/time.h"
@@ -40,6 +43,7 @@
 #include "taskbar/task.hh"
 #include "taskbar/taskbar.hh"
 #include "tooltip/tooltip.hh"
+#include "util/argb.hh"
 #include "util/collection.hh"
 #include "util/common.hh"
 #include "util/log.hh"
@@ -64,10 +68,25 @@ unsigned int GetMonitor(Window win) {
   return monitor;
 }
 
+// Identifies the most recent icon decoding request for each window, so that
+// results that have been superseded, or whose window went away in the
+// meantime, can be discarded.
+std::unordered_map<Window, unsigned long> pending_icons;
+unsigned long last_icon_request = 0;
+
+// incremented for each window that gets added to the taskbar
+unsigned long last_creation_order = 0;
+
+// _NET_WM_ICON_GEOMETRY values as x, y, width and height: the last ones set on
+// each window, and the ones waiting for PublishIconGeometries()
+using IconGeometry = std::array<long, 4>;
+std::unordered_map<Window, IconGeometry> published_icon_geometry;
+std::unordered_map<Window, IconGeometry> pending_icon_geometry;
+
 }  // namespace
 
-Interval::Id urgent_timeout;
 std::list<Task*> urgent_list;
+UrgentBlinker* task_urgent_blinker = nullptr;
 
 Global_task::Global_task() {
   for (int i = 0; i < kTaskStateCount; ++i) {
@@ -86,6 +105,39 @@ Task& Task::SetTooltipEnabled(bool is_enabled) {
   return (*this);
 }
 
+Task* AddTaskCopy(Task const& tsk, Taskbar& tskbar, Timer& timer) {
+  Panel* panel = tskbar.panel_;
+  Task* new_tsk = new Task{timer};
+
+  // TODO: nuke this from planet Earth ASAP - horrible hack to mimick the
+  // original memcpy() call
+  new_tsk->CloneArea(panel->g_task);
+
+  new_tsk->parent_ = &tskbar;
+  new_tsk->win = tsk.win;
+  new_tsk->desktop = tsk.desktop;
+  new_tsk->creation_order = tsk.creation_order;
+
+  // to update the current state later in set_task_state...
+  new_tsk->current_state = -1;
+
+  if (new_tsk->desktop == kAllDesktops && server.desktop() != tskbar.desktop) {
+    // hide ALLDESKTOP task on non-current desktop
+    new_tsk->on_screen_ = false;
+  }
+
+  new_tsk->SetTitle(tsk.GetTitle());
+  new_tsk->SetTooltipEnabled(panel->g_task.tooltip_enabled);
+  new_tsk->icon = tsk.icon;
+  tskbar.AppendTask(new_tsk);
+  win_to_task_map[new_tsk->win].push_back(new_tsk);
+  new_tsk->SetState(tsk.current_state);
+
+  util::log::Debug() << "Add task (desktop " << tskbar.desktop << ", task "
+                     << new_tsk->GetTitle() << ")\n";
+  return new_tsk;
+}
+
 Task* AddTask(Window win, Timer& timer) {
   if (win == 0 || util::window::IsHidden(win)) {
     return nullptr;
@@ -95,86 +147,83 @@ Task* AddTask(Window win, Timer& timer) {
 
   Task new_tsk{timer};
   new_tsk.win = win;
+  new_tsk.creation_order = ++last_creation_order;
   new_tsk.desktop = util::window::GetDesktop(win);
-  new_tsk.panel_ = &panels[monitor];
+  new_tsk.panel_ = panels[monitor].get();
   new_tsk.current_state =
       util::window::IsIconified(win) ? kTaskIconified : kTaskNormal;
 
-  // allocate only one title and one icon
-  // even with task_on_all_desktop and with task_on_all_panel
-  for (int k = 0; k < kTaskStateCount; ++k) {
-    new_tsk.icon[k] = 0;
-    new_tsk.icon_hover[k] = 0;
-    new_tsk.icon_pressed[k] = 0;
-    new_tsk.state_pix[k] = {};
+  XSelectInput(server.dsp, new_tsk.win,
+               PropertyChangeMask | StructureNotifyMask);
+
+  std::vector<Taskbar*> taskbars;
+  for (Taskbar& tskbar : panels[monitor]->taskbars) {
+    if (new_tsk.desktop != kAllDesktops && new_tsk.desktop != tskbar.desktop) {
+      continue;
+    }
+    if (tskbar.materialized()) {
+      taskbars.push_back(&tskbar);
+    }
+  }
+
+  if (taskbars.empty()) {
+    // the window lives on a desktop whose taskbar isn't around: just keep
+    // track of it until it is
+    TaskSetDormant(win, new_tsk.desktop);
+    return nullptr;
   }
 
+  // allocate only one title and one icon
+  // even with task_on_all_desktop and with task_on_all_panel
   new_tsk.UpdateTitle();
   GetIcon(&new_tsk);
 
   util::log::Debug() << "task: \"" << new_tsk.GetTitle()
                      << "\", desktop: " << new_tsk.desktop
                      << ", monitor: " << monitor << '\n';
-  XSelectInput(server.dsp, new_tsk.win,
-               PropertyChangeMask | StructureNotifyMask);
 
-  TaskPtrArray task_group;
   Task* new_tsk2 = nullptr;
+  for (Taskbar* tskbar : taskbars) {
+    new_tsk2 = AddTaskCopy(new_tsk, *tskbar, timer);
+  }
 
-  for (unsigned int j = 0; j < panels[monitor].num_desktops_; j++) {
-    if (new_tsk.desktop != kAllDesktops && new_tsk.desktop != j) {
-      continue;
-    }
-
-    Taskbar& tskbar = panels[monitor].taskbars[j];
-    new_tsk2 = new Task{timer};
-
-    // TODO: nuke this from planet Earth ASAP - horrible hack to mimick the
-    // original memcpy() call
-    new_tsk2->CloneArea(panels[monitor].g_task);
-
-    new_tsk2->parent_ = &tskbar;
-    new_tsk2->win = new_tsk.win;
-    new_tsk2->desktop = new_tsk.desktop;
-
-    // to update the current state later in set_task_state...
-    new_tsk2->current_state = -1;
-
-    if (new_tsk2->desktop == kAllDesktops && server.desktop() != j) {
-      // hide ALLDESKTOP task on non-current desktop
-      new_tsk2->on_screen_ = false;
-    }
+  if (util::window::IsUrgent(win)) {
+    new_tsk2->AddUrgent();
+  }
 
-    new_tsk2->SetTitle(new_tsk.GetTitle());
-    new_tsk2->SetTooltipEnabled(panels[monitor].g_task.tooltip_enabled);
+  return new_tsk2;
+}
 
-    for (int k = 0; k < kTaskStateCount; ++k) {
-      new_tsk2->icon[k] = new_tsk.icon[k];
-      new_tsk2->icon_hover[k] = new_tsk.icon_hover[k];
-      new_tsk2->icon_pressed[k] = new_tsk.icon_pressed[k];
-      new_tsk2->state_pix[k] = {};
-    }
+namespace {
 
-    new_tsk2->icon_width = new_tsk.icon_width;
-    new_tsk2->icon_height = new_tsk.icon_height;
-    tskbar.children_.push_back(new_tsk2);
-    tskbar.need_resize_ = true;
-    task_group.push_back(new_tsk2);
+void DestroyTask(Task* tsk) {
+  tsk->parent_->RemoveChild(tsk);
 
-    util::log::Debug() << "Add task (desktop " << j << ", task "
-                       << new_tsk2->GetTitle() << ")\n";
+  if (tsk == task_active) {
+    task_active = nullptr;
+  }
+  if (tsk == task_drag) {
+    task_drag = nullptr;
   }
 
-  win_to_task_map.insert(std::make_pair(new_tsk.win, task_group));
-  new_tsk2->SetState(new_tsk.current_state);
-
-  if (util::window::IsUrgent(win)) {
-    new_tsk2->AddUrgent();
+  auto it = std::find(urgent_list.begin(), urgent_list.end(), tsk);
+  if (it != urgent_list.end()) {
+    tsk->DelUrgent();
   }
+  delete tsk;
+}
 
-  return new_tsk2;
+void ForgetWindow(Window win) {
+  pending_icons.erase(win);
+  published_icon_geometry.erase(win);
+  pending_icon_geometry.erase(win);
+  if (task_title_throttle != nullptr) {
+    task_title_throttle->Forget(win);
+  }
 }
 
+}  // namespace
+
 void RemoveTask(Task* tsk) {
   if (!tsk) {
     return;
@@ -186,22 +235,51 @@ void RemoveTask(Task* tsk) {
   }
 
   for (auto tsk2 : it->second) {
-    tsk2->parent_->RemoveChild(tsk2);
+    DestroyTask(tsk2);
+  }
+  ForgetWindow(it->first);
+  win_to_task_map.erase(it);
+}
 
-    if (tsk2 == task_active) {
-      task_active = nullptr;
-    }
-    if (tsk2 == task_drag) {
-      task_drag = nullptr;
+Panel* FindPanelForWindow(Window win) {
+  return panels[GetMonitor(win)].get();
+}
+
+void TaskRefreshMonitors(Timer& timer) {
+  std::vector<Window> windows;
+  for (auto const& pair : win_to_task_map) {
+    if (pair.second.front()->panel_ != FindPanelForWindow(pair.first)) {
+      windows.push_back(pair.first);
     }
+  }
 
-    auto it = std::find(urgent_list.begin(), urgent_list.end(), tsk2);
-    if (it != urgent_list.end()) {
-      tsk2->DelUrgent();
+  Window active = util::window::GetActive();
+  for (Window win : windows) {
+    RemoveTask(TaskGetTask(win));
+    Task* tsk = AddTask(win, timer);
+    if (tsk != nullptr && win == active) {
+      tsk->SetState(kTaskActive);
+      task_active = tsk;
     }
-    delete tsk2;
   }
+}
+
+bool RemoveTaskCopy(Task* tsk) {
+  auto it = win_to_task_map.find(tsk->win);
+  if (it == win_to_task_map.end()) {
+    return false;
+  }
+
+  Window win = tsk->win;
+  erase(it->second, tsk);
+  DestroyTask(tsk);
+
+  if (!it->second.empty()) {
+    return false;
+  }
+  ForgetWindow(win);
   win_to_task_map.erase(it);
+  return true;
 }
 
 bool Task::UpdateTitle() {
@@ -244,6 +322,7 @@ bool Task::UpdateTitle() {
   for (auto& tsk2 : TaskGetTasks(win)) {
     tsk2->title_ = title_;
     SetTaskRedraw(tsk2);
+    static_cast<Taskbar*>(tsk2->parent_)->UpdateTaskOrder(tsk2);
   }
 
   return true;
@@ -253,6 +332,127 @@ std::string Task::GetTitle() const { return title_; }
 
 void Task::SetTitle(std::string const& title) { title_.assign(title); }
 
+namespace {
+
+void SetIcon(Task* tsk, std::shared_ptr<TaskIcon> const& icon) {
+  tsk->icon = icon;
+
+  for (auto& tsk2 : TaskGetTasks(tsk->win)) {
+    tsk2->icon = icon;
+    SetTaskRedraw(tsk2);
+  }
+}
+
+// Scales the given image to the size required by the panel, and takes
+// ownership of it.
+std::shared_ptr<TaskIcon> CreateIcon(Imlib_Image img, int size) {
+  imlib_context_set_image(img);
+  imlib_image_set_has_alpha(1);
+
+  int w = imlib_image_get_width();
+  int h = imlib_image_get_height();
+  Imlib_Image orig_image =
+      imlib_create_cropped_scaled_image(0, 0, w, h, size, size);
+  imlib_free_image();
+
+  // adjusted variants are generated on demand by Task::DrawIcon()
+  return std::make_shared<TaskIcon>(util::imlib2::Image{orig_image});
+}
+
+std::shared_ptr<TaskIcon> GetDefaultIcon(Panel* panel) {
+  // windows without an icon of their own share the default one
+  TaskIconCache::Key key{0, 0, 0, 0,
+                         static_cast<unsigned int>(panel->g_task.icon_size1)};
+  auto icon = task_icon_cache.Find(key);
+  if (icon) {
+    return icon;
+  }
+
+  Imlib_Image img = nullptr;
+  if (default_icon != nullptr) {
+    imlib_context_set_image(default_icon);
+    img = imlib_clone_image();
+  } else {
+    img = imlib_create_image(48, 48);
+    if (img) {
+      imlib_context_set_image(img);
+      imlib_context_set_color(0, 0, 0, 255);
+      imlib_image_fill_rectangle(0, 0, 48, 48);
+    }
+  }
+
+  icon = CreateIcon(img, panel->g_task.icon_size1);
+  task_icon_cache.Insert(key, icon);
+  return icon;
+}
+
+// Wraps an already scaled ARGB buffer into a TaskIcon, and caches it.
+std::shared_ptr<TaskIcon> CreateArgbIcon(TaskIconCache::Key const& key,
+                                         util::ArgbImage const& image) {
+  if (image.empty()) {
+    return nullptr;
+  }
+
+  Imlib_Image img = imlib_create_image_using_copied_data(
+      image.width, image.height,
+      reinterpret_cast<DATA32*>(const_cast<uint32_t*>(image.pixels.data())));
+  if (img == nullptr) {
+    return nullptr;
+  }
+  imlib_context_set_image(img);
+  imlib_image_set_has_alpha(1);
+
+  auto icon = std::make_shared<TaskIcon>(util::imlib2::Image{img});
+  task_icon_cache.Insert(key, icon);
+  return icon;
+}
+
+void DecodeArgbIcon(Task* tsk, TaskIconCache::Key const& key,
+                    std::shared_ptr<util::ArgbImage> source) {
+  unsigned int size = key.size;
+
+  if (task_icon_worker_pool == nullptr) {
+    auto icon = CreateArgbIcon(key, util::ScaleArgbImage(*source, size, size));
+    SetIcon(tsk, icon ? icon : GetDefaultIcon(tsk->panel_));
+    return;
+  }
+
+  // draw the default icon until the real one is ready, unless there's
+  // already an older icon we can keep showing in the meantime
+  if (!tsk->icon) {
+    SetIcon(tsk, GetDefaultIcon(tsk->panel_));
+  }
+
+  Window win = tsk->win;
+  unsigned long request = ++last_icon_request;
+  pending_icons[win] = request;
+
+  auto result = std::make_shared<util::ArgbImage>();
+  task_icon_worker_pool->Post(
+      [source, result, size] {
+        *result = util::ScaleArgbImage(*source, size, size);
+      },
+      [win, request, key, result] {
+        auto it = pending_icons.find(win);
+        if (it == pending_icons.end() || it->second != request) {
+          return;
+        }
+        pending_icons.erase(it);
+
+        auto tasks = TaskGetTasks(win);
+        auto icon = CreateArgbIcon(key, *result);
+        if (!tasks.empty() && icon) {
+          SetIcon(tasks.front(), icon);
+          panel_refresh = true;
+        }
+      });
+}
+
+}  // namespace
+
+util::WorkerPool* task_icon_worker_pool = nullptr;
+TitleThrottle* task_title_throttle = nullptr;
+
 void GetIcon(Task* tsk) {
   Panel* panel = tsk->panel_;
 
@@ -260,39 +460,33 @@ void GetIcon(Task* tsk) {
     return;
   }
 
-  for (int k = 0; k < kTaskStateCount; ++k) {
-    if (tsk->icon[k]) {
-      imlib_context_set_image(tsk->icon[k]);
-      imlib_free_image();
-      tsk->icon[k] = 0;
-    }
-    if (tsk->icon_hover[k]) {
-      imlib_context_set_image(tsk->icon_hover[k]);
-      imlib_free_image();
-      tsk->icon_hover[k] = 0;
-    }
-    if (tsk->icon_pressed[k]) {
-      imlib_context_set_image(tsk->icon_pressed[k]);
-      imlib_free_image();
-      tsk->icon_pressed[k] = 0;
-    }
-  }
-
   Imlib_Image img = nullptr;
-  int length = 0;
-  auto data = ServerGetProperty<unsigned long>(
-      tsk->win, server.atom("_NET_WM_ICON"), XA_CARDINAL, &length);
+  NetWmIcon argb_icon = GetNetWmIcon(tsk->win, panel->g_task.icon_size1);
 
-  if (data != nullptr && length > 0) {
+  if (argb_icon.pixels != nullptr) {
     // get ARGB icon
-    int w, h;
-    unsigned long* tmp_data =
-        GetBestIcon(data.get(), GetIconCount(data.get(), length), length, &w,
-                    &h, panel->g_task.icon_size1);
-    if (tmp_data) {
-      std::vector<DATA32> icon_data{&tmp_data[0], &tmp_data[w * h]};
-      img = imlib_create_image_using_copied_data(w, h, icon_data.data());
+    unsigned long const* pixels = argb_icon.pixels;
+    unsigned int w = argb_icon.width;
+    unsigned int h = argb_icon.height;
+    TaskIconCache::Key key{HashArgbData(pixels, w * h),
+                           ChecksumArgbData(pixels, w * h), w, h,
+                           static_cast<unsigned int>(panel->g_task.icon_size1)};
+
+    auto icon = task_icon_cache.Find(key);
+    if (icon) {
+      pending_icons.erase(tsk->win);
+      SetIcon(tsk, icon);
+      return;
+    }
+
+    // scaling may outlive the reply, so the frame is only copied into an
+    // owned buffer now; of each long, only the lower 32 bits are significant
+    auto source = std::make_shared<util::ArgbImage>(w, h);
+    for (unsigned int i = 0; i < w * h; ++i) {
+      source->pixels[i] = static_cast<uint32_t>(pixels[i]);
     }
+    DecodeArgbIcon(tsk, key, source);
+    return;
   } else {
     // get Pixmap icon
     util::x11::ClientData<XWMHints> hints(XGetWMHints(server.dsp, tsk->win));
@@ -313,85 +507,14 @@ void GetIcon(Task* tsk) {
     }
   }
 
-  if (img == nullptr) {
-    if (default_icon != nullptr) {
-      imlib_context_set_image(default_icon);
-      img = imlib_clone_image();
-    } else {
-      img = imlib_create_image(48, 48);
-      if (img) {
-        imlib_context_set_image(img);
-        imlib_context_set_color(0, 0, 0, 255);
-        imlib_image_fill_rectangle(0, 0, 48, 48);
-      }
-    }
-  }
-
-  // transform icons
-  imlib_context_set_image(img);
-  imlib_image_set_has_alpha(1);
-
-  int w = imlib_image_get_width();
-  int h = imlib_image_get_height();
-  Imlib_Image orig_image = imlib_create_cropped_scaled_image(
-      0, 0, w, h, panel->g_task.icon_size1, panel->g_task.icon_size1);
-  imlib_free_image();
-
-  imlib_context_set_image(orig_image);
-  tsk->icon_width = imlib_image_get_width();
-  tsk->icon_height = imlib_image_get_height();
-
-  for (int k = 0; k < kTaskStateCount; ++k) {
-    auto adjusted_icon = util::imlib2::Image::CloneExisting(orig_image);
-    imlib_context_set_image(adjusted_icon);
-    if (panel->g_task.alpha[k] != 100 || panel->g_task.saturation[k] != 0 ||
-        panel->g_task.brightness[k] != 0) {
-      DATA32* data32 = imlib_image_get_data();
-      AdjustASB(data32, tsk->icon_width, tsk->icon_height,
-                panel->g_task.alpha[k],
-                (float)panel->g_task.saturation[k] / 100,
-                (float)panel->g_task.brightness[k] / 100);
-      imlib_image_put_back_data(data32);
-    }
-    tsk->icon[k] = adjusted_icon;
-
-    auto adjusted_hover_icon = util::imlib2::Image::CloneExisting(orig_image);
-    if (new_panel_config.mouse_effects) {
-      imlib_context_set_image(adjusted_hover_icon);
-      DATA32* hover_data = imlib_image_get_data();
-      AdjustASB(hover_data, tsk->icon_width, tsk->icon_height,
-                new_panel_config.mouse_hover_alpha,
-                new_panel_config.mouse_hover_saturation / 100.0f,
-                new_panel_config.mouse_hover_brightness / 100.0f);
-      imlib_image_put_back_data(hover_data);
-    }
-    tsk->icon_hover[k] = adjusted_hover_icon;
-
-    auto adjusted_pressed_icon = util::imlib2::Image::CloneExisting(orig_image);
-    if (new_panel_config.mouse_effects) {
-      imlib_context_set_image(adjusted_pressed_icon);
-      DATA32* pressed_data = imlib_image_get_data();
-      AdjustASB(pressed_data, tsk->icon_width, tsk->icon_height,
-                new_panel_config.mouse_pressed_alpha,
-                new_panel_config.mouse_pressed_saturation / 100.0f,
-                new_panel_config.mouse_pressed_brightness / 100.0f);
-      imlib_image_put_back_data(pressed_data);
-    }
-    tsk->icon_pressed[k] = adjusted_hover_icon;
-  }
+  pending_icons.erase(tsk->win);
 
-  imlib_context_set_image(orig_image);
-  imlib_free_image();
-
-  for (auto& tsk2 : TaskGetTasks(tsk->win)) {
-    tsk2->icon_width = tsk->icon_width;
-    tsk2->icon_height = tsk->icon_height;
-
-    for (int k = 0; k < kTaskStateCount; ++k) {
-      tsk2->icon[k] = tsk->icon[k];
-    }
-
-    SetTaskRedraw(tsk2);
+  // pixmap icons aren't cached: fetching them is already a server round trip,
+  // so there's little to gain from hashing their contents
+  if (img == nullptr) {
+    SetIcon(tsk, GetDefaultIcon(panel));
+  } else {
+    SetIcon(tsk, CreateIcon(img, panel->g_task.icon_size1));
   }
 }
 
@@ -407,19 +530,46 @@ void Task::DrawIcon(int text_width) {
     pos_x = panel_->g_task.padding_x_lr_ + bg_.border().width();
   }
 
-  Imlib_Image image = nullptr;
+  if (!icon) {
+    return;
+  }
+
+  util::imlib2::Asb asb;
   if (mouse_state() == MouseState::kMouseOver)
-    image = icon_hover[current_state];
+    asb = {new_panel_config.mouse_hover_alpha,
+           new_panel_config.mouse_hover_saturation,
+           new_panel_config.mouse_hover_brightness};
   else if (mouse_state() == MouseState::kMousePressed)
-    image = icon_pressed[current_state];
+    asb = {new_panel_config.mouse_pressed_alpha,
+           new_panel_config.mouse_pressed_saturation,
+           new_panel_config.mouse_pressed_brightness};
   else
-    image = icon[current_state];
+    asb = {panel_->g_task.alpha[current_state],
+           panel_->g_task.saturation[current_state],
+           panel_->g_task.brightness[current_state]};
+
+  Imlib_Image image = icon->Get(asb);
   if (image) RenderImage(&server, pix_, image, pos_x, panel_->g_task.icon_posy);
 }
 
-void Task::DrawForeground(cairo_t* c) {
-  state_pix[current_state] = pix_;
+void Task::Draw() {
+  if (current_state < 0 || current_state >= kTaskStateCount) {
+    Area::Draw();
+    return;
+  }
 
+  // state changes (e.g., focus or urgency) and mouse effects only need to
+  // pick up an earlier rendering, when there's one
+  auto& cached = state_pix[current_state][static_cast<int>(mouse_state())];
+  if (cached == None) {
+    Area::Draw();
+    cached = pix_;
+  } else {
+    pix_ = cached;
+  }
+}
+
+void Task::DrawForeground(cairo_t* c) {
   int width = 0;
   int height = 0;
 
@@ -470,16 +620,43 @@ void Task::DrawForeground(cairo_t* c) {
 }
 
 void Task::OnChangeLayout() {
-  long value[] = {panel_->panel_x_ + panel_x_, panel_->panel_y_ + panel_y_,
-                  width_, height_};
-
-  XChangeProperty(server.dsp, win, server.atom("_NET_WM_ICON_GEOMETRY"),
-                  XA_CARDINAL, 32, PropModeReplace, (unsigned char*)value, 4);
+  UpdateIconGeometry();
 
   // reset Pixmap when position/size changed
   SetTaskRedraw(this);
 }
 
+void Task::UpdateIconGeometry() {
+  // windows on all desktops have a task on every taskbar, but only the one
+  // that's actually visible has a meaningful geometry
+  if (desktop == kAllDesktops &&
+      static_cast<Taskbar*>(parent_)->desktop != server.desktop()) {
+    return;
+  }
+
+  IconGeometry value = {{panel_->panel_x_ + panel_x_,
+                         panel_->panel_y_ + panel_y_, width_, height_}};
+
+  auto it = published_icon_geometry.find(win);
+  if (it != published_icon_geometry.end() && it->second == value) {
+    pending_icon_geometry.erase(win);
+    return;
+  }
+  pending_icon_geometry[win] = value;
+}
+
+void PublishIconGeometries() {
+  for (auto const& pair : pending_icon_geometry) {
+    XChangeProperty(server.dsp, pair.first,
+                    server.atom("_NET_WM_ICON_GEOMETRY"), XA_CARDINAL, 32,
+                    PropModeReplace,
+                    reinterpret_cast<unsigned char const*>(pair.second.data()),
+                    pair.second.size());
+    published_icon_geometry[pair.first] = pair.second;
+  }
+  pending_icon_geometry.clear();
+}
+
 // Given a pointer to the active task (active_task) and a pointer
 // to the task that is currently under the mouse (current_task),
 // return a pointer to the active task that is on the same desktop
@@ -500,10 +677,9 @@ Task* FindActiveTask(Task* current_task, Task* active_task) {
     return active_task;
   }
 
-  Taskbar* tskbar = reinterpret_cast<Taskbar*>(current_task->parent_);
-  for (Area* child : tskbar->filtered_children()) {
-    auto tsk = static_cast<Task*>(child);
-    if (tsk->win == active_task->win) {
+  // the window's group has at most one task per taskbar
+  for (Task* tsk : TaskGetTasks(active_task->win)) {
+    if (tsk->parent_ == current_task->parent_) {
       return tsk;
     }
   }
@@ -516,19 +692,13 @@ Task* NextTask(Task* tsk) {
     return nullptr;
   }
 
-  auto tskbar = reinterpret_cast<Taskbar*>(tsk->parent_);
-  auto children = tskbar->filtered_children();
-  auto it = std::find(std::begin(children), std::end(children), tsk);
-
-  if (it == std::end(children)) {
+  auto& tasks = static_cast<Taskbar*>(tsk->parent_)->tasks();
+  if (!tasks.Contains(tsk)) {
     return nullptr;
   }
 
-  if (++it == std::end(children)) {
-    return static_cast<Task*>(tskbar->children_.front());
-  }
-
-  return static_cast<Task*>(*it);
+  Task* const* next = tasks.Next(tsk);
+  return (next != nullptr) ? *next : *tasks.front();
 }
 
 Task* PreviousTask(Task* tsk) {
@@ -536,19 +706,13 @@ Task* PreviousTask(Task* tsk) {
     return nullptr;
   }
 
-  auto tskbar = reinterpret_cast<Taskbar*>(tsk->parent_);
-  auto children = tskbar->filtered_children();
-  auto it = std::find(std::begin(children), std::end(children), tsk);
-
-  if (it == std::end(children)) {
+  auto& tasks = static_cast<Taskbar*>(tsk->parent_)->tasks();
+  if (!tasks.Contains(tsk)) {
     return nullptr;
   }
 
-  if (--it == std::begin(children)) {
-    return static_cast<Task*>(tskbar->children_.back());
-  }
-
-  return static_cast<Task*>(*it);
+  Task* const* previous = tasks.Previous(tsk);
+  return (previous != nullptr) ? *previous : *tasks.back();
 }
 
 void ActiveTask() {
@@ -574,6 +738,10 @@ void ActiveTask() {
 
     if (task_active != nullptr) {
       task_active->SetState(kTaskActive);
+
+      for (Task* tsk : TaskGetTasks(w1)) {
+        static_cast<Taskbar*>(tsk->parent_)->ScrollToTask(tsk);
+      }
     }
   }
 }
@@ -586,13 +754,9 @@ void Task::SetState(int state) {
   if (current_state != state) {
     for (auto& tsk1 : TaskGetTasks(win)) {
       tsk1->current_state = state;
-      tsk1->bg_ = panels[0].g_task.background[state];
-      tsk1->pix_ = tsk1->state_pix[state];
+      tsk1->bg_ = panels[0]->g_task.background[state];
       tsk1->set_mouse_state(MouseState::kMouseNormal);
-
-      if (tsk1->state_pix[state] == None) {
-        tsk1->need_redraw_ = true;
-      }
+      tsk1->need_redraw_ = true;
 
       auto it = std::find(urgent_list.begin(), urgent_list.end(), tsk1);
 
@@ -606,25 +770,40 @@ void Task::SetState(int state) {
 }
 
 void SetTaskRedraw(Task* tsk) {
-  for (int k = 0; k < kTaskStateCount; ++k) tsk->state_pix[k] = {};
+  for (auto& state_pix : tsk->state_pix) {
+    for (auto& pix : state_pix) pix = {};
+  }
   tsk->pix_ = {};
   tsk->need_redraw_ = true;
 }
 
-bool BlinkUrgent() {
-  for (auto& t : urgent_list) {
-    if (t->urgent_tick < t->panel_->max_urgent_blinks()) {
-      if (t->urgent_tick++ % 2) {
-        t->SetState(kTaskUrgent);
-      } else {
-        t->SetState(util::window::IsIconified(t->win) ? kTaskIconified
-                                                      : kTaskNormal);
-      }
-    }
+void BlinkUrgentTask(Window win, bool urgent) {
+  TaskPtrArray tasks = TaskGetTasks(win);
+  if (tasks.empty()) {
+    return;
   }
 
-  panel_refresh = true;
-  return true;
+  int state = kTaskUrgent;
+  if (!urgent) {
+    state = util::window::IsIconified(win) ? kTaskIconified : kTaskNormal;
+  }
+
+  // unless the panel is going to be refreshed anyway, flipping between frames
+  // that are already rendered only takes a copy
+  bool frames_ready = !panel_refresh;
+  for (Task* tsk : tasks) {
+    frames_ready = frames_ready && tsk->HasFrame(state);
+  }
+
+  if (!frames_ready) {
+    tasks.front()->SetState(state);
+    return;
+  }
+
+  for (Task* tsk : tasks) {
+    tsk->ShowFrame(state);
+  }
+  XFlush(server.dsp);
 }
 
 void Task::AddUrgent() {
@@ -635,28 +814,97 @@ void Task::AddUrgent() {
 
   // always add the first tsk for a task group (omnipresent windows)
   Task* tsk = TaskGetTask(win);
-  tsk->urgent_tick = 0;
 
   auto it = std::find(urgent_list.begin(), urgent_list.end(), tsk);
 
   if (it == urgent_list.end()) {
     // not yet in the list, so we have to add it
     urgent_list.push_front(tsk);
+  }
 
-    if (!urgent_timeout) {
-      urgent_timeout = timer_.SetInterval(absl::Seconds(1), BlinkUrgent);
-      BlinkUrgent();
-    }
+  if (task_urgent_blinker == nullptr) {
+    tsk->SetState(kTaskUrgent);
+    return;
   }
+
+  int normal_state =
+      util::window::IsIconified(win) ? kTaskIconified : kTaskNormal;
+  for (Task* tsk2 : TaskGetTasks(win)) {
+    tsk2->PrerenderFrame(kTaskUrgent);
+    tsk2->PrerenderFrame(normal_state);
+  }
+  task_urgent_blinker->Add(win, panel_->max_urgent_blinks());
 }
 
 void Task::DelUrgent() {
   erase(urgent_list, this);
 
-  if (urgent_list.empty()) {
-    timer_.ClearInterval(urgent_timeout);
-    urgent_timeout.reset();
+  if (task_urgent_blinker != nullptr) {
+    task_urgent_blinker->Remove(win);
+  }
+}
+
+void Task::PrerenderFrame(int state) {
+  if (!on_screen_ || panel_->temp_pmap == None || pix_ == None ||
+      parent_->pix_ == None) {
+    return;
+  }
+
+  auto& cached = state_pix[state][static_cast<int>(mouse_state())];
+  if (cached != None) {
+    return;
+  }
+
+  // Area::Draw() takes what's behind the task from the panel's pixmap, where
+  // the task itself is currently drawn: put the taskbar back in its place
+  // first, and restore the current rendering afterwards.
+  XCopyArea(server.dsp, parent_->pix_, panel_->temp_pmap, server.gc,
+            panel_x_ - parent_->panel_x_, panel_y_ - parent_->panel_y_, width_,
+            height_, panel_x_, panel_y_);
+
+  // Area::Draw() renders according to the current state and background
+  int previous_state = current_state;
+  Background previous_bg = bg_;
+  util::x11::Pixmap previous_pix = pix_;
+
+  current_state = state;
+  bg_ = panels[0]->g_task.background[state];
+  Area::Draw();
+  cached = pix_;
+
+  current_state = previous_state;
+  bg_ = previous_bg;
+  pix_ = previous_pix;
+
+  XCopyArea(server.dsp, pix_, panel_->temp_pmap, server.gc, 0, 0, width_,
+            height_, panel_x_, panel_y_);
+}
+
+bool Task::HasFrame(int state) const {
+  if (!on_screen_) {
+    // nothing to show: the state is picked up on the next refresh
+    return true;
+  }
+  if (panel_->hidden() || panel_->temp_pmap == None) {
+    return false;
   }
+  return state_pix[state][static_cast<int>(mouse_state())] != None;
+}
+
+void Task::ShowFrame(int state) {
+  current_state = state;
+  bg_ = panels[0]->g_task.background[state];
+
+  if (!on_screen_) {
+    need_redraw_ = true;
+    return;
+  }
+
+  pix_ = state_pix[state][static_cast<int>(mouse_state())];
+  XCopyArea(server.dsp, pix_, panel_->temp_pmap, server.gc, 0, 0, width_,
+            height_, panel_x_, panel_y_);
+  XCopyArea(server.dsp, pix_, panel_->main_win_, server.gc, 0, 0, width_,
+            height_, panel_x_, panel_y_);
 }
 
 #ifdef _TINT3_DEBUG
@@ -5,13 +5,20 @@
 #include <X11/Xlib.h>
 
 #include <list>
+#include <memory>
 
+#include "taskbar/task_icon.hh"
+#include "taskbar/title_throttle.hh"
+#include "taskbar/urgent_blinker.hh"
 #include "util/area.hh"
 #include "util/common.hh"
 #include "util/pango.hh"
 #include "util/timer.hh"
+#include "util/worker_pool.hh"
 #include "util/x11.hh"
 
+class Taskbar;
+
 enum TaskState {
   kTaskNormal,
   kTaskActive,
@@ -34,6 +41,9 @@ class Global_task : public Area {
   int icon_size1;
   int maximum_width;
   int maximum_height;
+  // below this size, tasks that don't fit are paged out instead of shrunk
+  // (0 disables paging)
+  int minimum_size = 0;
   int alpha[kTaskStateCount];
   int saturation[kTaskStateCount];
   int brightness[kTaskStateCount];
@@ -58,15 +68,16 @@ class Task : public Area {
   // TODO: group task with list of windows here
   Window win;
   unsigned int desktop;
+  // tells in which order windows were first seen, see TaskbarSortOrder
+  unsigned long creation_order = 0;
   int current_state;
-  util::imlib2::Image icon[kTaskStateCount];
-  util::imlib2::Image icon_hover[kTaskStateCount];
-  util::imlib2::Image icon_pressed[kTaskStateCount];
-  util::x11::Pixmap state_pix[kTaskStateCount];
-  unsigned int icon_width;
-  unsigned int icon_height;
-  int urgent_tick;
+  // shared by all the Task objects representing the same window
+  std::shared_ptr<TaskIcon> icon;
+  // renderings of the task for each state, reused until the title, icon,
+  // size or background change (see SetTaskRedraw())
+  util::x11::Pixmap state_pix[kTaskStateCount][kMouseStateCount];
 
+  void Draw() override;
   void DrawForeground(cairo_t* c) override;
   std::string GetTooltipText() override;
   bool UpdateTitle();  // TODO: find a more descriptive name
@@ -74,11 +85,23 @@ class Task : public Area {
   void SetTitle(std::string const& title);
   void SetState(int state);
   void OnChangeLayout() override;
+  // Queues an update of _NET_WM_ICON_GEOMETRY, if the task's position or size
+  // differ from the last ones published for its window.
+  void UpdateIconGeometry();
   Task& SetTooltipEnabled(bool);
 
   void AddUrgent();
   void DelUrgent();
 
+  // Renders the task in the given state ahead of time, if it's visible and
+  // has been laid out already.
+  void PrerenderFrame(int state);
+  // Returns true if ShowFrame() can be used to switch to the given state.
+  bool HasFrame(int state) const;
+  // Switches to the given state by copying its rendering straight to the
+  // panel, rather than going through a full refresh.
+  void ShowFrame(int state);
+
 #ifdef _TINT3_DEBUG
 
   std::string GetFriendlyName() const override;
@@ -93,11 +116,43 @@ class Task : public Area {
   void DrawIcon(int);
 };
 
-extern Interval::Id urgent_timeout;
 extern std::list<Task*> urgent_list;
 
+// When set, urgent tasks blink according to this engine, which is expected to
+// call BlinkUrgentTask(). Otherwise they're just shown as urgent.
+extern UrgentBlinker* task_urgent_blinker;
+
+// When set, _NET_WM_ICON data is scaled in the background by this pool, and
+// tasks show the default icon until the result is ready. Otherwise icons are
+// processed synchronously.
+extern util::WorkerPool* task_icon_worker_pool;
+
+// When set, title changes are routed through this throttle rather than being
+// applied right away.
+extern TitleThrottle* task_title_throttle;
+
 Task* AddTask(Window win, Timer& timer);
 void RemoveTask(Task* tsk);
+// Returns the panel the tasks of the given window belong on, according to the
+// monitor it's on.
+Panel* FindPanelForWindow(Window win);
+// Moves the tasks of the windows that aren't on the monitor of their panel
+// anymore, or whose panel is going away, to the right panel.
+void TaskRefreshMonitors(Timer& timer);
+
+// Adds to the taskbar a new task sharing window, title, icon and state with the
+// given one, and adds it to the window's group.
+Task* AddTaskCopy(Task const& tsk, Taskbar& tskbar, Timer& timer);
+// Removes a single task of a window's group. Returns true if it was the last
+// one, in which case the window isn't tracked anymore.
+bool RemoveTaskCopy(Task* tsk);
+
+// Sets _NET_WM_ICON_GEOMETRY on the windows whose tasks moved since the last
+// call, in one go.
+void PublishIconGeometries();
+
+// Shows the urgent or normal frame of a window demanding attention.
+void BlinkUrgentTask(Window win, bool urgent);
 
 void GetIcon(Task* tsk);
 void ActiveTask();
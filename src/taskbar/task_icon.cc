@@ -0,0 +1,144 @@
+#include <initializer_list>
+#include <utility>
+
+#include "taskbar/task_icon.hh"
+#include "util/hash.hh"
+
+namespace util {
+namespace imlib2 {
+
+size_t AsbHash::operator()(Asb const& asb) const {
+  // alpha fits in 7 bits, saturation and brightness in 8 bits each.
+  return std::hash<int>()(((asb.alpha & 0xff) << 16) |
+                          ((asb.saturation & 0xff) << 8) |
+                          (asb.brightness & 0xff));
+}
+
+}  // namespace imlib2
+}  // namespace util
+
+constexpr size_t TaskIcon::kMaxVariants;
+
+TaskIcon::TaskIcon(util::imlib2::Image image)
+    : image_(std::move(image)), width_(0), height_(0), variants_(kMaxVariants) {
+  if (image_ != nullptr) {
+    Imlib_Image previous_image = imlib_context_get_image();
+    imlib_context_set_image(image_);
+    width_ = imlib_image_get_width();
+    height_ = imlib_image_get_height();
+    imlib_context_set_image(previous_image);
+  }
+}
+
+unsigned int TaskIcon::width() const { return width_; }
+
+unsigned int TaskIcon::height() const { return height_; }
+
+Imlib_Image TaskIcon::Get(util::imlib2::Asb const& asb) {
+  if (image_ == nullptr || asb.IsIdentity()) {
+    return image_;
+  }
+
+  util::imlib2::Image* variant = variants_.Get(asb);
+  if (variant != nullptr) {
+    return *variant;
+  }
+
+  auto adjusted = util::imlib2::Image::CloneExisting(image_);
+  adjusted.AdjustASB(asb);
+  return variants_.Put(asb, std::move(adjusted));
+}
+
+size_t TaskIcon::variant_count() const { return variants_.size(); }
+
+size_t TaskIcon::memory_usage() const {
+  if (image_ == nullptr) {
+    return 0;
+  }
+  return (1 + variants_.size()) * width_ * height_ * sizeof(DATA32);
+}
+
+uint64_t HashArgbData(unsigned long const* data, size_t count) {
+  util::Fnv1aHasher hasher;
+  for (size_t i = 0; i < count; ++i) {
+    hasher.Add(static_cast<uint32_t>(data[i]));
+  }
+  return hasher.hash();
+}
+
+uint64_t ChecksumArgbData(unsigned long const* data, size_t count) {
+  // sum of the pixels mixed with their position, through the splitmix64
+  // finalizer
+  uint64_t checksum = count;
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t value = (static_cast<uint64_t>(i) << 32) |
+                     static_cast<uint32_t>(data[i]);
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    checksum += value ^ (value >> 31);
+  }
+  return checksum;
+}
+
+TaskIconCache task_icon_cache;
+
+constexpr size_t TaskIconCache::kDefaultCapacity;
+
+size_t TaskIconCache::KeyHash::operator()(Key const& key) const {
+  size_t seed = std::hash<uint64_t>()(key.hash ^ key.checksum);
+  for (unsigned int value : {key.source_width, key.source_height, key.size}) {
+    seed ^= std::hash<unsigned int>()(value) + 0x9e3779b9 + (seed << 6) +
+            (seed >> 2);
+  }
+  return seed;
+}
+
+bool operator==(TaskIconCache::Key const& lhs, TaskIconCache::Key const& rhs) {
+  return lhs.hash == rhs.hash && lhs.checksum == rhs.checksum &&
+         lhs.source_width == rhs.source_width &&
+         lhs.source_height == rhs.source_height && lhs.size == rhs.size;
+}
+
+TaskIconCache::TaskIconCache(size_t capacity)
+    : entries_(capacity), hits_(0), misses_(0), evictions_(0) {}
+
+std::shared_ptr<TaskIcon> TaskIconCache::Find(Key const& key) {
+  std::shared_ptr<TaskIcon>* icon = entries_.Get(key);
+  if (icon == nullptr) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return *icon;
+}
+
+void TaskIconCache::Insert(Key const& key, std::shared_ptr<TaskIcon> icon) {
+  bool is_new = !entries_.Has(key);
+  size_t previous_size = entries_.size();
+  entries_.Put(key, std::move(icon));
+  if (is_new && entries_.size() == previous_size) {
+    ++evictions_;
+  }
+}
+
+void TaskIconCache::Clear() { entries_.Clear(); }
+
+TaskIconCache::Stats TaskIconCache::stats() const {
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.evictions = evictions_;
+  stats.entries = entries_.size();
+  for (auto const& entry : entries_) {
+    stats.memory_usage += entry.second->memory_usage();
+  }
+  return stats;
+}
+
+std::ostream& operator<<(std::ostream& os, TaskIconCache::Stats const& stats) {
+  return os << "TaskIconCache::Stats{hits: " << stats.hits
+            << ", misses: " << stats.misses
+            << ", evictions: " << stats.evictions
+            << ", entries: " << stats.entries
+            << ", memory_usage: " << stats.memory_usage << " bytes}";
+}
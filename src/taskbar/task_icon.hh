@@ -0,0 +1,134 @@
+#ifndef TINT3_TASKBAR_TASK_ICON_HH
+#define TINT3_TASKBAR_TASK_ICON_HH
+
+#include <Imlib2.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+
+#include "util/imlib2.hh"
+#include "util/lru_cache.hh"
+
+namespace util {
+namespace imlib2 {
+
+struct AsbHash {
+  size_t operator()(Asb const& asb) const;
+};
+
+}  // namespace imlib2
+}  // namespace util
+
+// Holds the scaled icon of a window, shared between all the Task objects that
+// represent it, and the alpha/saturation/brightness adjusted variants derived
+// from it.
+//
+// Variants are only generated the first time they're requested (e.g., the
+// first time a task is drawn in the active state, or hovered), and only the
+// most recently used ones are kept around.
+class TaskIcon {
+ public:
+  // Most configurations only ever display one or two variants per window
+  // (normal and active, plus hover/pressed when mouse effects are on).
+  static constexpr size_t kMaxVariants = 4;
+
+  explicit TaskIcon(util::imlib2::Image image);
+
+  TaskIcon(TaskIcon const&) = delete;
+  TaskIcon& operator=(TaskIcon const&) = delete;
+
+  unsigned int width() const;
+  unsigned int height() const;
+
+  // Returns the icon adjusted according to the given parameters. The returned
+  // image is owned by this object, and is only guaranteed to stay valid until
+  // the next call to Get().
+  Imlib_Image Get(util::imlib2::Asb const& asb);
+
+  size_t variant_count() const;
+
+  // Approximate amount of memory held by the icon and its variants, in bytes.
+  size_t memory_usage() const;
+
+ private:
+  util::imlib2::Image image_;
+  unsigned int width_;
+  unsigned int height_;
+  util::LruCache<util::imlib2::Asb, util::imlib2::Image,
+                 util::imlib2::AsbHash>
+      variants_;
+};
+
+// Returns a fast, non-cryptographic hash of the given ARGB pixel data.
+// _NET_WM_ICON data is stored as an array of longs, of which only the lower 32
+// bits are significant, hence the element type.
+uint64_t HashArgbData(unsigned long const* data, size_t count);
+
+// Returns a second hash of the given ARGB pixel data, computed independently
+// from HashArgbData(), so that different icons only share a cache key if both
+// hashes collide at once.
+uint64_t ChecksumArgbData(unsigned long const* data, size_t count);
+
+// Content-addressed cache of scaled task icons, so that windows belonging to
+// the same application (which usually advertise identical icons) share a
+// single TaskIcon, along with its adjusted variants, instead of each decoding
+// and scaling their own copy.
+//
+// Keys carry two independent hashes of the source pixels rather than the
+// pixels themselves, so that lookups don't need a copy of the source, and a
+// single hash collision can't show the wrong icon.
+class TaskIconCache {
+ public:
+  struct Key {
+    // hashes of the source pixel data; zero for the default icon
+    uint64_t hash;
+    uint64_t checksum;
+    unsigned int source_width;
+    unsigned int source_height;
+    unsigned int size;
+  };
+
+  struct KeyHash {
+    size_t operator()(Key const& key) const;
+  };
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t memory_usage = 0;
+  };
+
+  static constexpr size_t kDefaultCapacity = 64;
+
+  explicit TaskIconCache(size_t capacity = kDefaultCapacity);
+
+  // Returns the icon stored for the given key, or nullptr if there's none.
+  std::shared_ptr<TaskIcon> Find(Key const& key);
+
+  // Stores an icon for the given key, possibly evicting the least recently
+  // used entry. Icons still in use by some Task survive the eviction, as the
+  // cache only drops its own reference.
+  void Insert(Key const& key, std::shared_ptr<TaskIcon> icon);
+
+  void Clear();
+
+  Stats stats() const;
+
+ private:
+  util::LruCache<Key, std::shared_ptr<TaskIcon>, KeyHash> entries_;
+  size_t hits_;
+  size_t misses_;
+  size_t evictions_;
+};
+
+bool operator==(TaskIconCache::Key const& lhs, TaskIconCache::Key const& rhs);
+std::ostream& operator<<(std::ostream& os, TaskIconCache::Stats const& stats);
+
+extern TaskIconCache task_icon_cache;
+
+#endif  // TINT3_TASKBAR_TASK_ICON_HH
@@ -0,0 +1,138 @@
+#include "catch.hpp"
+
+#include <memory>
+#include <vector>
+
+#include "taskbar/task_icon.hh"
+
+namespace {
+
+util::imlib2::Image CreateFilledImage(int width, int height, DATA32 color) {
+  Imlib_Image image = imlib_create_image(width, height);
+  imlib_context_set_image(image);
+  imlib_image_set_has_alpha(1);
+  DATA32* data = imlib_image_get_data();
+  for (int i = 0; i < width * height; ++i) {
+    data[i] = color;
+  }
+  imlib_image_put_back_data(data);
+  return util::imlib2::Image{image};
+}
+
+}  // namespace
+
+TEST_CASE("HashArgbData", "Only the lower 32 bits of each pixel matter") {
+  std::vector<unsigned long> first{0xffc86464, 0xff000000};
+  std::vector<unsigned long> second{0xffc86464, 0xff000001};
+  REQUIRE(HashArgbData(first.data(), first.size()) ==
+          HashArgbData(first.data(), first.size()));
+  REQUIRE(HashArgbData(first.data(), first.size()) !=
+          HashArgbData(second.data(), second.size()));
+
+  // no-op on platforms where long is 32 bits wide
+  unsigned long high_bits = ~0UL ^ 0xffffffffUL;
+  std::vector<unsigned long> third{first[0] | high_bits, first[1] | high_bits};
+  REQUIRE(HashArgbData(first.data(), first.size()) ==
+          HashArgbData(third.data(), third.size()));
+}
+
+TEST_CASE("ChecksumArgbData", "Pixel positions matter") {
+  std::vector<unsigned long> first{0xffc86464, 0xff000000};
+  std::vector<unsigned long> swapped{0xff000000, 0xffc86464};
+  REQUIRE(ChecksumArgbData(first.data(), first.size()) ==
+          ChecksumArgbData(first.data(), first.size()));
+  REQUIRE(ChecksumArgbData(first.data(), first.size()) !=
+          ChecksumArgbData(swapped.data(), swapped.size()));
+  REQUIRE(ChecksumArgbData(first.data(), first.size()) !=
+          HashArgbData(first.data(), first.size()));
+
+  unsigned long high_bits = ~0UL ^ 0xffffffffUL;
+  std::vector<unsigned long> third{first[0] | high_bits, first[1] | high_bits};
+  REQUIRE(ChecksumArgbData(first.data(), first.size()) ==
+          ChecksumArgbData(third.data(), third.size()));
+}
+
+TEST_CASE("TaskIcon", "Variants are generated lazily") {
+  TaskIcon icon{CreateFilledImage(4, 4, 0xffc86464)};
+  REQUIRE(icon.width() == 4);
+  REQUIRE(icon.height() == 4);
+  REQUIRE(icon.variant_count() == 0);
+  REQUIRE(icon.memory_usage() == 4 * 4 * sizeof(DATA32));
+
+  SECTION("identity adjustments return the original image") {
+    Imlib_Image original = icon.Get(util::imlib2::Asb{});
+    REQUIRE(original != nullptr);
+    REQUIRE(icon.Get(util::imlib2::Asb{}) == original);
+    REQUIRE(icon.variant_count() == 0);
+  }
+
+  SECTION("adjusted variants are generated once and reused") {
+    Imlib_Image original = icon.Get(util::imlib2::Asb{});
+    Imlib_Image variant = icon.Get(util::imlib2::Asb{50, 0, 10});
+    REQUIRE(variant != original);
+    REQUIRE(icon.variant_count() == 1);
+    REQUIRE(icon.Get(util::imlib2::Asb{50, 0, 10}) == variant);
+    REQUIRE(icon.variant_count() == 1);
+
+    imlib_context_set_image(variant);
+    REQUIRE(imlib_image_get_data()[0] == 0x7fe27171);
+  }
+
+  SECTION("only a bounded number of variants is kept") {
+    for (int alpha = 0; alpha < 10; ++alpha) {
+      icon.Get(util::imlib2::Asb{alpha * 10, 0, 0});
+    }
+    REQUIRE(icon.variant_count() == TaskIcon::kMaxVariants);
+  }
+}
+
+TEST_CASE("TaskIconCache", "Icons are shared and evicted") {
+  TaskIconCache cache{2};
+  TaskIconCache::Key key1{1, 1, 16, 16, 24};
+  TaskIconCache::Key key2{2, 2, 16, 16, 24};
+  TaskIconCache::Key key3{1, 1, 16, 16, 32};
+
+  REQUIRE(cache.Find(key1) == nullptr);
+
+  auto icon = std::make_shared<TaskIcon>(CreateFilledImage(24, 24, 0));
+  cache.Insert(key1, icon);
+  REQUIRE(cache.Find(key1) == icon);
+  REQUIRE(cache.Find(key3) == nullptr);
+
+  auto stats = cache.stats();
+  REQUIRE(stats.hits == 1);
+  REQUIRE(stats.misses == 2);
+  REQUIRE(stats.entries == 1);
+  REQUIRE(stats.memory_usage == icon->memory_usage());
+
+  cache.Insert(key2, std::make_shared<TaskIcon>(CreateFilledImage(24, 24, 0)));
+  cache.Insert(key3, std::make_shared<TaskIcon>(CreateFilledImage(32, 32, 0)));
+  stats = cache.stats();
+  REQUIRE(stats.entries == 2);
+  REQUIRE(stats.evictions == 1);
+  REQUIRE(cache.Find(key1) == nullptr);
+
+  // Evicted icons are still valid for whoever holds a reference.
+  REQUIRE(icon.use_count() == 1);
+  REQUIRE(icon->width() == 24);
+
+  cache.Clear();
+  REQUIRE(cache.stats().entries == 0);
+}
+
+TEST_CASE("TaskIconCacheCollisions", "Both hashes must match on a hit") {
+  TaskIconCache cache;
+  TaskIconCache::Key key{1, 1, 2, 2, 24};
+  auto icon = std::make_shared<TaskIcon>(CreateFilledImage(24, 24, 0));
+  cache.Insert(key, icon);
+  REQUIRE(cache.Find(key) == icon);
+
+  // Same hash and dimensions, but different pixels.
+  TaskIconCache::Key other{1, 2, 2, 2, 24};
+  REQUIRE(cache.Find(other) == nullptr);
+
+  auto stats = cache.stats();
+  REQUIRE(stats.hits == 1);
+  REQUIRE(stats.misses == 1);
+  REQUIRE(stats.memory_usage == icon->memory_usage());
+}
@@ -29,6 +29,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <list>
+#include <unordered_map>
 
 #include "panel.hh"
 #include "server.hh"
@@ -36,10 +37,99 @@
 #include "taskbar/taskbar.hh"
 #include "util/collection.hh"
 #include "util/log.hh"
+#include "util/lru_cache.hh"
 #include "util/window.hh"
 
 namespace {
 
+// how many desktops keep their tasks around in single desktop mode, including
+// the current one
+const size_t kWarmDesktops = 4;
+
+util::LruCache<unsigned int, bool> warm_desktops{kWarmDesktops};
+
+// windows without tasks, because their desktop's taskbar isn't materialized
+std::unordered_map<Window, unsigned int> dormant_windows;
+
+TaskList::KeyFunction SortKeyFunction(TaskbarSortOrder sort_order) {
+  switch (sort_order) {
+    case TaskbarSortOrder::kDesktop:
+      return [](Task* const& tsk) { return TaskSortKey{tsk->desktop, ""}; };
+    case TaskbarSortOrder::kTitle:
+      return [](Task* const& tsk) { return TaskSortKey{0, tsk->GetTitle()}; };
+    case TaskbarSortOrder::kClass:
+      return [](Task* const& tsk) {
+        return TaskSortKey{0, util::window::GetClass(tsk->win)};
+      };
+    case TaskbarSortOrder::kCreation:
+      return [](Task* const& tsk) {
+        return TaskSortKey{tsk->creation_order, ""};
+      };
+    default:
+      return nullptr;
+  }
+}
+
+// Gives the task states that weren't configured the look of the closest one
+// that was.
+void ResolveTaskStates(Global_task* g_task) {
+  if ((g_task->config_asb_mask & (1 << kTaskNormal)) == 0) {
+    g_task->alpha[kTaskNormal] = 100;
+    g_task->saturation[kTaskNormal] = 0;
+    g_task->brightness[kTaskNormal] = 0;
+  }
+
+  if ((g_task->config_asb_mask & (1 << kTaskActive)) == 0) {
+    g_task->alpha[kTaskActive] = g_task->alpha[kTaskNormal];
+    g_task->saturation[kTaskActive] = g_task->saturation[kTaskNormal];
+    g_task->brightness[kTaskActive] = g_task->brightness[kTaskNormal];
+  }
+
+  if ((g_task->config_asb_mask & (1 << kTaskIconified)) == 0) {
+    g_task->alpha[kTaskIconified] = g_task->alpha[kTaskNormal];
+    g_task->saturation[kTaskIconified] = g_task->saturation[kTaskNormal];
+    g_task->brightness[kTaskIconified] = g_task->brightness[kTaskNormal];
+  }
+
+  if ((g_task->config_asb_mask & (1 << kTaskUrgent)) == 0) {
+    g_task->alpha[kTaskUrgent] = g_task->alpha[kTaskActive];
+    g_task->saturation[kTaskUrgent] = g_task->saturation[kTaskActive];
+    g_task->brightness[kTaskUrgent] = g_task->brightness[kTaskActive];
+  }
+
+  if ((g_task->config_font_mask & (1 << kTaskNormal)) == 0) {
+    g_task->font[kTaskNormal] = Color{};
+  }
+
+  if ((g_task->config_font_mask & (1 << kTaskActive)) == 0) {
+    g_task->font[kTaskActive] = g_task->font[kTaskNormal];
+  }
+
+  if ((g_task->config_font_mask & (1 << kTaskIconified)) == 0) {
+    g_task->font[kTaskIconified] = g_task->font[kTaskNormal];
+  }
+
+  if ((g_task->config_font_mask & (1 << kTaskUrgent)) == 0) {
+    g_task->font[kTaskUrgent] = g_task->font[kTaskActive];
+  }
+
+  if ((g_task->config_background_mask & (1 << kTaskNormal)) == 0) {
+    g_task->background[kTaskNormal] = backgrounds.front();
+  }
+
+  if ((g_task->config_background_mask & (1 << kTaskActive)) == 0) {
+    g_task->background[kTaskActive] = g_task->background[kTaskNormal];
+  }
+
+  if ((g_task->config_background_mask & (1 << kTaskIconified)) == 0) {
+    g_task->background[kTaskIconified] = g_task->background[kTaskNormal];
+  }
+
+  if ((g_task->config_background_mask & (1 << kTaskUrgent)) == 0) {
+    g_task->background[kTaskUrgent] = g_task->background[kTaskActive];
+  }
+}
+
 bool FindWindow(Window const needle, Window const* const haystack,
                 int num_results) {
   for (int i = 0; i < num_results; i++) {
@@ -65,7 +155,7 @@ Task* task_drag;
 bool taskbar_enabled;
 
 Taskbar& Taskbar::SetState(size_t state) {
-  Panel const& panel = panels[0];
+  Panel const& panel = *panels[0];
   bg_ = panel.g_taskbar.background[state];
   pix_ = state_pixmap(state);
 
@@ -104,7 +194,6 @@ Taskbar& Taskbar::SetState(size_t state) {
 
 void DefaultTaskbar() {
   win_to_task_map.clear();
-  urgent_timeout.reset();
   urgent_list.clear();
   taskbar_enabled = false;
   Taskbarname::Default();
@@ -112,18 +201,23 @@ void DefaultTaskbar() {
 
 void CleanupTaskbar() {
   Taskbarname::Cleanup();
+  util::log::Debug() << task_icon_cache.stats() << '\n';
+  // the default icon may change along with the configuration
+  task_icon_cache.Clear();
 
   while (!win_to_task_map.empty()) {
     TaskbarRemoveTask(win_to_task_map.begin()->first);
   }
+  dormant_windows.clear();
+  warm_desktops.Clear();
 
-  for (Panel& panel : panels) {
-    for (unsigned int j = 0; j < panel.num_desktops_; ++j) {
-      Taskbar* tskbar = &panel.taskbars[j];
-      erase(panel.children_, tskbar);
+  for (auto& panel : panels) {
+    for (unsigned int j = 0; j < panel->num_desktops_; ++j) {
+      Taskbar* tskbar = &panel->taskbars[j];
+      erase(panel->children_, tskbar);
       tskbar->FreeArea();
     }
-    panel.taskbars.clear();
+    panel->taskbars.clear();
   }
 }
 
@@ -132,6 +226,46 @@ void InitTaskbar() {
   task_drag = nullptr;
 }
 
+bool TaskbarReloadTaskStates() {
+  Global_task const& config = panel_config.g_task;
+
+  for (auto& panel : panels) {
+    Global_task& g_task = panel->g_task;
+    int border_widths[kTaskStateCount];
+    for (int i = 0; i < kTaskStateCount; ++i) {
+      border_widths[i] = g_task.background[i].border().width();
+      g_task.alpha[i] = config.alpha[i];
+      g_task.saturation[i] = config.saturation[i];
+      g_task.brightness[i] = config.brightness[i];
+      g_task.font[i] = config.font[i];
+      g_task.background[i] = config.background[i];
+    }
+    g_task.config_asb_mask = config.config_asb_mask;
+    g_task.config_font_mask = config.config_font_mask;
+    g_task.config_background_mask = config.config_background_mask;
+    ResolveTaskStates(&g_task);
+    g_task.bg_ = g_task.background[kTaskNormal];
+
+    // borders take part in the layout of the tasks
+    for (int i = 0; i < kTaskStateCount; ++i) {
+      if (g_task.background[i].border().width() != border_widths[i]) {
+        return false;
+      }
+    }
+  }
+
+  for (auto& pair : win_to_task_map) {
+    for (Task* tsk : pair.second) {
+      if (tsk->current_state >= 0 && tsk->current_state < kTaskStateCount) {
+        tsk->bg_ = tsk->panel_->g_task.background[tsk->current_state];
+      }
+      SetTaskRedraw(tsk);
+    }
+  }
+  panel_refresh = true;
+  return true;
+}
+
 void Taskbar::InitPanel(Panel* panel) {
   // taskbar name
   panel->g_taskbar.bar_name.panel_ = panel;
@@ -167,70 +301,7 @@ void Taskbar::InitPanel(Panel* panel) {
   panel->g_task.need_resize_ = true;
   panel->g_task.on_screen_ = true;
 
-  if ((panel->g_task.config_asb_mask & (1 << kTaskNormal)) == 0) {
-    panel->g_task.alpha[kTaskNormal] = 100;
-    panel->g_task.saturation[kTaskNormal] = 0;
-    panel->g_task.brightness[kTaskNormal] = 0;
-  }
-
-  if ((panel->g_task.config_asb_mask & (1 << kTaskActive)) == 0) {
-    panel->g_task.alpha[kTaskActive] = panel->g_task.alpha[kTaskNormal];
-    panel->g_task.saturation[kTaskActive] =
-        panel->g_task.saturation[kTaskNormal];
-    panel->g_task.brightness[kTaskActive] =
-        panel->g_task.brightness[kTaskNormal];
-  }
-
-  if ((panel->g_task.config_asb_mask & (1 << kTaskIconified)) == 0) {
-    panel->g_task.alpha[kTaskIconified] = panel->g_task.alpha[kTaskNormal];
-    panel->g_task.saturation[kTaskIconified] =
-        panel->g_task.saturation[kTaskNormal];
-    panel->g_task.brightness[kTaskIconified] =
-        panel->g_task.brightness[kTaskNormal];
-  }
-
-  if ((panel->g_task.config_asb_mask & (1 << kTaskUrgent)) == 0) {
-    panel->g_task.alpha[kTaskUrgent] = panel->g_task.alpha[kTaskActive];
-    panel->g_task.saturation[kTaskUrgent] =
-        panel->g_task.saturation[kTaskActive];
-    panel->g_task.brightness[kTaskUrgent] =
-        panel->g_task.brightness[kTaskActive];
-  }
-
-  if ((panel->g_task.config_font_mask & (1 << kTaskNormal)) == 0) {
-    panel->g_task.font[kTaskNormal] = Color{};
-  }
-
-  if ((panel->g_task.config_font_mask & (1 << kTaskActive)) == 0) {
-    panel->g_task.font[kTaskActive] = panel->g_task.font[kTaskNormal];
-  }
-
-  if ((panel->g_task.config_font_mask & (1 << kTaskIconified)) == 0) {
-    panel->g_task.font[kTaskIconified] = panel->g_task.font[kTaskNormal];
-  }
-
-  if ((panel->g_task.config_font_mask & (1 << kTaskUrgent)) == 0) {
-    panel->g_task.font[kTaskUrgent] = panel->g_task.font[kTaskActive];
-  }
-
-  if ((panel->g_task.config_background_mask & (1 << kTaskNormal)) == 0) {
-    panel->g_task.background[kTaskNormal] = backgrounds.front();
-  }
-
-  if ((panel->g_task.config_background_mask & (1 << kTaskActive)) == 0) {
-    panel->g_task.background[kTaskActive] =
-        panel->g_task.background[kTaskNormal];
-  }
-
-  if ((panel->g_task.config_background_mask & (1 << kTaskIconified)) == 0) {
-    panel->g_task.background[kTaskIconified] =
-        panel->g_task.background[kTaskNormal];
-  }
-
-  if ((panel->g_task.config_background_mask & (1 << kTaskUrgent)) == 0) {
-    panel->g_task.background[kTaskUrgent] =
-        panel->g_task.background[kTaskActive];
-  }
+  ResolveTaskStates(&panel->g_task);
 
   if (panel->horizontal()) {
     panel->g_task.panel_y_ =
@@ -288,9 +359,15 @@ void Taskbar::InitPanel(Panel* panel) {
   taskbars.shrink_to_fit();
   std::fill(taskbars.begin(), taskbars.end(), panel->g_taskbar);
 
+  bool multi_desktop = (panel->taskbar_mode() == TaskbarMode::kMultiDesktop);
+  warm_desktops.Put(server.desktop(), true);
+
   for (unsigned int j = 0; j < panel->num_desktops_; j++) {
     Taskbar* tskbar = &taskbars[j];
     tskbar->desktop = j;
+    tskbar->sort_order_ = panel->taskbar_sort_order();
+    tskbar->tasks_.set_key_function(SortKeyFunction(tskbar->sort_order_));
+    tskbar->materialized_ = (multi_desktop || j == server.desktop());
     tskbar->bg_ = panel->g_taskbar.background[kTaskbarNormal];
     if (j == server.desktop()) {
       tskbar->bg_ = panel->g_taskbar.background[kTaskbarActive];
@@ -300,7 +377,106 @@ void Taskbar::InitPanel(Panel* panel) {
   Taskbarname::InitPanel(panel);
 }
 
-void TaskbarRemoveTask(Window win) { RemoveTask(TaskGetTask(win)); }
+bool Taskbar::materialized() const { return materialized_; }
+
+bool Taskbar::ActivateDesktop(unsigned int desktop, Timer& timer) {
+  if (!taskbar_enabled || panels.empty() ||
+      panels[0]->taskbar_mode() == TaskbarMode::kMultiDesktop) {
+    return false;
+  }
+
+  warm_desktops.Put(desktop, true);
+  bool changed = false;
+
+  for (auto& panel : panels) {
+    if (desktop >= panel->num_desktops_) {
+      continue;
+    }
+
+    Taskbar& tskbar = panel->taskbars[desktop];
+    if (tskbar.materialized_) {
+      continue;
+    }
+    tskbar.materialized_ = true;
+
+    // copies of the windows shown on all desktops
+    for (auto& pair : win_to_task_map) {
+      Task* tsk = pair.second.front();
+      if (tsk->desktop != kAllDesktops || tsk->panel_ != panel.get()) {
+        continue;
+      }
+
+      AddTaskCopy(*tsk, tskbar, timer);
+      changed = true;
+    }
+  }
+
+  // windows that were waiting for this desktop to come up
+  std::vector<Window> windows;
+  for (auto const& pair : dormant_windows) {
+    if (pair.second == desktop) {
+      windows.push_back(pair.first);
+    }
+  }
+  for (Window win : windows) {
+    dormant_windows.erase(win);
+    AddTask(win, timer);
+    changed = true;
+  }
+
+  // evict whatever isn't recent enough anymore
+  for (auto& panel : panels) {
+    for (Taskbar& tskbar : panel->taskbars) {
+      if (tskbar.materialized_ && tskbar.desktop != server.desktop() &&
+          !warm_desktops.Has(tskbar.desktop)) {
+        tskbar.Dematerialize();
+        changed = true;
+      }
+    }
+  }
+
+  if (changed) {
+    panel_refresh = true;
+  }
+  return changed;
+}
+
+void Taskbar::Dematerialize() {
+  util::log::Debug() << "Dematerialize taskbar for desktop " << desktop
+                     << '\n';
+
+  std::vector<Task*> tasks;
+  for (Area* child : filtered_children()) {
+    tasks.push_back(static_cast<Task*>(child));
+  }
+  for (Task* tsk : tasks) {
+    Window win = tsk->win;
+    unsigned int task_desktop = tsk->desktop;
+    if (RemoveTaskCopy(tsk)) {
+      TaskSetDormant(win, task_desktop);
+    }
+  }
+
+  materialized_ = false;
+  first_visible_task_ = 0;
+  for (int k = 0; k < kTaskbarCount; ++k) reset_state_pixmap(k);
+  pix_ = {};
+  need_resize_ = true;
+  need_redraw_ = true;
+}
+
+void TaskSetDormant(Window win, unsigned int desktop) {
+  dormant_windows[win] = desktop;
+}
+
+bool TaskIsDormant(Window win) { return dormant_windows.count(win) != 0; }
+
+void TaskbarRemoveTask(Window win) {
+  if (dormant_windows.erase(win) != 0) {
+    return;
+  }
+  RemoveTask(TaskGetTask(win));
+}
 
 Task* TaskGetTask(Window win) {
   auto const& task_group = TaskGetTasks(win);
@@ -345,6 +521,11 @@ void TaskRefreshTasklist(Timer& timer) {
       windows_to_remove.push_back(pair.first);
     }
   }
+  for (auto const& pair : dormant_windows) {
+    if (!FindWindow(pair.first, windows.get(), num_results)) {
+      windows_to_remove.push_back(pair.first);
+    }
+  }
 
   for (auto const& w : windows_to_remove) {
     TaskbarRemoveTask(w);
@@ -352,8 +533,9 @@ void TaskRefreshTasklist(Timer& timer) {
 
   // Add any new
   for (int i = 0; i < num_results; i++) {
-    if (!TaskGetTask(windows.get()[i])) {
-      AddTask(windows.get()[i], timer);
+    Window win = windows.get()[i];
+    if (!TaskGetTask(win) && !TaskIsDormant(win)) {
+      AddTask(win, timer);
     }
   }
 }
@@ -365,6 +547,9 @@ void Taskbar::DrawForeground(cairo_t* /* c */) {
 }
 
 bool Taskbar::Resize() {
+  SyncChildren();
+  UpdateOverflow();
+
   int horizontal_size =
       (panel_->g_task.text_posx + panel_->g_task.bg_.border().width() +
        panel_->g_task.padding_x_);
@@ -373,11 +558,11 @@ bool Taskbar::Resize() {
     ResizeByLayout(panel_->g_task.maximum_width);
 
     int new_width = panel_->g_task.maximum_width;
-    auto children = filtered_children();
-    auto it = std::begin(filtered_children());
-
-    if (it != std::end(children)) {
-      new_width = (*it)->width_;
+    for (Area* child : filtered_children()) {
+      if (child->on_screen_) {
+        new_width = child->width_;
+        break;
+      }
     }
 
     text_width_ = (new_width - horizontal_size);
@@ -390,14 +575,124 @@ bool Taskbar::Resize() {
   return false;
 }
 
+bool Taskbar::overflowing() const { return overflowing_; }
+
+bool Taskbar::Scroll(int pages) {
+  if (!overflowing_) {
+    return false;
+  }
+
+  long first = static_cast<long>(first_visible_task_) +
+               static_cast<long>(pages) * visible_task_count_;
+  first_visible_task_ = static_cast<size_t>(std::max(first, 0L));
+  // UpdateOverflow() takes care of clamping at the end
+  need_resize_ = true;
+  panel_refresh = true;
+  return true;
+}
+
+void Taskbar::ScrollToTask(Task* tsk) {
+  if (!overflowing_ || !CanShowTask(tsk)) {
+    return;
+  }
+
+  size_t index = 0;
+  for (Area* child : filtered_children()) {
+    auto other = static_cast<Task*>(child);
+    if (other == tsk) {
+      break;
+    }
+    if (CanShowTask(other)) {
+      ++index;
+    }
+  }
+
+  if (index < first_visible_task_) {
+    first_visible_task_ = index;
+  } else if (index >= first_visible_task_ + visible_task_count_) {
+    first_visible_task_ = index + 1 - visible_task_count_;
+  } else {
+    return;
+  }
+
+  need_resize_ = true;
+  panel_refresh = true;
+}
+
+bool Taskbar::CanShowTask(Task* tsk) const {
+  return tsk->desktop != kAllDesktops || desktop == server.desktop();
+}
+
+size_t Taskbar::AvailableTaskSlots() {
+  int size = (panel_->horizontal() ? width_ : height_) -
+             (2 * (padding_x_lr_ + bg_.border().width()));
+
+  if (taskbarname_enabled && bar_name.on_screen_) {
+    size -= (panel_->horizontal() ? bar_name.width_ : bar_name.height_) +
+            padding_x_;
+  }
+
+  int slot_size = panel_->g_task.minimum_size + padding_x_;
+  return std::max((size + padding_x_) / slot_size, 1);
+}
+
+void Taskbar::UpdateOverflow() {
+  if (panel_->g_task.minimum_size <= 0) {
+    return;
+  }
+
+  size_t num_tasks = 0;
+  for (Area* child : filtered_children()) {
+    if (CanShowTask(static_cast<Task*>(child))) {
+      ++num_tasks;
+    }
+  }
+
+  visible_task_count_ = AvailableTaskSlots();
+  overflowing_ = (num_tasks > visible_task_count_);
+  if (!overflowing_) {
+    first_visible_task_ = 0;
+    visible_task_count_ = num_tasks;
+  } else if (first_visible_task_ + visible_task_count_ > num_tasks) {
+    first_visible_task_ = num_tasks - visible_task_count_;
+  }
+
+  // only the current page is laid out and drawn: tasks out of it also release
+  // their pixmaps
+  size_t index = 0;
+  for (Area* child : filtered_children()) {
+    auto tsk = static_cast<Task*>(child);
+    bool visible = false;
+    if (CanShowTask(tsk)) {
+      visible = (index >= first_visible_task_ &&
+                 index < first_visible_task_ + visible_task_count_);
+      ++index;
+    }
+
+    if (tsk->on_screen_ && !visible) {
+      SetTaskRedraw(tsk);
+    }
+    tsk->on_screen_ = visible;
+  }
+}
+
+TaskList const& Taskbar::tasks() const { return tasks_; }
+
 util::iterator_range<std::vector<Area*>::iterator>
 Taskbar::filtered_children() {
+  SyncChildren();
   size_t offset = taskbarname_enabled ? 1 : 0;
   return util::range_skip_n(children_, offset);
 }
 
 bool Taskbar::RemoveChild(Area* child) {
-  if (Area::RemoveChild(child)) {
+  bool removed = false;
+  if (child != &bar_name) {
+    removed = tasks_.Erase(static_cast<Task*>(child));
+  }
+
+  // children_ must never point to deleted tasks, so it's updated right away
+  if (Area::RemoveChild(child) || removed) {
     need_resize_ = true;
     return true;
   }
@@ -405,11 +700,61 @@ bool Taskbar::RemoveChild(Area* child) {
   return false;
 }
 
+void Taskbar::AppendTask(Task* tsk) {
+  if (tasks_.PushBack(tsk)) {
+    tasks_changed_ = true;
+    need_resize_ = true;
+  }
+}
+
+void Taskbar::PrependTask(Task* tsk) {
+  if (tasks_.PushFront(tsk)) {
+    tasks_changed_ = true;
+    need_resize_ = true;
+  }
+}
+
+bool Taskbar::SwapTasks(Task* tsk1, Task* tsk2) {
+  if (sorted() || !tasks_.Swap(tsk1, tsk2)) {
+    return false;
+  }
+
+  tasks_changed_ = true;
+  need_resize_ = true;
+  return true;
+}
+
+void Taskbar::UpdateTaskOrder(Task* tsk) {
+  if (sorted() && tasks_.Update(tsk)) {
+    tasks_changed_ = true;
+    need_resize_ = true;
+  }
+}
+
+bool Taskbar::sorted() const { return sort_order_ != TaskbarSortOrder::kNone; }
+
+void Taskbar::SyncChildren() {
+  if (!tasks_changed_) {
+    return;
+  }
+  tasks_changed_ = false;
+
+  size_t offset = std::min<size_t>(taskbarname_enabled ? 1 : 0,
+                                   children_.size());
+  children_.erase(children_.begin() + offset, children_.end());
+  children_.insert(children_.end(), tasks_.begin(), tasks_.end());
+}
+
 void Taskbar::OnChangeLayout() {
   // reset Pixmap when position/size changed
   for (int k = 0; k < kTaskbarCount; ++k) reset_state_pixmap(k);
   pix_ = {};
   need_redraw_ = true;
+
+  // the tasks' renderings include the portion of taskbar behind them
+  for (Area* child : filtered_children()) {
+    SetTaskRedraw(static_cast<Task*>(child));
+  }
 }
 
 #ifdef _TINT3_DEBUG
@@ -1,12 +1,15 @@
 #ifndef TINT3_TASKBAR_TASKBAR_HH
 #define TINT3_TASKBAR_TASKBAR_HH
 
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "task.hh"
 #include "taskbarbase.hh"
 #include "taskbarname.hh"
+#include "util/indexed_list.hh"
 
 using TaskPtrArray = std::vector<Task*>;
 using WindowToTaskMap = std::unordered_map<Window, TaskPtrArray>;
@@ -16,6 +19,13 @@ extern Task* task_active;
 extern Task* task_drag;
 extern bool taskbar_enabled;
 
+enum class TaskbarSortOrder { kNone, kDesktop, kTitle, kClass, kCreation };
+
+// Tasks are sorted by this key, according to the panel's taskbar_sort_order,
+// and then by the order they were added or dragged in.
+using TaskSortKey = std::pair<unsigned long, std::string>;
+using TaskList = util::IndexedList<Task*, TaskSortKey>;
+
 // tint3 uses one taskbar per desktop.
 class Taskbar : public TaskbarBase {
  public:
@@ -28,9 +38,41 @@ class Taskbar : public TaskbarBase {
   void OnChangeLayout() override;
   bool Resize() override;
 
+  // The tasks, in display order. Use the methods below to alter the list:
+  // children_ is only brought in sync with them before the next layout, or
+  // when calling filtered_children().
+  TaskList const& tasks() const;
   util::iterator_range<std::vector<Area*>::iterator> filtered_children();
   bool RemoveChild(Area* child) override;
 
+  void AppendTask(Task* tsk);
+  void PrependTask(Task* tsk);
+  // Exchanges the position of two tasks. Returns false if the taskbar is
+  // sorted, in which case the order can't be changed manually.
+  bool SwapTasks(Task* tsk1, Task* tsk2);
+  // Repositions the task after a change in its sort key, such as its title.
+  void UpdateTaskOrder(Task* tsk);
+  bool sorted() const;
+
+  // Returns true if not all tasks fit at their minimum size, in which case only
+  // a page of them is laid out and drawn.
+  bool overflowing() const;
+  // Moves by the given number of pages through the tasks when overflowing.
+  // Returns false if there's nothing to scroll.
+  bool Scroll(int pages);
+  // Scrolls just enough to make the given task visible, if overflowing.
+  void ScrollToTask(Task* tsk);
+
+  // In single desktop mode, only the taskbars of the current and of the most
+  // recently visited desktops hold tasks: the others are empty until they're
+  // activated.
+  bool materialized() const;
+
+  // Fills the taskbars for the given desktop on all panels, if needed, and
+  // empties the ones that fell out of the set of recently visited desktops.
+  // Returns true if any task was added or removed.
+  static bool ActivateDesktop(unsigned int desktop, Timer& timer);
+
   static void InitPanel(Panel* panel);
 
 #ifdef _TINT3_DEBUG
@@ -38,6 +80,22 @@ class Taskbar : public TaskbarBase {
   std::string GetFriendlyName() const override;
 
 #endif  // _TINT3_DEBUG
+
+ private:
+  TaskList tasks_;
+  TaskbarSortOrder sort_order_ = TaskbarSortOrder::kNone;
+  bool tasks_changed_ = false;
+  bool materialized_ = true;
+  bool overflowing_ = false;
+  size_t first_visible_task_ = 0;
+  size_t visible_task_count_ = 0;
+
+  // tasks for windows on all desktops are only shown on the current one
+  bool CanShowTask(Task* tsk) const;
+  size_t AvailableTaskSlots();
+  void UpdateOverflow();
+  void Dematerialize();
+  void SyncChildren();
 };
 
 class Global_taskbar : public Taskbar {
@@ -56,6 +114,16 @@ void CleanupTaskbar();
 
 void InitTaskbar();
 
+// Applies the colors, icon adjustments and backgrounds of the task states in
+// panel_config to the running panels. Returns false if the tasks need to be
+// laid out again.
+bool TaskbarReloadTaskStates();
+
+// Windows on desktops whose taskbar isn't materialized are only tracked by id,
+// and get their tasks when the desktop is activated.
+void TaskSetDormant(Window win, unsigned int desktop);
+bool TaskIsDormant(Window win);
+
 void TaskbarRemoveTask(Window win);
 Task* TaskGetTask(Window win);
 TaskPtrArray TaskGetTasks(Window win);
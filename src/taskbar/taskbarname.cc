@@ -72,9 +72,9 @@ void Taskbarname::InitPanel(Panel* panel) {
 }
 
 void Taskbarname::Cleanup() {
-  for (Panel& panel : panels) {
-    for (unsigned int j = 0; j < panel.num_desktops_; j++) {
-      Taskbar& tskbar = panel.taskbars[j];
+  for (auto& panel : panels) {
+    for (unsigned int j = 0; j < panel->num_desktops_; j++) {
+      Taskbar& tskbar = panel->taskbars[j];
 
       tskbar.bar_name.FreeArea();
 
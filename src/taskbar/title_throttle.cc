@@ -0,0 +1,73 @@
+#include "taskbar/title_throttle.hh"
+
+#include <utility>
+
+TitleThrottle::TitleThrottle(Timer& timer, absl::Duration interval,
+                             Callback callback)
+    : timer_(timer), interval_(interval), callback_(std::move(callback)) {}
+
+TitleThrottle::~TitleThrottle() {
+  for (auto const& entry : windows_) {
+    if (entry.second.pending) {
+      timer_.ClearInterval(entry.second.pending);
+    }
+  }
+}
+
+void TitleThrottle::Notify(Window win) {
+  if (interval_ <= absl::ZeroDuration()) {
+    ++stats_.immediate;
+    callback_(win);
+    return;
+  }
+
+  WindowState& state = windows_[win];
+  if (state.pending) {
+    // the trailing update will pick up this change too
+    ++stats_.dropped;
+    return;
+  }
+
+  absl::Time now = timer_.Now();
+  absl::Duration elapsed = now - state.last_update;
+  if (elapsed >= interval_) {
+    state.last_update = now;
+    ++stats_.immediate;
+    callback_(win);
+    return;
+  }
+
+  ++stats_.deferred;
+  state.pending = timer_.SetTimeout(interval_ - elapsed, [this, win]() -> bool {
+    auto it = windows_.find(win);
+    if (it != windows_.end()) {
+      it->second.pending.reset();
+      it->second.last_update = timer_.Now();
+    }
+    callback_(win);
+    return false;
+  });
+}
+
+void TitleThrottle::Forget(Window win) {
+  auto it = windows_.find(win);
+  if (it == windows_.end()) {
+    return;
+  }
+  if (it->second.pending) {
+    timer_.ClearInterval(it->second.pending);
+  }
+  windows_.erase(it);
+}
+
+void TitleThrottle::set_interval(absl::Duration interval) {
+  interval_ = interval;
+}
+
+TitleThrottle::Stats const& TitleThrottle::stats() const { return stats_; }
+
+std::ostream& operator<<(std::ostream& os, TitleThrottle::Stats const& stats) {
+  return os << "TitleThrottle::Stats{immediate: " << stats.immediate
+            << ", deferred: " << stats.deferred
+            << ", dropped: " << stats.dropped << "}";
+}
@@ -0,0 +1,71 @@
+#ifndef TINT3_TASKBAR_TITLE_THROTTLE_HH
+#define TINT3_TASKBAR_TITLE_THROTTLE_HH
+
+#include <X11/Xlib.h>
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <unordered_map>
+
+#include "absl/time/time.h"
+
+#include "util/timer.hh"
+
+// Limits how often the title of a window is refreshed.
+//
+// Some applications (browsers, terminals showing progress, media players)
+// change their title many times per second, and each change costs a few
+// property fetches and a redraw of every copy of the task. The first change is
+// handled right away, but any further change within the given interval is
+// merged into a single trailing update, fired when the interval expires.
+class TitleThrottle {
+ public:
+  using Callback = std::function<void(Window)>;
+
+  struct Stats {
+    // changes handled right away
+    uint64_t immediate = 0;
+    // changes postponed to the end of the interval
+    uint64_t deferred = 0;
+    // changes superseded by a later one before being handled
+    uint64_t dropped = 0;
+  };
+
+  // A non-positive interval disables throttling altogether.
+  TitleThrottle(Timer& timer, absl::Duration interval, Callback callback);
+  ~TitleThrottle();
+
+  TitleThrottle(TitleThrottle const&) = delete;
+  TitleThrottle& operator=(TitleThrottle const&) = delete;
+
+  // Signals that the title of the given window has changed: the callback is
+  // either invoked immediately, or scheduled to be invoked later.
+  void Notify(Window win);
+
+  // Drops any state associated with the given window, including pending
+  // updates. Must be called when the window goes away.
+  void Forget(Window win);
+
+  // Changes the interval for the changes notified from now on: updates
+  // already scheduled keep their time.
+  void set_interval(absl::Duration interval);
+
+  Stats const& stats() const;
+
+ private:
+  struct WindowState {
+    absl::Time last_update = absl::InfinitePast();
+    Interval::Id pending;
+  };
+
+  Timer& timer_;
+  absl::Duration interval_;
+  Callback callback_;
+  std::unordered_map<Window, WindowState> windows_;
+  Stats stats_;
+};
+
+std::ostream& operator<<(std::ostream& os, TitleThrottle::Stats const& stats);
+
+#endif  // TINT3_TASKBAR_TITLE_THROTTLE_HH
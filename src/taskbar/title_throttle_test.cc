@@ -0,0 +1,103 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include "taskbar/title_throttle.hh"
+#include "util/timer.hh"
+#include "util/timer_test_utils.hh"
+
+TEST_CASE("TitleThrottle", "Bursts of title changes are coalesced") {
+  FakeClock fake_clock{0};
+  Timer timer{[&]() { return fake_clock.Now(); }};
+  std::vector<Window> updates;
+  TitleThrottle throttle{timer, absl::Milliseconds(100),
+                         [&](Window win) { updates.push_back(win); }};
+
+  SECTION("the first change is handled right away") {
+    throttle.Notify(1);
+    REQUIRE(updates == (std::vector<Window>{1}));
+    REQUIRE(throttle.stats().immediate == 1);
+    REQUIRE_FALSE(timer.GetNextInterval());
+  }
+
+  SECTION("changes within the interval are merged into a trailing update") {
+    throttle.Notify(1);
+    fake_clock.AdvanceBy(absl::Milliseconds(10));
+    throttle.Notify(1);
+    throttle.Notify(1);
+    throttle.Notify(1);
+    REQUIRE(updates.size() == 1);
+
+    fake_clock.AdvanceBy(absl::Milliseconds(50));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(updates.size() == 1);
+
+    fake_clock.AdvanceBy(absl::Milliseconds(40));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(updates == (std::vector<Window>{1, 1}));
+    REQUIRE(throttle.stats().immediate == 1);
+    REQUIRE(throttle.stats().deferred == 1);
+    REQUIRE(throttle.stats().dropped == 2);
+
+    // the trailing update starts a new interval
+    throttle.Notify(1);
+    REQUIRE(updates.size() == 2);
+    fake_clock.AdvanceBy(absl::Milliseconds(100));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(updates.size() == 3);
+  }
+
+  SECTION("changes after the interval are handled right away") {
+    throttle.Notify(1);
+    fake_clock.AdvanceBy(absl::Milliseconds(100));
+    throttle.Notify(1);
+    REQUIRE(updates.size() == 2);
+    REQUIRE(throttle.stats().immediate == 2);
+  }
+
+  SECTION("the interval can be changed on the fly") {
+    throttle.Notify(1);
+    throttle.set_interval(absl::Milliseconds(20));
+    fake_clock.AdvanceBy(absl::Milliseconds(20));
+    throttle.Notify(1);
+    REQUIRE(updates.size() == 2);
+
+    throttle.set_interval(absl::ZeroDuration());
+    throttle.Notify(1);
+    REQUIRE(updates.size() == 3);
+    REQUIRE(throttle.stats().immediate == 3);
+  }
+
+  SECTION("windows are throttled independently") {
+    throttle.Notify(1);
+    throttle.Notify(2);
+    throttle.Notify(1);
+    REQUIRE(updates == (std::vector<Window>{1, 2}));
+  }
+
+  SECTION("forgetting a window cancels its pending update") {
+    throttle.Notify(1);
+    throttle.Notify(1);
+    REQUIRE(timer.GetNextInterval());
+
+    throttle.Forget(1);
+    REQUIRE_FALSE(timer.GetNextInterval());
+    fake_clock.AdvanceBy(absl::Milliseconds(100));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(updates.size() == 1);
+  }
+}
+
+TEST_CASE("TitleThrottle::Disabled", "A zero interval disables throttling") {
+  FakeClock fake_clock{0};
+  Timer timer{[&]() { return fake_clock.Now(); }};
+  unsigned int updates = 0;
+  TitleThrottle throttle{timer, absl::ZeroDuration(),
+                         [&](Window) { ++updates; }};
+
+  for (int i = 0; i < 5; ++i) {
+    throttle.Notify(1);
+  }
+  REQUIRE(updates == 5);
+  REQUIRE_FALSE(timer.GetNextInterval());
+}
@@ -0,0 +1,101 @@
+#include "taskbar/urgent_blinker.hh"
+
+#include <utility>
+#include <vector>
+
+UrgentBlinker::UrgentBlinker(Timer& timer, absl::Duration period,
+                             Callback callback)
+    : timer_(timer), period_(period), callback_(std::move(callback)) {}
+
+UrgentBlinker::~UrgentBlinker() {
+  if (interval_) {
+    timer_.ClearInterval(interval_);
+  }
+}
+
+void UrgentBlinker::Add(Window win, unsigned int max_frames) {
+  WindowState& state = windows_[win];
+  state.frame = 0;
+  state.max_frames = max_frames;
+
+  if (!interval_) {
+    interval_ = timer_.SetInterval(period_, [this]() -> bool {
+      bool keep = Tick();
+      if (!keep) {
+        interval_.reset();
+      }
+      return keep;
+    });
+    if (!Tick()) {
+      timer_.ClearInterval(interval_);
+      interval_.reset();
+    }
+  }
+}
+
+void UrgentBlinker::Remove(Window win) {
+  if (windows_.erase(win) == 0) {
+    return;
+  }
+
+  // the timer callback stops the interval by itself
+  if (interval_ && !in_tick_ && !HasFramesLeft()) {
+    timer_.ClearInterval(interval_);
+    interval_.reset();
+  }
+}
+
+bool UrgentBlinker::Has(Window win) const { return windows_.count(win) != 0; }
+
+bool UrgentBlinker::blinking() const { return static_cast<bool>(interval_); }
+
+UrgentBlinker::Stats const& UrgentBlinker::stats() const { return stats_; }
+
+bool UrgentBlinker::Tick() {
+  ++stats_.ticks;
+  in_tick_ = true;
+
+  // the callback may add or remove windows
+  std::vector<Window> windows;
+  windows.reserve(windows_.size());
+  for (auto const& entry : windows_) {
+    windows.push_back(entry.first);
+  }
+
+  bool keep = false;
+  for (Window win : windows) {
+    auto it = windows_.find(win);
+    if (it != windows_.end() && ShowNextFrame(win, &it->second)) {
+      keep = true;
+    }
+  }
+
+  in_tick_ = false;
+  return keep;
+}
+
+bool UrgentBlinker::HasFramesLeft() const {
+  for (auto const& entry : windows_) {
+    if (entry.second.frame < entry.second.max_frames) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool UrgentBlinker::ShowNextFrame(Window win, WindowState* state) {
+  if (state->frame >= state->max_frames) {
+    return false;
+  }
+
+  bool urgent = (state->frame++ % 2) != 0;
+  bool more_frames = (state->frame < state->max_frames);
+  ++stats_.frames;
+  callback_(win, urgent);
+  return more_frames;
+}
+
+std::ostream& operator<<(std::ostream& os, UrgentBlinker::Stats const& stats) {
+  return os << "UrgentBlinker::Stats{ticks: " << stats.ticks
+            << ", frames: " << stats.frames << "}";
+}
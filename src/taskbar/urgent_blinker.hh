@@ -0,0 +1,75 @@
+#ifndef TINT3_TASKBAR_URGENT_BLINKER_HH
+#define TINT3_TASKBAR_URGENT_BLINKER_HH
+
+#include <X11/Xlib.h>
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <unordered_map>
+
+#include "absl/time/time.h"
+
+#include "util/timer.hh"
+
+// Drives the blinking of all the windows demanding attention from a single
+// periodic timer.
+//
+// On every tick each blinking window alternates between its normal and urgent
+// appearance, until it has done so the requested number of times; the window
+// then stays urgent, but no longer costs anything. The timer only runs while
+// at least one window is still blinking.
+class UrgentBlinker {
+ public:
+  // Invoked to show the urgent (true) or normal (false) frame of a window.
+  using Callback = std::function<void(Window, bool)>;
+
+  struct Stats {
+    // timer expirations
+    uint64_t ticks = 0;
+    // frames shown, over all windows
+    uint64_t frames = 0;
+  };
+
+  UrgentBlinker(Timer& timer, absl::Duration period, Callback callback);
+  ~UrgentBlinker();
+
+  UrgentBlinker(UrgentBlinker const&) = delete;
+  UrgentBlinker& operator=(UrgentBlinker const&) = delete;
+
+  // Starts blinking the given window, for the given number of frames. If the
+  // window is already known, its count starts over.
+  void Add(Window win, unsigned int max_frames);
+
+  // Stops tracking the given window.
+  void Remove(Window win);
+
+  bool Has(Window win) const;
+  // Returns true if the timer is running.
+  bool blinking() const;
+  Stats const& stats() const;
+
+ private:
+  struct WindowState {
+    unsigned int frame = 0;
+    unsigned int max_frames = 0;
+  };
+
+  Timer& timer_;
+  absl::Duration period_;
+  Callback callback_;
+  std::unordered_map<Window, WindowState> windows_;
+  Interval::Id interval_;
+  bool in_tick_ = false;
+  Stats stats_;
+
+  // Shows the next frame of each blinking window. Returns false once there
+  // are none left.
+  bool Tick();
+  bool ShowNextFrame(Window win, WindowState* state);
+  bool HasFramesLeft() const;
+};
+
+std::ostream& operator<<(std::ostream& os, UrgentBlinker::Stats const& stats);
+
+#endif  // TINT3_TASKBAR_URGENT_BLINKER_HH
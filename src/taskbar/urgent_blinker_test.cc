@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include <utility>
+#include <vector>
+
+#include "taskbar/urgent_blinker.hh"
+#include "util/timer.hh"
+#include "util/timer_test_utils.hh"
+
+namespace {
+
+using Frame = std::pair<Window, bool>;
+
+}  // namespace
+
+TEST_CASE("UrgentBlinker", "Windows blink from a shared timer") {
+  FakeClock fake_clock{0};
+  Timer timer{[&]() { return fake_clock.Now(); }};
+  std::vector<Frame> frames;
+  UrgentBlinker blinker{timer, absl::Seconds(1), [&](Window win, bool urgent) {
+                          frames.push_back(Frame{win, urgent});
+                        }};
+
+  SECTION("the first frame is shown right away") {
+    blinker.Add(1, 4);
+    REQUIRE(blinker.blinking());
+    REQUIRE(frames == (std::vector<Frame>{{1, false}}));
+
+    fake_clock.AdvanceBy(absl::Seconds(1));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(frames == (std::vector<Frame>{{1, false}, {1, true}}));
+  }
+
+  SECTION("the timer stops once all frames have been shown") {
+    blinker.Add(1, 3);
+    for (int i = 0; i < 5; ++i) {
+      fake_clock.AdvanceBy(absl::Seconds(1));
+      timer.ProcessExpiredIntervals();
+    }
+    REQUIRE(frames.size() == 3);
+    REQUIRE_FALSE(blinker.blinking());
+    REQUIRE_FALSE(timer.GetNextInterval());
+    // the window stays known until removed
+    REQUIRE(blinker.Has(1));
+    REQUIRE(blinker.stats().ticks == 3);
+
+    // adding it again starts over
+    blinker.Add(1, 2);
+    REQUIRE(blinker.blinking());
+    REQUIRE(frames.size() == 4);
+  }
+
+  SECTION("windows share the timer") {
+    blinker.Add(1, 4);
+    blinker.Add(2, 4);
+    fake_clock.AdvanceBy(absl::Seconds(1));
+    timer.ProcessExpiredIntervals();
+    REQUIRE(frames.size() == 3);
+    REQUIRE(blinker.stats().ticks == 2);
+    REQUIRE(blinker.stats().frames == 3);
+  }
+
+  SECTION("removing the last window stops the timer") {
+    blinker.Add(1, 4);
+    blinker.Add(2, 4);
+    blinker.Remove(1);
+    REQUIRE(blinker.blinking());
+    blinker.Remove(2);
+    REQUIRE_FALSE(blinker.blinking());
+    REQUIRE_FALSE(timer.GetNextInterval());
+  }
+
+  SECTION("no frames, no timer") {
+    blinker.Add(1, 0);
+    REQUIRE(frames.empty());
+    REQUIRE_FALSE(blinker.blinking());
+    REQUIRE_FALSE(timer.GetNextInterval());
+  }
+}
@@ -25,6 +25,7 @@
 #include <X11/Xutil.h>
 #include <X11/extensions/Xdamage.h>
 #include <X11/extensions/Xfixes.h>
+#include <X11/extensions/Xrandr.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <xsettings-client.h>
@@ -57,11 +58,18 @@
 #include "util/log.hh"
 #include "util/timer.hh"
 #include "util/window.hh"
+#include "util/worker_pool.hh"
 #include "util/xdg.hh"
 #include "version.hh"
 
 namespace {
 
+const size_t kIconWorkerThreads = 2;
+const absl::Duration kUrgentBlinkPeriod = absl::Seconds(1);
+// XRandR sends a burst of events for every change in the monitor layout: the
+// monitors are only detected again once it's over.
+const absl::Duration kMonitorUpdateDelay = absl::Milliseconds(100);
+
 void PrintVersion() {
 #ifdef _TINT3_DEBUG
   std::cout << "tint3 debug binary (built at " << GIT_BRANCH << "/"
@@ -77,9 +85,35 @@ void PrintUsage() {
 
 You can also use tint3 on the command line as a theme manager.
 Use `tint3 theme help` or `man 1 tint3` for usage information.
+
+Use `tint3 config compile [-c <config_file>]` to save a compiled snapshot of
+the configuration ahead of time, which is otherwise saved on first use.
 )EOF";
 }
 
+int ConfigCommand(int argc, char* argv[]) {
+  if (argc < 3 || strcmp(argv[2], "compile") != 0) {
+    util::log::Error() << "Usage: " << argv[0]
+                       << " config compile [-c <config_file>]\n";
+    return 1;
+  }
+
+  util::fs::Path user_config_dir, config_path;
+  config::Reader::GetDefaultPaths(&user_config_dir, &config_path);
+  for (int i = 3; i < argc; ++i) {
+    if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+      config_path = argv[++i];
+    }
+  }
+
+  config::Reader config_reader{&server};
+  if (!config_reader.Compile(config_path)) {
+    return 1;
+  }
+  std::cout << "Compiled \"" << config_path << "\".\n";
+  return 0;
+}
+
 }  // namespace
 
 // Drag and Drop state variables
@@ -405,13 +439,7 @@ void EventButtonMotionNotify(XEvent* e) {
   if (event_taskbar == task_drag->parent_) {
     // Swap the task_drag with the task on the event's location (if they differ)
     if (event_task != nullptr && event_task != task_drag) {
-      auto& children = event_taskbar->children_;
-      auto drag_iter = std::find(children.begin(), children.end(), task_drag);
-      auto task_iter = std::find(children.begin(), children.end(), event_task);
-
-      if (drag_iter != children.end() && task_iter != children.end()) {
-        std::iter_swap(drag_iter, task_iter);
-        event_taskbar->need_resize_ = true;
+      if (event_taskbar->SwapTasks(task_drag, event_task)) {
         task_dragged = true;
         panel_refresh = true;
       }
@@ -423,32 +451,22 @@ void EventButtonMotionNotify(XEvent* e) {
     }
 
     auto drag_taskbar = task_drag->parent_;
-    auto drag_taskbar_iter =
-        std::find(drag_taskbar->children_.begin(),
-                  drag_taskbar->children_.end(), task_drag);
+    drag_taskbar->RemoveChild(task_drag);
 
-    if (drag_taskbar_iter != drag_taskbar->children_.end()) {
-      drag_taskbar->children_.erase(drag_taskbar_iter);
-    }
+    // Move task to other desktop (but avoid the 'Window desktop changed' code
+    // in 'event_property_notify')
+    task_drag->parent_ = event_taskbar;
+    task_drag->desktop = event_taskbar->desktop;
 
     if (event_taskbar->panel_x_ > drag_taskbar->panel_x_ ||
         event_taskbar->panel_y_ > drag_taskbar->panel_y_) {
-      auto& children = event_taskbar->children_;
-      size_t i = (taskbarname_enabled) ? 1 : 0;
-      children.insert(children.begin() + i, task_drag);
+      event_taskbar->PrependTask(task_drag);
     } else {
-      event_taskbar->children_.push_back(task_drag);
+      event_taskbar->AppendTask(task_drag);
     }
 
-    // Move task to other desktop (but avoid the 'Window desktop changed' code
-    // in 'event_property_notify')
-    task_drag->parent_ = event_taskbar;
-    task_drag->desktop = event_taskbar->desktop;
-
     util::window::SetDesktop(task_drag->win, event_taskbar->desktop);
 
-    event_taskbar->need_resize_ = true;
-    drag_taskbar->need_resize_ = true;
     task_dragged = true;
     panel_refresh = true;
   }
@@ -494,6 +512,12 @@ void EventButtonRelease(XEvent* e) {
     }
   }
 
+  Taskbar* scrolled_taskbar = panel->FindTaskbarToScroll(e);
+  if (scrolled_taskbar != nullptr) {
+    scrolled_taskbar->Scroll(e->xbutton.button == 4 ? -1 : 1);
+    return;
+  }
+
   Taskbar* tskbar = panel->ClickTaskbar(e->xbutton.x, e->xbutton.y);
   if (!tskbar) {
     return;
@@ -524,6 +548,19 @@ void EventButtonRelease(XEvent* e) {
   WindowAction(panel->ClickTask(e->xbutton.x, e->xbutton.y), action);
 }
 
+void UpdateTaskTitle(Window win, Tooltip* tooltip) {
+  Task* tsk = TaskGetTask(win);
+  if (tsk == nullptr || !tsk->UpdateTitle()) {
+    return;
+  }
+
+  std::string title = tsk->GetTooltipText();
+  if (tooltip->IsBoundTo(tsk) && !title.empty()) {
+    tooltip->Update(tsk, nullptr, title);
+  }
+  panel_refresh = true;
+}
+
 void EventPropertyNotify(XEvent* e, Timer& timer, Tooltip* tooltip) {
   Window win = e->xproperty.window;
   Atom at = e->xproperty.atom;
@@ -540,9 +577,9 @@ void EventPropertyNotify(XEvent* e, Timer& timer, Tooltip* tooltip) {
       auto desktop_names = server.GetDesktopNames();
       auto it = desktop_names.begin();
 
-      for (Panel& panel : panels) {
-        for (unsigned int i = 0; i < panel.num_desktops_; ++i) {
-          Taskbar& tskbar = panel.taskbars[i];
+      for (auto& panel : panels) {
+        for (unsigned int i = 0; i < panel->num_desktops_; ++i) {
+          Taskbar& tskbar = panel->taskbars[i];
           std::string name = (*it++);
 
           if (tskbar.bar_name.name() != name) {
@@ -564,11 +601,11 @@ void EventPropertyNotify(XEvent* e, Timer& timer, Tooltip* tooltip) {
       CleanupTaskbar();
       InitTaskbar();
 
-      for (Panel& panel : panels) {
-        Taskbar::InitPanel(&panel);
-        panel.SetItemsOrder();
-        panel.UpdateTaskbarVisibility();
-        panel.need_resize_ = true;
+      for (auto& panel : panels) {
+        Taskbar::InitPanel(panel.get());
+        panel->SetItemsOrder();
+        panel->UpdateTaskbarVisibility();
+        panel->need_resize_ = true;
       }
 
       TaskRefreshTasklist(timer);
@@ -586,13 +623,17 @@ void EventPropertyNotify(XEvent* e, Timer& timer, Tooltip* tooltip) {
       util::log::Debug() << "Current desktop changed from " << old_desktop
                          << " to " << server.desktop() << '\n';
 
-      for (Panel& panel : panels) {
-        panel.taskbars[old_desktop].SetState(kTaskbarNormal);
-        panel.taskbars[server.desktop()].SetState(kTaskbarActive);
+      if (Taskbar::ActivateDesktop(server.desktop(), timer)) {
+        ActiveTask();
+      }
+
+      for (auto& panel : panels) {
+        panel->taskbars[old_desktop].SetState(kTaskbarNormal);
+        panel->taskbars[server.desktop()].SetState(kTaskbarActive);
         // check ALLDESKTOP task => resize taskbar
 
         if (server.num_desktops() > old_desktop) {
-          Taskbar& tskbar = panel.taskbars[old_desktop];
+          Taskbar& tskbar = panel->taskbars[old_desktop];
           for (Area* child : tskbar.filtered_children()) {
             auto tsk = static_cast<Task*>(child);
             if (tsk->desktop == kAllDesktops) {
@@ -603,11 +644,12 @@ void EventPropertyNotify(XEvent* e, Timer& timer, Tooltip* tooltip) {
           }
         }
 
-        Taskbar& tskbar = panel.taskbars[server.desktop()];
+        Taskbar& tskbar = panel->taskbars[server.desktop()];
         for (Area* child : tskbar.filtered_children()) {
           auto tsk = static_cast<Task*>(child);
           if (tsk->desktop == kAllDesktops) {
             tsk->on_screen_ = true;
+            tsk->UpdateIconGeometry();
             tskbar.need_resize_ = true;
           }
         }
@@ -625,14 +667,26 @@ void EventPropertyNotify(XEvent* e, Timer& timer, Tooltip* tooltip) {
     } else if (at == server.atom("_XROOTPMAP_ID") ||
                at == server.atom("_XROOTMAP_ID")) {
       // change Wallpaper
-      for (Panel& panel : panels) {
-        panel.SetBackground();
+      for (auto& panel : panels) {
+        panel->SetBackground();
       }
       panel_refresh = true;
     }
   } else {
     auto tsk = TaskGetTask(win);
 
+    if (!tsk && TaskIsDormant(win)) {
+      // the window may have moved to a desktop whose taskbar is shown, or
+      // should be ignored altogether
+      if (at == server.atom("_NET_WM_DESKTOP") ||
+          at == server.atom("_NET_WM_STATE")) {
+        TaskbarRemoveTask(win);
+        AddTask(win, timer);
+        panel_refresh = true;
+      }
+      return;
+    }
+
     if (!tsk) {
       if (at != server.atom("_NET_WM_STATE")) {
         return;
@@ -659,12 +713,10 @@ void EventPropertyNotify(XEvent* e, Timer& timer, Tooltip* tooltip) {
     // Window title changed
     if (at == server.atom("_NET_WM_VISIBLE_NAME") ||
         at == server.atom("_NET_WM_NAME") || at == server.atom("WM_NAME")) {
-      if (tsk->UpdateTitle()) {
-        std::string title = tsk->GetTooltipText();
-        if (tooltip->IsBoundTo(tsk) && !title.empty()) {
-          tooltip->Update(tsk, nullptr, title);
-        }
-        panel_refresh = true;
+      if (task_title_throttle != nullptr) {
+        task_title_throttle->Notify(win);
+      } else {
+        UpdateTaskTitle(win, tooltip);
       }
     }
     // Demand attention
@@ -734,12 +786,6 @@ void EventExpose(XEvent* e) {
 }
 
 void EventConfigureNotify(Window win, Timer& timer) {
-  // change in root window (xrandr)
-  if (win == server.root_window()) {
-    signal_pending = SIGUSR1;
-    return;
-  }
-
   // 'win' is a tray icon
   TrayWindow* traywin = systray.FindTrayWindow(win);
   if (traywin != nullptr) {
@@ -762,13 +808,11 @@ void EventConfigureNotify(Window win, Timer& timer) {
     return;
   }
 
-  Panel* p = tsk->panel_;
-
-  if (p->monitor().number != util::window::GetMonitor(win)) {
+  if (tsk->panel_ != FindPanelForWindow(win)) {
     RemoveTask(tsk);
     tsk = AddTask(win, timer);
 
-    if (win == util::window::GetActive()) {
+    if (tsk != nullptr && win == util::window::GetActive()) {
       tsk->SetState(kTaskActive);
       task_active = tsk;
     }
@@ -811,6 +855,10 @@ void DragAndDropPosition(XClientMessageEvent* e) {
                         &map_x, &map_y, &child);
 
   Panel* panel = GetPanel(e->window);
+  if (!panel) {
+    return;
+  }
+
   Task* task = panel->ClickTask(map_x, map_y);
 
   if (task) {
@@ -884,6 +932,8 @@ int main(int argc, char* argv[]) {
   // If invoked as a theme manager, simply delegate to theme_manager.cc.
   if (argc > 1 && std::string(argv[1]) == "theme")
     return ThemeManager(argc, argv);
+  if (argc > 1 && std::string(argv[1]) == "config")
+    return ConfigCommand(argc, argv);
 
 start:
   std::string config_path;
@@ -908,14 +958,46 @@ start:
     std::exit(1);
   }
 
+  util::x11::EventLoop event_loop(&server, timer);
+
+  if (!event_loop.IsAlive()) {
+    std::exit(1);
+  }
+
+  // Task icons are decoded in the background, and handed back to the event
+  // loop once ready.
+  util::WorkerPool icon_worker_pool{kIconWorkerThreads,
+                                    [&] { event_loop.WakeUp(); }};
+  event_loop.RegisterWakeUpHandler(
+      [&] { icon_worker_pool.ProcessCompleted(); });
+  task_icon_worker_pool = &icon_worker_pool;
+  ABSL_ATTRIBUTE_UNUSED auto reset_icon_worker_pool =
+      util::MakeScopedCallback([] { task_icon_worker_pool = nullptr; });
+
+  // All urgent tasks blink in sync
+  UrgentBlinker urgent_blinker{timer, kUrgentBlinkPeriod, BlinkUrgentTask};
+  task_urgent_blinker = &urgent_blinker;
+  ABSL_ATTRIBUTE_UNUSED auto reset_urgent_blinker =
+      util::MakeScopedCallback([&] {
+        util::log::Debug() << urgent_blinker.stats() << '\n';
+        task_urgent_blinker = nullptr;
+      });
+
   InitPanel(timer);
 
+  // Launcher icons are rebuilt as soon as their .desktop files change.
+  if (launcher_desktop_entry_cache.FileDescriptor() != -1) {
+    event_loop.RegisterFileDescriptorHandler(
+        launcher_desktop_entry_cache.FileDescriptor(),
+        LauncherReadDesktopEntryChanges);
+  }
+
 #ifdef _TINT3_DEBUG
 
   unsigned int panel_index = 0;
-  for (Panel& panel : panels) {
+  for (auto& panel : panels) {
     util::log::Debug() << "Panel " << (++panel_index) << ":\n";
-    panel.PrintTree();
+    panel->PrintTree();
   }
 
 #endif  // _TINT3_DEBUG
@@ -935,6 +1017,17 @@ start:
   // Tooltip
   Tooltip tooltip{&server, &timer};
 
+  // Title changes are rate limited per window
+  TitleThrottle title_throttle{
+      timer, absl::Milliseconds(new_panel_config.title_update_interval),
+      [&](Window win) { UpdateTaskTitle(win, &tooltip); }};
+  task_title_throttle = &title_throttle;
+  ABSL_ATTRIBUTE_UNUSED auto reset_title_throttle =
+      util::MakeScopedCallback([&] {
+        util::log::Debug() << title_throttle.stats() << '\n';
+        task_title_throttle = nullptr;
+      });
+
   // XDND initialization
   dnd_source_window = 0;
   dnd_target_window = 0;
@@ -944,12 +1037,6 @@ start:
   dnd_sent_request = 0;
   dnd_launcher_exec.clear();
 
-  util::x11::EventLoop event_loop(&server, timer);
-
-  if (!event_loop.IsAlive()) {
-    std::exit(1);
-  }
-
   // Setup a handler for child termination
   pending_children = false;
   SignalAction(SIGCHLD, [](int) { pending_children = true; });
@@ -957,12 +1044,15 @@ start:
   // Pointer to the Area that was last activated by a mouse effect.
   Area* previous_mouse_over_area = nullptr;
 
-  for (auto& panel : panels) {
-    XFixesSelectSelectionInput(server.dsp, panel.main_win_,
+  auto watch_compositor = [](Panel* panel) {
+    XFixesSelectSelectionInput(server.dsp, panel->main_win_,
                                server.atom("_NET_WM_CM_SCREEN"),
                                XFixesSetSelectionOwnerNotifyMask |
                                    XFixesSelectionWindowDestroyNotifyMask |
                                    XFixesSelectionClientCloseNotifyMask);
+  };
+  for (auto& panel : panels) {
+    watch_compositor(panel.get());
   }
 
   event_loop.RegisterHandler(
@@ -975,10 +1065,61 @@ start:
           return;
         }
 
-        // Compositing was enabled or disabled, reinitialize the panel
-        signal_pending = SIGUSR1;
+        // Compositing was enabled or disabled: the windows are replaced by
+        // ones using the matching visual, everything else is kept as is
+        if (!server.InitVisual()) {
+          return;
+        }
+        imlib_context_set_visual(server.visual);
+        imlib_context_set_colormap(server.colormap);
+        tooltip.UpdateVisual();
+        UpdatePanelVisual();
+        for (auto& p : panels) {
+          watch_compositor(p.get());
+        }
       });
 
+  // Follow changes in the monitor layout, recreating only the panels on the
+  // monitors that were added or removed
+  bool monitor_update_pending = false;
+  auto schedule_monitor_update = [&] {
+    if (monitor_update_pending) {
+      return;
+    }
+    monitor_update_pending = true;
+    timer.SetTimeout(kMonitorUpdateDelay, [&]() -> bool {
+      monitor_update_pending = false;
+      std::vector<Panel*> new_panels;
+      if (UpdatePanelMonitors(timer, &new_panels)) {
+        // whatever was under the pointer may be gone
+        tooltip.Hide();
+        previous_mouse_over_area = nullptr;
+        for (Panel* panel : new_panels) {
+          watch_compositor(panel);
+        }
+      }
+      return false;
+    });
+  };
+
+  int xrandr_event, xrandr_error;
+  if (XRRQueryExtension(server.dsp, &xrandr_event, &xrandr_error)) {
+    XRRSelectInput(server.dsp, server.root_window(),
+                   RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask |
+                       RROutputChangeNotifyMask);
+
+    event_loop.RegisterHandler(
+        xrandr_event + RRScreenChangeNotify, [&](XEvent& e) {
+          // keeps the screen size known to Xlib up to date
+          XRRUpdateConfiguration(&e);
+          schedule_monitor_update();
+        });
+    event_loop.RegisterHandler(xrandr_event + RRNotify,
+                               [&](XEvent&) { schedule_monitor_update(); });
+  } else {
+    util::log::Error() << "Couldn't initialize XRANDR.\n";
+  }
+
   event_loop.RegisterHandler(ButtonPress, [&](XEvent& e) {
     tooltip.Hide();
     EventButtonPress(&e);
@@ -1014,7 +1155,12 @@ start:
       EventButtonMotionNotify(&e);
     }
 
+    // the panel window may have been replaced since the event was sent
     Panel* panel = GetPanel(e.xmotion.window);
+    if (!panel) {
+      return;
+    }
+
     Area* area = panel->InnermostAreaUnderPoint(e.xmotion.x, e.xmotion.y);
     std::string text = area->GetTooltipText();
     if (text.empty()) {
@@ -1046,7 +1192,12 @@ start:
     EventPropertyNotify(&e, timer, &tooltip);
   });
 
-  event_loop.RegisterHandler(ConfigureNotify, [&timer](XEvent& e) {
+  event_loop.RegisterHandler(ConfigureNotify, [&](XEvent& e) {
+    // change in root window (xrandr)
+    if (e.xconfigure.window == server.root_window()) {
+      schedule_monitor_update();
+      return;
+    }
     EventConfigureNotify(e.xconfigure.window, timer);
   });
 
@@ -1130,13 +1281,20 @@ start:
     XDamageNotifyEvent* ev = reinterpret_cast<XDamageNotifyEvent*>(&e);
     TrayWindow* traywin = systray.FindTrayWindow(ev->drawable);
     if (traywin != nullptr) {
-      systray.RenderIcon(traywin, timer);
+      systray.RenderDamage(traywin, timer);
     }
   });
 
-  if (event_loop.RunLoop()) {
-    // Reinitialize tint3.
+  while (event_loop.RunLoop()) {
+    // Reload the configuration, and reinitialize tint3 unless the changes
+    // could be applied to the running panels.
     if (signal_pending == SIGUSR1) {
+      if (config_reader.Reload() !=
+          config::Reader::ReloadResult::kRestartNeeded) {
+        signal_pending = 0;
+        panel_refresh = true;
+        continue;
+      }
       goto start;  // brrr
     }
     // Try to replace the process with a new instance of itself.
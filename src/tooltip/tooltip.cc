@@ -16,7 +16,15 @@ Tooltip::Tooltip(Server* server, Timer* timer)
       timer_(timer),
       area_(nullptr),
       font_desc_(tooltip_config.font_desc),
-      window_(None) {
+      window_(CreateWindow()) {}
+
+Tooltip::~Tooltip() {
+  if (window_ != None) {
+    XDestroyWindow(server_->dsp, window_);
+  }
+}
+
+Window Tooltip::CreateWindow() const {
   XSetWindowAttributes attr;
   attr.override_redirect = True;
   attr.event_mask = StructureNotifyMask;
@@ -26,15 +34,9 @@ Tooltip::Tooltip(Server* server, Timer* timer)
   unsigned long mask = CWEventMask | CWColormap | CWBorderPixel | CWBackPixel |
                        CWOverrideRedirect;
 
-  window_ = util::x11::CreateWindow(server_->root_window(), 0, 0, 100, 20, 0,
-                                    server_->depth, InputOutput,
-                                    server_->visual, mask, &attr);
-}
-
-Tooltip::~Tooltip() {
-  if (window_ != None) {
-    XDestroyWindow(server_->dsp, window_);
-  }
+  return util::x11::CreateWindow(server_->root_window(), 0, 0, 100, 20, 0,
+                                 server_->depth, InputOutput, server_->visual,
+                                 mask, &attr);
 }
 
 Window Tooltip::window() const { return window_; }
@@ -223,3 +225,13 @@ void Tooltip::Hide() {
         return false;
       });
 }
+
+void Tooltip::UpdateVisual() {
+  if (timeout_) {
+    timer_->ClearInterval(timeout_);
+    timeout_.reset();
+  }
+  area_ = nullptr;
+  XDestroyWindow(server_->dsp, window_);
+  window_ = CreateWindow();
+}
@@ -52,6 +52,10 @@ class Tooltip {
   // Area and unmaps the tooltip window from the screen.
   void Hide();
 
+  // UpdateVisual replaces the tooltip window with one using the current visual
+  // and depth of the server, hiding the tooltip at once.
+  void UpdateVisual();
+
  private:
   Server* server_;
   Timer* timer_;
@@ -60,6 +64,7 @@ class Tooltip {
   Window window_;
   Interval::Id timeout_;
 
+  Window CreateWindow() const;
   void GetExtents(std::string const& text, int* x, int* y, int* width,
                   int* height);
   void DrawBackground(cairo_t* c, int width, int height);
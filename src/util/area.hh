@@ -19,6 +19,7 @@ enum class SizeMode { kByLayout, kByContent };
 
 // Allowed mouse states.
 enum class MouseState { kMouseNormal, kMouseOver, kMousePressed };
+constexpr int kMouseStateCount = 3;
 
 class Panel;
 class Area {
@@ -156,7 +156,7 @@ TEST_CASE_METHOD(AreaTestFixture, "Draw") {
   ConcreteArea area;
   area.panel_x_ = 0;
   area.panel_y_ = 0;
-  area.panel_ = &panels.at(0);
+  area.panel_ = panels.at(0).get();
 
   SECTION("zero width") {
     area.width_ = 0;
@@ -194,7 +194,7 @@ TEST_CASE_METHOD(AreaTestFixture, "Refresh") {
   area.need_redraw_ = true;
   area.panel_x_ = 0;
   area.panel_y_ = 0;
-  area.panel_ = &panels.at(0);
+  area.panel_ = panels.at(0).get();
 
   SECTION("zero width") {
     area.width_ = 0;
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "util/argb.hh"
+
+namespace util {
+
+namespace {
+
+// The source pixels contributing to a destination pixel along one axis,
+// starting from the given one, with their integer weights.
+struct Taps {
+  unsigned int first;
+  std::vector<uint32_t> weights;
+  uint32_t total;
+};
+
+// Shrinking averages the source pixels covered by each destination pixel,
+// while enlarging interpolates linearly between the two source pixels
+// closest to its center, so that edges don't turn blocky.
+std::vector<Taps> ComputeTaps(unsigned int source_size, unsigned int size) {
+  std::vector<Taps> taps(size);
+  for (unsigned int d = 0; d < size; ++d) {
+    Taps& t = taps[d];
+    if (size <= source_size) {
+      unsigned int s0 = (uint64_t{d} * source_size) / size;
+      unsigned int s1 = (uint64_t{d + 1} * source_size) / size;
+      s1 = std::max(s1, s0 + 1);
+      t.first = s0;
+      t.weights.assign(s1 - s0, 1);
+      t.total = s1 - s0;
+      continue;
+    }
+
+    // the center of d, (d + 0.5) * source_size / size - 0.5 in source
+    // coordinates, as a fraction over 2 * size
+    uint32_t denominator = 2 * size;
+    int64_t numerator = int64_t{2 * d + 1} * source_size - size;
+    numerator = std::max<int64_t>(numerator, 0);
+    t.first = numerator / denominator;
+    uint32_t fraction = numerator % denominator;
+    if (fraction == 0 || t.first + 1 == source_size) {
+      t.weights = {1};
+      t.total = 1;
+    } else {
+      t.weights = {denominator - fraction, fraction};
+      t.total = denominator;
+    }
+  }
+  return taps;
+}
+
+}  // namespace
+
+ArgbImage::ArgbImage() : width(0), height(0) {}
+
+ArgbImage::ArgbImage(unsigned int width, unsigned int height)
+    : width(width), height(height), pixels(width * height, 0) {}
+
+bool ArgbImage::empty() const { return width == 0 || height == 0; }
+
+bool operator==(ArgbImage const& lhs, ArgbImage const& rhs) {
+  return lhs.width == rhs.width && lhs.height == rhs.height &&
+         lhs.pixels == rhs.pixels;
+}
+
+ArgbImage ScaleArgbImage(ArgbImage const& source, unsigned int width,
+                         unsigned int height) {
+  if (source.empty() || width == 0 || height == 0) {
+    return ArgbImage{};
+  }
+
+  if (source.width == width && source.height == height) {
+    return source;
+  }
+
+  std::vector<Taps> columns = ComputeTaps(source.width, width);
+  std::vector<Taps> rows = ComputeTaps(source.height, height);
+  ArgbImage result{width, height};
+
+  for (unsigned int dy = 0; dy < height; ++dy) {
+    Taps const& row_taps = rows[dy];
+
+    for (unsigned int dx = 0; dx < width; ++dx) {
+      Taps const& column_taps = columns[dx];
+
+      uint64_t sum_a = 0, sum_r = 0, sum_g = 0, sum_b = 0;
+      for (unsigned int i = 0; i < row_taps.weights.size(); ++i) {
+        uint32_t const* row =
+            &source.pixels[(row_taps.first + i) * source.width];
+        for (unsigned int j = 0; j < column_taps.weights.size(); ++j) {
+          uint32_t pixel = row[column_taps.first + j];
+          uint64_t a = uint64_t{(pixel >> 24) & 0xff} * row_taps.weights[i] *
+                       column_taps.weights[j];
+          sum_a += a;
+          sum_r += a * ((pixel >> 16) & 0xff);
+          sum_g += a * ((pixel >> 8) & 0xff);
+          sum_b += a * (pixel & 0xff);
+        }
+      }
+
+      if (sum_a == 0) {
+        continue;
+      }
+
+      uint64_t total = uint64_t{row_taps.total} * column_taps.total;
+      uint32_t a = (sum_a + total / 2) / total;
+      uint32_t r = (sum_r + sum_a / 2) / sum_a;
+      uint32_t g = (sum_g + sum_a / 2) / sum_a;
+      uint32_t b = (sum_b + sum_a / 2) / sum_a;
+      result.pixels[dy * width + dx] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+  }
+
+  return result;
+}
+
+}  // namespace util
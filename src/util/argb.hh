@@ -0,0 +1,38 @@
+#ifndef TINT3_UTIL_ARGB_HH
+#define TINT3_UTIL_ARGB_HH
+
+#include <cstdint>
+#include <vector>
+
+namespace util {
+
+// A plain, non-premultiplied ARGB image, laid out in the same way as Imlib2
+// and _NET_WM_ICON data: one 32 bit pixel per element, row by row.
+//
+// Unlike Imlib2 images, these don't depend on any global context, so they can
+// be safely processed outside of the event loop thread.
+struct ArgbImage {
+  ArgbImage();
+  ArgbImage(unsigned int width, unsigned int height);
+
+  bool empty() const;
+
+  unsigned int width;
+  unsigned int height;
+  std::vector<uint32_t> pixels;
+};
+
+bool operator==(ArgbImage const& lhs, ArgbImage const& rhs);
+
+// Returns a copy of the image resized to the given dimensions.
+// Along each axis, pixels are averaged over the area they cover in the source
+// image when shrinking, and interpolated bilinearly when enlarging. Either way
+// they're weighted by their alpha channel, so that transparent pixels don't
+// bleed their color into the result. The computation is done in integer
+// arithmetic, so the output only depends on the input.
+ArgbImage ScaleArgbImage(ArgbImage const& source, unsigned int width,
+                         unsigned int height);
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_ARGB_HH
@@ -0,0 +1,75 @@
+#include "catch.hpp"
+
+#include "util/argb.hh"
+
+TEST_CASE("ScaleArgbImage", "Resizing ARGB buffers") {
+  SECTION("empty inputs or outputs produce an empty image") {
+    util::ArgbImage source{2, 2};
+    REQUIRE(util::ScaleArgbImage(util::ArgbImage{}, 2, 2).empty());
+    REQUIRE(util::ScaleArgbImage(source, 0, 2).empty());
+    REQUIRE(util::ScaleArgbImage(source, 2, 0).empty());
+  }
+
+  SECTION("same size is a copy") {
+    util::ArgbImage source{2, 1};
+    source.pixels = {0xff102030, 0x80405060};
+    REQUIRE(util::ScaleArgbImage(source, 2, 1) == source);
+  }
+
+  SECTION("downscaling averages the covered area") {
+    util::ArgbImage source{2, 2};
+    source.pixels = {0xff000000, 0xff0000ff, 0xff00ff00, 0xffff0000};
+
+    util::ArgbImage result = util::ScaleArgbImage(source, 1, 1);
+    REQUIRE(result.width == 1);
+    REQUIRE(result.height == 1);
+    REQUIRE(result.pixels == (std::vector<uint32_t>{0xff404040}));
+  }
+
+  SECTION("transparent pixels don't bleed their color") {
+    util::ArgbImage source{2, 1};
+    source.pixels = {0x00ffffff, 0xff0000ff};
+
+    util::ArgbImage result = util::ScaleArgbImage(source, 1, 1);
+    REQUIRE(result.pixels == (std::vector<uint32_t>{0x800000ff}));
+  }
+
+  SECTION("fully transparent areas stay transparent") {
+    util::ArgbImage source{2, 2};
+    source.pixels = {0x00ffffff, 0x00ffffff, 0x00ffffff, 0x00ffffff};
+
+    util::ArgbImage result = util::ScaleArgbImage(source, 1, 1);
+    REQUIRE(result.pixels == (std::vector<uint32_t>{0}));
+  }
+
+  SECTION("upscaling interpolates between neighboring pixels") {
+    util::ArgbImage source{2, 1};
+    source.pixels = {0xff000000, 0xff000080};
+
+    util::ArgbImage result = util::ScaleArgbImage(source, 4, 2);
+    REQUIRE(result.pixels == (std::vector<uint32_t>{
+                                 0xff000000, 0xff000020, 0xff000060, 0xff000080,
+                                 0xff000000, 0xff000020, 0xff000060, 0xff000080,
+                             }));
+  }
+
+  SECTION("upscaling doesn't bleed transparent colors either") {
+    util::ArgbImage source{2, 1};
+    source.pixels = {0x00ffffff, 0xff0000ff};
+
+    util::ArgbImage result = util::ScaleArgbImage(source, 4, 1);
+    REQUIRE(result.pixels == (std::vector<uint32_t>{
+                                 0x00000000, 0x400000ff, 0xbf0000ff, 0xff0000ff,
+                             }));
+  }
+
+  SECTION("each axis is scaled on its own") {
+    util::ArgbImage source{2, 2};
+    source.pixels = {0xff000000, 0xff000080, 0xff000080, 0xff000080};
+
+    util::ArgbImage result = util::ScaleArgbImage(source, 1, 4);
+    REQUIRE(result.pixels == (std::vector<uint32_t>{
+                                 0xff000040, 0xff000050, 0xff000070, 0xff000080,
+                             }));
+  }
+}
@@ -1,8 +1,11 @@
+#include <fcntl.h>
 #include <libgen.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <sstream>
@@ -100,6 +103,67 @@ bool DirectoryContents::iterator::operator!=(
   return (dir_ != other.dir_ || pos_ != other.pos_);
 }
 
+MappedFile::MappedFile(std::string const& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      data_ = static_cast<char const*>(data);
+      size_ = info.st_size;
+    }
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+bool MappedFile::valid() const { return data_ != nullptr; }
+
+char const* MappedFile::data() const { return data_; }
+
+size_t MappedFile::size() const { return size_; }
+
+bool MappedFile::ReadBigEndian(size_t offset, uint16_t* value) const {
+  unsigned char bytes[2];
+  if (!Read(offset, &bytes)) {
+    return false;
+  }
+  *value = (bytes[0] << 8) | bytes[1];
+  return true;
+}
+
+bool MappedFile::ReadBigEndian(size_t offset, uint32_t* value) const {
+  unsigned char bytes[4];
+  if (!Read(offset, &bytes)) {
+    return false;
+  }
+  *value = (static_cast<uint32_t>(bytes[0]) << 24) | (bytes[1] << 16) |
+           (bytes[2] << 8) | bytes[3];
+  return true;
+}
+
+bool MappedFile::ReadString(size_t offset, absl::string_view* value) const {
+  if (offset >= size_) {
+    return false;
+  }
+  char const* begin = data_ + offset;
+  void const* end = std::memchr(begin, '\0', size_ - offset);
+  if (end == nullptr) {
+    return false;
+  }
+  *value = absl::string_view(begin, static_cast<char const*>(end) - begin);
+  return true;
+}
+
 namespace {
 
 absl::string_view StripTrailingSlash(absl::string_view path) {
@@ -260,6 +324,18 @@ bool WriteFile(std::string const& path, absl::string_view content) {
   return true;
 }
 
+bool WriteFileAtomically(std::string const& path, absl::string_view content) {
+  std::string temporary_path = absl::StrCat(path, ".", getpid());
+  if (!WriteFile(temporary_path, content)) {
+    return false;
+  }
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    Unlink(temporary_path);
+    return false;
+  }
+  return true;
+}
+
 bool ReadFile(std::string const& path, std::string* output) {
   return ReadFile(path, [=](std::string const& contents) {
     output->assign(contents);
@@ -5,6 +5,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
 #include <ostream>
@@ -55,6 +57,43 @@ class DirectoryContents {
   DIR* dir_;
 };
 
+// A read-only memory mapping of a whole file, with bounds checked accessors.
+class MappedFile {
+ public:
+  // Maps the given file; valid() returns false if that fails, or if the file
+  // is empty.
+  explicit MappedFile(std::string const& path);
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  bool valid() const;
+  char const* data() const;
+  size_t size() const;
+
+  // Copies a value from the given offset, in native byte order.
+  template <typename T>
+  bool Read(size_t offset, T* value) const {
+    if (offset > size_ || size_ - offset < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(value, data_ + offset, sizeof(T));
+    return true;
+  }
+
+  // Reads a big endian value from the given offset.
+  bool ReadBigEndian(size_t offset, uint16_t* value) const;
+  bool ReadBigEndian(size_t offset, uint32_t* value) const;
+
+  // Reads a NUL-terminated string, which must end within the file.
+  bool ReadString(size_t offset, absl::string_view* value) const;
+
+ private:
+  char const* data_ = nullptr;
+  size_t size_ = 0;
+};
+
 class Path {
  public:
   friend std::ostream& operator<<(std::ostream& os, Path const& path);
@@ -100,6 +139,9 @@ bool FileExists(std::initializer_list<std::string> parts);
 bool IsSymbolicLink(std::string const& path);
 Path HomeDirectory();
 bool WriteFile(std::string const& path, absl::string_view content);
+// Writes a temporary file next to the given path first, then renames it over
+// the path, so that readers never get to see a partially written file.
+bool WriteFileAtomically(std::string const& path, absl::string_view content);
 bool ReadFile(std::string const& path, std::string* output);
 bool ReadFile(std::string const& path,
               std::function<bool(std::string const&)> const& fn);
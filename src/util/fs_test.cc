@@ -12,6 +12,7 @@
 #include <utility>
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 
 #include "behavior_control.hh"
 #include "util/environment.hh"
@@ -131,6 +132,22 @@ TEST_CASE("WriteFile") {
   unlink(temp_path.c_str());
 }
 
+TEST_CASE("WriteFileAtomically") {
+  static const std::string temp_path =
+      "src/util/testdata/fs_test_write_file_atomically.tmp";
+  REQUIRE(util::fs::WriteFile(temp_path, "old contents"));
+  REQUIRE(util::fs::WriteFileAtomically(temp_path, "new contents"));
+
+  std::string actual_content;
+  REQUIRE(util::fs::ReadFile(temp_path, &actual_content));
+  REQUIRE(actual_content == "new contents");
+  // the temporary file is gone
+  REQUIRE_FALSE(util::fs::FileExists(
+      absl::StrCat(temp_path, ".", static_cast<long>(getpid()))));
+
+  unlink(temp_path.c_str());
+}
+
 class ReadFileCallback {
  public:
   ReadFileCallback() : invoked_(false) {}
@@ -240,6 +257,31 @@ TEST_CASE("SetSystemInterface") {
   REQUIRE(fake_interface == &fake_fs);
 }
 
+TEST_CASE("MappedFile") {
+  SECTION("missing file") {
+    util::fs::MappedFile file{"/none"};
+    REQUIRE_FALSE(file.valid());
+    char c;
+    REQUIRE_FALSE(file.Read(0, &c));
+  }
+
+  SECTION("reads are bounds checked") {
+    util::fs::MappedFile file{"src/util/testdata/fs_test.txt"};
+    REQUIRE(file.valid());
+    REQUIRE(absl::StartsWith(absl::string_view(file.data(), file.size()),
+                             "Name:\tcat\n"));
+
+    uint32_t value;
+    REQUIRE(file.ReadBigEndian(0, &value));
+    REQUIRE(value == 0x4e616d65);  // "Name"
+    REQUIRE_FALSE(file.ReadBigEndian(file.size() - 2, &value));
+
+    absl::string_view line;
+    REQUIRE_FALSE(file.ReadString(0, &line));
+    REQUIRE_FALSE(file.ReadString(file.size(), &line));
+  }
+}
+
 TEST_CASE("DirectoryContents") {
   // Update this if the content of src/util/testdata changes.
   std::set<std::string> expected_set;
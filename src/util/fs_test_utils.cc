@@ -1,5 +1,30 @@
 #include "util/fs_test_utils.hh"
 
+#include <algorithm>
+
+namespace {
+
+constexpr char kTempTemplate[] = "/tmp/tint3_test.XXXXXX";
+
+}  // namespace
+
+void RemoveTree(std::string const& path) {
+  struct stat info;
+  if (lstat(path.c_str(), &info) != 0) {
+    return;
+  }
+  if (S_ISDIR(info.st_mode)) {
+    for (std::string const& name : util::fs::DirectoryContents{path}) {
+      if (!name.empty() && name != "." && name != "..") {
+        RemoveTree(util::fs::BuildPath({path, name}));
+      }
+    }
+    rmdir(path.c_str());
+  } else {
+    unlink(path.c_str());
+  }
+}
+
 bool FakeFileSystemInterface::stat(std::string const& path, struct stat* buf) {
   auto response = stat_responses.find(path);
   if (response == stat_responses.end()) return false;
@@ -30,3 +55,17 @@ bool FakeFileSystemInterface::unlink(std::string const& path) {
   response->second.pop_front();
   return result;
 }
+
+TempDirectory::TempDirectory() {
+  char path[sizeof(kTempTemplate)];
+  std::copy(kTempTemplate, kTempTemplate + sizeof(kTempTemplate), path);
+  path_ = mkdtemp(path);
+}
+
+TempDirectory::~TempDirectory() { RemoveTree(path_); }
+
+std::string TempDirectory::operator/(std::string const& name) const {
+  return util::fs::BuildPath({path_, name});
+}
+
+std::string const& TempDirectory::path() const { return path_; }
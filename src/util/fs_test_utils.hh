@@ -38,4 +38,24 @@ struct FakeFileSystemInterface : public util::fs::SystemInterface {
   std::unordered_map<std::string, std::list<bool>> unlink_responses;
 };
 
+// Removes the given file, or directory along with its contents.
+void RemoveTree(std::string const& path);
+
+// A fresh directory under /tmp, removed along with its contents on
+// destruction.
+class TempDirectory {
+ public:
+  TempDirectory();
+  ~TempDirectory();
+
+  TempDirectory(TempDirectory const&) = delete;
+  TempDirectory& operator=(TempDirectory const&) = delete;
+
+  std::string operator/(std::string const& name) const;
+  std::string const& path() const;
+
+ private:
+  std::string path_;
+};
+
 #endif  // TINT3_UTIL_FS_TEST_UTILS_HH
@@ -0,0 +1,33 @@
+#include "util/hash.hh"
+
+namespace util {
+
+namespace {
+
+constexpr uint64_t kPrime = 0x100000001b3ULL;
+
+}  // namespace
+
+void Fnv1aHasher::Add(absl::string_view bytes) {
+  for (unsigned char c : bytes) {
+    hash_ ^= c;
+    hash_ *= kPrime;
+  }
+}
+
+void Fnv1aHasher::Add(uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    hash_ ^= (value >> shift) & 0xff;
+    hash_ *= kPrime;
+  }
+}
+
+uint64_t Fnv1aHasher::hash() const { return hash_; }
+
+uint64_t Fnv1aHash(absl::string_view bytes) {
+  Fnv1aHasher hasher;
+  hasher.Add(bytes);
+  return hasher.hash();
+}
+
+}  // namespace util
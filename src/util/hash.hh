@@ -0,0 +1,29 @@
+#ifndef TINT3_UTIL_HASH_HH
+#define TINT3_UTIL_HASH_HH
+
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+namespace util {
+
+// 64 bit FNV-1a, see: http://www.isthe.com/chongo/tech/comp/fnv/
+// It's quick and spreads similar inputs well, which is all the caches need;
+// it's no good against deliberate collisions.
+class Fnv1aHasher {
+ public:
+  void Add(absl::string_view bytes);
+  // Adds the four bytes of value, least significant first.
+  void Add(uint32_t value);
+
+  uint64_t hash() const;
+
+ private:
+  uint64_t hash_ = 0xcbf29ce484222325ULL;
+};
+
+uint64_t Fnv1aHash(absl::string_view bytes);
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_HASH_HH
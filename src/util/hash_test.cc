@@ -0,0 +1,27 @@
+#include "catch.hpp"
+
+#include <cstdint>
+
+#include "util/hash.hh"
+
+TEST_CASE("Fnv1aHash") {
+  // reference values from the FNV test suite
+  REQUIRE(util::Fnv1aHash("") == 0xcbf29ce484222325ULL);
+  REQUIRE(util::Fnv1aHash("a") == 0xaf63dc4c8601ec8cULL);
+  REQUIRE(util::Fnv1aHash("foobar") == 0x85944171f73967e8ULL);
+}
+
+TEST_CASE("Fnv1aHasher") {
+  SECTION("pieces hash like the whole") {
+    util::Fnv1aHasher hasher;
+    hasher.Add("foo");
+    hasher.Add("bar");
+    REQUIRE(hasher.hash() == util::Fnv1aHash("foobar"));
+  }
+
+  SECTION("integers are added least significant byte first") {
+    util::Fnv1aHasher hasher;
+    hasher.Add(uint32_t{0x64636261});
+    REQUIRE(hasher.hash() == util::Fnv1aHash("abcd"));
+  }
+}
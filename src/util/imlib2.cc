@@ -9,15 +9,6 @@ namespace imlib2 {
 
 namespace {
 
-class ScopedCurrentImageRestorer {
- public:
-  ScopedCurrentImageRestorer() : image_(imlib_context_get_image()) {}
-  ~ScopedCurrentImageRestorer() { imlib_context_set_image(image_); }
-
- private:
-  Imlib_Image image_;
-};
-
 Imlib_Image CloneImlib2Image(Imlib_Image other_image) {
   if (!other_image) {
     return nullptr;
@@ -29,11 +20,32 @@ Imlib_Image CloneImlib2Image(Imlib_Image other_image) {
 
 }  // namespace
 
+ScopedCurrentImageRestorer::ScopedCurrentImageRestorer()
+    : image_(imlib_context_get_image()) {}
+
+ScopedCurrentImageRestorer::~ScopedCurrentImageRestorer() {
+  imlib_context_set_image(image_);
+}
+
+Asb::Asb(int alpha, int saturation, int brightness)
+    : alpha(alpha), saturation(saturation), brightness(brightness) {}
+
+bool Asb::IsIdentity() const {
+  return alpha == 100 && saturation == 0 && brightness == 0;
+}
+
+bool operator==(Asb const& lhs, Asb const& rhs) {
+  return lhs.alpha == rhs.alpha && lhs.saturation == rhs.saturation &&
+         lhs.brightness == rhs.brightness;
+}
+
+bool operator!=(Asb const& lhs, Asb const& rhs) { return !(lhs == rhs); }
+
 Image::Image(Imlib_Image image) : image_(image) {}
 
 Image::Image(Image const& other) : image_(CloneImlib2Image(other.image_)) {}
 
-Image::Image(Image&& other) : image_(std::move(other.image_)) {}
+Image::Image(Image&& other) : image_(other.image_) { other.image_ = nullptr; }
 
 Image::~Image() { Free(); }
 
@@ -62,6 +74,12 @@ void Image::AdjustASB(int alpha, float saturation_adjustment,
   }
 }
 
+void Image::AdjustASB(Asb const& asb) {
+  if (!asb.IsIdentity()) {
+    AdjustASB(asb.alpha, asb.saturation / 100.0f, asb.brightness / 100.0f);
+  }
+}
+
 void Image::Free() {
   if (image_ != nullptr) {
     ScopedCurrentImageRestorer restorer;
@@ -6,6 +6,36 @@
 namespace util {
 namespace imlib2 {
 
+// Alpha/saturation/brightness adjustment, expressed in the same units used by
+// the configuration file: alpha goes from 0 to 100, saturation and brightness
+// go from -100 to 100.
+struct Asb {
+  Asb(int alpha = 100, int saturation = 0, int brightness = 0);
+
+  bool IsIdentity() const;
+
+  int alpha;
+  int saturation;
+  int brightness;
+};
+
+bool operator==(Asb const& lhs, Asb const& rhs);
+bool operator!=(Asb const& lhs, Asb const& rhs);
+
+// Restores the current imlib2 context image on destruction.
+class ScopedCurrentImageRestorer {
+ public:
+  ScopedCurrentImageRestorer();
+  ~ScopedCurrentImageRestorer();
+
+  ScopedCurrentImageRestorer(ScopedCurrentImageRestorer const&) = delete;
+  ScopedCurrentImageRestorer& operator=(ScopedCurrentImageRestorer const&) =
+      delete;
+
+ private:
+  Imlib_Image image_;
+};
+
 class Image {
  public:
   Image(Imlib_Image image = nullptr);
@@ -19,6 +49,7 @@ class Image {
 
   void AdjustASB(int alpha, float saturation_adjustment,
                  float brightness_adjustment);
+  void AdjustASB(Asb const& asb);
   void Free();
 
   static Image CloneExisting(Imlib_Image other_image);
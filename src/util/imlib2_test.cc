@@ -67,6 +67,29 @@ TEST_CASE("imlib2::Image::AdjustASB", "Adjustment in place works") {
   REQUIRE(adjusted_data == original_data);  // data was not reallocated
 }
 
+TEST_CASE("imlib2::Asb", "Identity and comparison") {
+  using util::imlib2::Asb;
+
+  REQUIRE(Asb{}.IsIdentity());
+  REQUIRE_FALSE((Asb{50, 0, 0}.IsIdentity()));
+  REQUIRE((Asb{100, 10, -10} == Asb{100, 10, -10}));
+  REQUIRE((Asb{100, 10, -10} != Asb{100, -10, 10}));
+
+  // An identity adjustment doesn't touch the pixel data.
+  util::imlib2::Image image{imlib_create_image(1, 1)};
+  imlib_context_set_image(image);
+  imlib_image_set_has_alpha(1);
+  DATA32* data = imlib_image_get_data();
+  data[0] = 0xffc86464;
+  imlib_image_put_back_data(data);
+
+  image.AdjustASB(Asb{});
+  REQUIRE(imlib_image_get_data()[0] == 0xffc86464);
+
+  image.AdjustASB(Asb{50, 0, 10});
+  REQUIRE(imlib_image_get_data()[0] == 0x7fe27171);
+}
+
 TEST_CASE("imlib2::Image::CloneExisting",
           "Returns an Image object holding a clone of the given Imlib_Image") {
   static constexpr unsigned int const width = 10;
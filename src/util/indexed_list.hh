@@ -0,0 +1,215 @@
+#ifndef TINT3_UTIL_INDEXED_LIST_HH
+#define TINT3_UTIL_INDEXED_LIST_HH
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+namespace util {
+
+// Implements an ordered sequence of unique values, with logarithmic time
+// insertion, removal, reordering and neighbour lookups.
+//
+// Values are sorted by the key returned by the key function, if one is set,
+// and by insertion order (possibly altered through Swap()) among equal keys.
+// Without a key function all values compare equal, and the list behaves as a
+// plain sequence. Update() must be called whenever a value's key changes.
+template <typename T, typename Key, typename Hash = std::hash<T>>
+class IndexedList {
+  struct Node {
+    Key key;
+    long long sequence;
+    T value;
+  };
+
+  struct NodeLess {
+    bool operator()(Node const& lhs, Node const& rhs) const {
+      if (lhs.key < rhs.key) return true;
+      if (rhs.key < lhs.key) return false;
+      return lhs.sequence < rhs.sequence;
+    }
+  };
+
+  using NodeSet = std::set<Node, NodeLess>;
+
+ public:
+  using KeyFunction = std::function<Key(T const&)>;
+
+  class const_iterator
+      : public std::iterator<std::bidirectional_iterator_tag, T const> {
+   public:
+    const_iterator() = default;
+    explicit const_iterator(typename NodeSet::const_iterator it) : it_(it) {}
+
+    T const& operator*() const { return it_->value; }
+    T const* operator->() const { return &it_->value; }
+
+    const_iterator& operator++() {
+      ++it_;
+      return (*this);
+    }
+    const_iterator& operator--() {
+      --it_;
+      return (*this);
+    }
+    bool operator==(const_iterator const& other) const {
+      return it_ == other.it_;
+    }
+    bool operator!=(const_iterator const& other) const {
+      return it_ != other.it_;
+    }
+
+   private:
+    typename NodeSet::const_iterator it_;
+  };
+
+  explicit IndexedList(KeyFunction key_function = nullptr)
+      : key_function_(std::move(key_function)) {}
+
+  IndexedList(IndexedList const& other)
+      : key_function_(other.key_function_),
+        nodes_(other.nodes_),
+        front_sequence_(other.front_sequence_),
+        back_sequence_(other.back_sequence_) {
+    RebuildIndex();
+  }
+
+  IndexedList& operator=(IndexedList const& other) {
+    key_function_ = other.key_function_;
+    nodes_ = other.nodes_;
+    front_sequence_ = other.front_sequence_;
+    back_sequence_ = other.back_sequence_;
+    RebuildIndex();
+    return (*this);
+  }
+
+  // Changes the sorting criteria, reordering the existing values.
+  void set_key_function(KeyFunction key_function) {
+    key_function_ = std::move(key_function);
+
+    NodeSet nodes;
+    for (Node const& node : nodes_) {
+      nodes.insert(Node{KeyOf(node.value), node.sequence, node.value});
+    }
+    nodes_.swap(nodes);
+    RebuildIndex();
+  }
+
+  // Inserts a value after (PushBack) or before (PushFront) the ones with an
+  // equal key. Returns false if the value is already in the list.
+  bool PushBack(T const& value) { return Insert(value, back_sequence_++); }
+  bool PushFront(T const& value) { return Insert(value, front_sequence_--); }
+
+  bool Erase(T const& value) {
+    auto it = index_.find(value);
+    if (it == index_.end()) {
+      return false;
+    }
+    nodes_.erase(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  bool Contains(T const& value) const { return index_.count(value) != 0; }
+
+  // Repositions the value after its key has changed.
+  bool Update(T const& value) {
+    auto it = index_.find(value);
+    if (it == index_.end()) {
+      return false;
+    }
+    long long sequence = it->second->sequence;
+    nodes_.erase(it->second);
+    it->second = nodes_.insert(Node{KeyOf(value), sequence, value}).first;
+    return true;
+  }
+
+  // Exchanges the insertion order of two values. This is only reflected in
+  // the iteration order if they have equal keys.
+  bool Swap(T const& lhs, T const& rhs) {
+    auto lhs_it = index_.find(lhs);
+    auto rhs_it = index_.find(rhs);
+    if (lhs_it == index_.end() || rhs_it == index_.end()) {
+      return false;
+    }
+    if (lhs_it == rhs_it) {
+      return true;
+    }
+
+    Node lhs_node = *lhs_it->second;
+    Node rhs_node = *rhs_it->second;
+    std::swap(lhs_node.sequence, rhs_node.sequence);
+    nodes_.erase(lhs_it->second);
+    nodes_.erase(rhs_it->second);
+    lhs_it->second = nodes_.insert(std::move(lhs_node)).first;
+    rhs_it->second = nodes_.insert(std::move(rhs_node)).first;
+    return true;
+  }
+
+  // Return the values following and preceding the given one, or nullptr if
+  // there's none, or the value isn't in the list.
+  T const* Next(T const& value) const {
+    auto it = index_.find(value);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    auto next = std::next(it->second);
+    return (next != nodes_.end()) ? &next->value : nullptr;
+  }
+
+  T const* Previous(T const& value) const {
+    auto it = index_.find(value);
+    if (it == index_.end() || it->second == nodes_.begin()) {
+      return nullptr;
+    }
+    return &std::prev(it->second)->value;
+  }
+
+  T const* front() const { return empty() ? nullptr : &nodes_.begin()->value; }
+  T const* back() const { return empty() ? nullptr : &nodes_.rbegin()->value; }
+
+  void Clear() {
+    index_.clear();
+    nodes_.clear();
+  }
+
+  size_t size() const { return nodes_.size(); }
+  bool empty() const { return nodes_.empty(); }
+
+  const_iterator begin() const { return const_iterator{nodes_.begin()}; }
+  const_iterator end() const { return const_iterator{nodes_.end()}; }
+
+ private:
+  KeyFunction key_function_;
+  NodeSet nodes_;
+  std::unordered_map<T, typename NodeSet::const_iterator, Hash> index_;
+  long long front_sequence_ = -1;
+  long long back_sequence_ = 0;
+
+  Key KeyOf(T const& value) const {
+    return key_function_ ? key_function_(value) : Key{};
+  }
+
+  bool Insert(T const& value, long long sequence) {
+    if (Contains(value)) {
+      return false;
+    }
+    auto it = nodes_.insert(Node{KeyOf(value), sequence, value}).first;
+    index_.insert(std::make_pair(value, it));
+    return true;
+  }
+
+  void RebuildIndex() {
+    index_.clear();
+    for (auto it = nodes_.begin(); it != nodes_.end(); ++it) {
+      index_.insert(std::make_pair(it->value, it));
+    }
+  }
+};
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_INDEXED_LIST_HH
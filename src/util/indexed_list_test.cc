@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util/indexed_list.hh"
+
+namespace {
+
+template <typename T, typename K>
+std::vector<T> Values(util::IndexedList<T, K> const& list) {
+  return std::vector<T>(list.begin(), list.end());
+}
+
+}  // namespace
+
+TEST_CASE("IndexedList::Insertion", "Values keep their insertion order") {
+  util::IndexedList<int, int> list;
+  REQUIRE(list.empty());
+
+  REQUIRE(list.PushBack(2));
+  REQUIRE(list.PushBack(3));
+  REQUIRE(list.PushFront(1));
+  REQUIRE_FALSE(list.PushBack(3));
+  REQUIRE(list.size() == 3);
+  REQUIRE(Values(list) == (std::vector<int>{1, 2, 3}));
+  REQUIRE(*list.front() == 1);
+  REQUIRE(*list.back() == 3);
+
+  REQUIRE(list.Erase(2));
+  REQUIRE_FALSE(list.Erase(2));
+  REQUIRE_FALSE(list.Contains(2));
+  REQUIRE(Values(list) == (std::vector<int>{1, 3}));
+
+  list.Clear();
+  REQUIRE(list.empty());
+  REQUIRE(list.front() == nullptr);
+}
+
+TEST_CASE("IndexedList::Neighbours", "Next and previous values are found") {
+  util::IndexedList<int, int> list;
+  list.PushBack(1);
+  list.PushBack(2);
+  list.PushBack(3);
+
+  REQUIRE(*list.Next(1) == 2);
+  REQUIRE(*list.Next(2) == 3);
+  REQUIRE(list.Next(3) == nullptr);
+  REQUIRE(list.Previous(1) == nullptr);
+  REQUIRE(*list.Previous(3) == 2);
+  REQUIRE(list.Next(4) == nullptr);
+  REQUIRE(list.Previous(4) == nullptr);
+}
+
+TEST_CASE("IndexedList::Swap", "Swapping alters the order of equal keys") {
+  util::IndexedList<int, int> list;
+  list.PushBack(1);
+  list.PushBack(2);
+  list.PushBack(3);
+
+  REQUIRE(list.Swap(1, 3));
+  REQUIRE(Values(list) == (std::vector<int>{3, 2, 1}));
+  REQUIRE(*list.Next(3) == 2);
+  REQUIRE_FALSE(list.Swap(1, 4));
+
+  // the copy has its own index
+  util::IndexedList<int, int> copy{list};
+  list.Clear();
+  REQUIRE(copy.Swap(3, 2));
+  REQUIRE(Values(copy) == (std::vector<int>{2, 3, 1}));
+}
+
+TEST_CASE("IndexedList::Keys", "Values are sorted by key") {
+  std::vector<std::string> names{"c", "a", "b", "a"};
+  util::IndexedList<int, std::string> list{
+      [&](int const& i) { return names[i]; }};
+
+  for (int i = 0; i < 4; ++i) {
+    list.PushBack(i);
+  }
+  // equal keys are in insertion order
+  REQUIRE(Values(list) == (std::vector<int>{1, 3, 2, 0}));
+
+  SECTION("keys can be updated") {
+    names[0] = "0";
+    REQUIRE(list.Update(0));
+    REQUIRE(Values(list) == (std::vector<int>{0, 1, 3, 2}));
+  }
+
+  SECTION("the sort order can be changed") {
+    list.set_key_function(nullptr);
+    REQUIRE(Values(list) == (std::vector<int>{0, 1, 2, 3}));
+    list.set_key_function([&](int const& i) { return names[3 - i]; });
+    REQUIRE(Values(list) == (std::vector<int>{0, 2, 1, 3}));
+  }
+}
@@ -0,0 +1,105 @@
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "util/inotify.hh"
+#include "util/log.hh"
+
+namespace util {
+
+namespace {
+
+constexpr uint32_t kWatchedEvents = IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE |
+                                    IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+}  // namespace
+
+Inotify::Inotify() : fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+  if (fd_ == -1) {
+    util::log::Error() << "Failed to initialize inotify: "
+                       << std::strerror(errno) << '\n';
+  }
+}
+
+Inotify::~Inotify() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+bool Inotify::IsAlive() const { return fd_ != -1; }
+
+int Inotify::FileDescriptor() const { return fd_; }
+
+bool Inotify::Watch(std::string const& directory) {
+  if (!IsAlive()) {
+    return false;
+  }
+
+  int wd =
+      inotify_add_watch(fd_, directory.c_str(), kWatchedEvents | IN_ONLYDIR);
+  if (wd == -1) {
+    return false;
+  }
+  directories_[wd] = directory;
+  return true;
+}
+
+bool Inotify::IsWatched(std::string const& directory) const {
+  return std::any_of(directories_.begin(), directories_.end(),
+                     [&](std::pair<const int, std::string> const& entry) {
+                       return entry.second == directory;
+                     });
+}
+
+void Inotify::Unwatch(std::string const& directory) {
+  for (auto it = directories_.begin(); it != directories_.end(); ++it) {
+    if (it->second == directory) {
+      // the resulting IN_IGNORED event is skipped, as the descriptor is gone
+      inotify_rm_watch(fd_, it->first);
+      directories_.erase(it);
+      return;
+    }
+  }
+}
+
+void Inotify::ReadPendingEvents(Callback const& callback) {
+  if (!IsAlive()) {
+    return;
+  }
+
+  alignas(struct inotify_event) char buffer[4096];
+  while (true) {
+    ssize_t length = read(fd_, buffer, sizeof(buffer));
+    if (length <= 0) {
+      if (length == -1 && errno != EAGAIN) {
+        util::log::Error() << "Failed reading inotify events: "
+                           << std::strerror(errno) << '\n';
+      }
+      break;
+    }
+
+    for (char* p = buffer; p < buffer + length;) {
+      auto event = reinterpret_cast<struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + event->len;
+
+      auto it = directories_.find(event->wd);
+      if (it == directories_.end()) {
+        continue;
+      }
+      if (event->mask & IN_IGNORED) {
+        // the directory was removed, or unmounted
+        directories_.erase(it);
+        continue;
+      }
+      if (event->len > 0) {
+        callback(it->second, event->name);
+      }
+    }
+  }
+}
+
+}  // namespace util
@@ -0,0 +1,48 @@
+#ifndef TINT3_UTIL_INOTIFY_HH
+#define TINT3_UTIL_INOTIFY_HH
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace util {
+
+// Watches directories for files being created, changed, moved or removed.
+//
+// The file descriptor becomes readable when there are pending changes, so it
+// can be waited on by the event loop; it's non-blocking, so reading the
+// changes never stalls it.
+class Inotify {
+ public:
+  // Receives the directory, and the name of the file in it, that changed.
+  using Callback =
+      std::function<void(std::string const& directory, std::string const&)>;
+
+  Inotify();
+  Inotify(Inotify const&) = delete;
+  ~Inotify();
+
+  Inotify& operator=(Inotify const&) = delete;
+
+  bool IsAlive() const;
+  int FileDescriptor() const;
+
+  // Starts watching the given directory, which must exist. Returns false if
+  // it can't be watched.
+  bool Watch(std::string const& directory);
+  bool IsWatched(std::string const& directory) const;
+  // Stops watching the given directory, if it was watched.
+  void Unwatch(std::string const& directory);
+
+  // Runs the callback for each of the pending changes.
+  void ReadPendingEvents(Callback const& callback);
+
+ private:
+  int fd_;
+  // watch descriptor -> directory
+  std::unordered_map<int, std::string> directories_;
+};
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_INOTIFY_HH
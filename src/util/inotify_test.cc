@@ -0,0 +1,58 @@
+#include "catch.hpp"
+
+#include <unistd.h>
+
+#include <set>
+#include <string>
+
+#include "util/fs.hh"
+#include "util/fs_test_utils.hh"
+#include "util/inotify.hh"
+
+namespace {
+
+std::set<std::string> ReadChangedPaths(util::Inotify* inotify) {
+  std::set<std::string> paths;
+  inotify->ReadPendingEvents(
+      [&](std::string const& directory, std::string const& name) {
+        paths.insert(util::fs::BuildPath({directory, name}));
+      });
+  return paths;
+}
+
+}  // namespace
+
+TEST_CASE("Inotify") {
+  TempDirectory temp;
+  std::string const directory = temp.path();
+  std::string const path = temp / "file";
+
+  util::Inotify inotify;
+  REQUIRE(inotify.IsAlive());
+  REQUIRE(inotify.FileDescriptor() != -1);
+  REQUIRE_FALSE(inotify.Watch("/tmp/bogus_path"));
+  REQUIRE(inotify.Watch(directory));
+  REQUIRE(inotify.IsWatched(directory));
+
+  // nothing happened yet, and reading doesn't block
+  REQUIRE(ReadChangedPaths(&inotify).empty());
+
+  REQUIRE(util::fs::WriteFile(path, "contents"));
+  REQUIRE(ReadChangedPaths(&inotify) == std::set<std::string>{path});
+
+  REQUIRE(util::fs::Unlink(path));
+  REQUIRE(ReadChangedPaths(&inotify) == std::set<std::string>{path});
+
+  inotify.Unwatch(directory);
+  REQUIRE_FALSE(inotify.IsWatched(directory));
+  REQUIRE(util::fs::WriteFile(path, "contents"));
+  REQUIRE(ReadChangedPaths(&inotify).empty());
+  REQUIRE(inotify.Watch(directory));
+  REQUIRE(util::fs::Unlink(path));
+  REQUIRE(ReadChangedPaths(&inotify) == std::set<std::string>{path});
+
+  // removed directories stop being watched
+  rmdir(directory.c_str());
+  REQUIRE(ReadChangedPaths(&inotify).empty());
+  REQUIRE_FALSE(inotify.IsWatched(directory));
+}
@@ -0,0 +1,115 @@
+#ifndef TINT3_UTIL_LRU_CACHE_HH
+#define TINT3_UTIL_LRU_CACHE_HH
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace util {
+
+// Implements a bounded key-value cache with a least recently used eviction
+// policy. Lookups through Get() and insertions through Put() both promote the
+// entry to the most recently used position; once the capacity is exceeded the
+// least recently used entry is dropped.
+//
+// A capacity of zero means the cache is unbounded.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class LruCache {
+ public:
+  using value_type = std::pair<const K, V>;
+  using iterator = typename std::list<value_type>::iterator;
+  using const_iterator = typename std::list<value_type>::const_iterator;
+
+  explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+  LruCache(LruCache const&) = delete;
+  LruCache& operator=(LruCache const&) = delete;
+
+  // Returns a pointer to the value associated with the given key, or nullptr
+  // if no such entry exists. A successful lookup marks the entry as the most
+  // recently used.
+  V* Get(K const& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  // Like Get(), but doesn't alter the eviction order.
+  V const* Peek(K const& key) const {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    return &it->second->second;
+  }
+
+  bool Has(K const& key) const { return index_.count(key) != 0; }
+
+  // Inserts a new entry, or replaces the value of an existing one, and marks
+  // it as the most recently used. Evicts the least recently used entries if
+  // the capacity is exceeded.
+  V& Put(K const& key, V value) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+
+    entries_.emplace_front(key, std::move(value));
+    index_.insert(std::make_pair(key, entries_.begin()));
+    Shrink();
+    return entries_.front().second;
+  }
+
+  bool Erase(K const& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    entries_.erase(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  void Clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  size_t capacity() const { return capacity_; }
+
+  void set_capacity(size_t capacity) {
+    capacity_ = capacity;
+    Shrink();
+  }
+
+  // Iteration goes from the most to the least recently used entry.
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+ private:
+  size_t capacity_;
+  std::list<value_type> entries_;
+  std::unordered_map<K, iterator, Hash> index_;
+
+  void Shrink() {
+    while (capacity_ != 0 && entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+};
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_LRU_CACHE_HH
@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "util/lru_cache.hh"
+
+TEST_CASE("LruCache::Put", "Insertion and lookup both work") {
+  util::LruCache<int, std::string> cache{2};
+  REQUIRE(cache.empty());
+
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  REQUIRE(cache.size() == 2);
+  REQUIRE(cache.Has(1));
+  REQUIRE(cache.Has(2));
+  REQUIRE(*cache.Get(1) == "one");
+  REQUIRE(*cache.Get(2) == "two");
+  REQUIRE(cache.Get(3) == nullptr);
+
+  // Replacing an existing value doesn't grow the cache.
+  cache.Put(2, "deux");
+  REQUIRE(cache.size() == 2);
+  REQUIRE(*cache.Get(2) == "deux");
+}
+
+TEST_CASE("LruCache::Eviction", "The least recently used entry goes first") {
+  util::LruCache<int, std::string> cache{2};
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+
+  SECTION("without lookups, the oldest insertion is evicted") {
+    cache.Put(3, "three");
+    REQUIRE(cache.size() == 2);
+    REQUIRE_FALSE(cache.Has(1));
+    REQUIRE(cache.Has(2));
+    REQUIRE(cache.Has(3));
+  }
+
+  SECTION("Get() promotes the entry") {
+    REQUIRE(cache.Get(1) != nullptr);
+    cache.Put(3, "three");
+    REQUIRE(cache.Has(1));
+    REQUIRE_FALSE(cache.Has(2));
+    REQUIRE(cache.Has(3));
+  }
+
+  SECTION("Peek() doesn't promote the entry") {
+    REQUIRE(cache.Peek(1) != nullptr);
+    cache.Put(3, "three");
+    REQUIRE_FALSE(cache.Has(1));
+    REQUIRE(cache.Has(2));
+  }
+
+  SECTION("shrinking the capacity evicts entries") {
+    cache.set_capacity(1);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.Has(2));
+  }
+}
+
+TEST_CASE("LruCache::Unbounded", "A zero capacity never evicts") {
+  util::LruCache<int, int> cache{0};
+  for (int i = 0; i < 100; ++i) {
+    cache.Put(i, i * i);
+  }
+  REQUIRE(cache.size() == 100);
+  REQUIRE(*cache.Get(9) == 81);
+}
+
+TEST_CASE("LruCache::Erase", "Removal works as expected") {
+  util::LruCache<int, std::string> cache{4};
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+
+  REQUIRE(cache.Erase(1));
+  REQUIRE_FALSE(cache.Erase(1));
+  REQUIRE_FALSE(cache.Has(1));
+  REQUIRE(cache.size() == 1);
+
+  cache.Clear();
+  REQUIRE(cache.empty());
+}
+
+TEST_CASE("LruCache::iterator", "Iteration goes from most to least recent") {
+  util::LruCache<int, int> cache{0};
+  cache.Put(1, 1);
+  cache.Put(2, 2);
+  cache.Put(3, 3);
+  cache.Get(1);
+
+  std::vector<int> keys;
+  for (auto const& entry : cache) {
+    keys.push_back(entry.first);
+  }
+  REQUIRE(keys == (std::vector<int>{1, 3, 2}));
+}
@@ -0,0 +1,78 @@
+#include "util/net_wm_icon.hh"
+
+namespace util {
+
+std::vector<IconHeader> ParseIconHeaders(IconHeaderReader const& read_header,
+                                         size_t length) {
+  static constexpr size_t kHeaderLength = 2;
+
+  std::vector<IconHeader> headers;
+  size_t offset = 0;
+  while (offset + kHeaderLength <= length) {
+    unsigned long width = 0;
+    unsigned long height = 0;
+    if (!read_header(offset, &width, &height)) {
+      break;
+    }
+    offset += kHeaderLength;
+
+    // the dimensions are checked separately so that their product can't
+    // overflow
+    size_t available = length - offset;
+    if (width == 0 || height == 0 || width > available ||
+        height > available / width) {
+      break;
+    }
+
+    IconHeader header;
+    header.width = static_cast<int>(width);
+    header.height = static_cast<int>(height);
+    header.offset = offset;
+    headers.push_back(header);
+    offset += width * height;
+  }
+
+  return headers;
+}
+
+std::vector<IconHeader> ParseIconHeaders(unsigned long const* data,
+                                         size_t length) {
+  if (data == nullptr) {
+    return {};
+  }
+  return ParseIconHeaders(
+      [data](size_t offset, unsigned long* width, unsigned long* height) {
+        *width = data[offset];
+        *height = data[offset + 1];
+        return true;
+      },
+      length);
+}
+
+IconHeader const* GetBestIcon(std::vector<IconHeader> const& headers,
+                              int best_icon_size) {
+  IconHeader const* best = nullptr;
+
+  for (auto const& header : headers) {
+    // Try to find exact size
+    if (header.width == best_icon_size) {
+      return &header;
+    }
+
+    if (best == nullptr) {
+      best = &header;
+    } else if (best->width < best_icon_size) {
+      // Nothing large enough yet: take the biggest
+      if (header.width > best->width) {
+        best = &header;
+      }
+    } else if (header.width > best_icon_size && header.width < best->width) {
+      // Take the smallest one we can scale down
+      best = &header;
+    }
+  }
+
+  return best;
+}
+
+}  // namespace util
@@ -0,0 +1,42 @@
+#ifndef TINT3_UTIL_NET_WM_ICON_HH
+#define TINT3_UTIL_NET_WM_ICON_HH
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace util {
+
+// Describes one of the icons advertised through _NET_WM_ICON.
+struct IconHeader {
+  int width;
+  int height;
+  // position of the pixel data in the property, in 32 bit units
+  size_t offset;
+};
+
+// Reads the width and height stored at the given offset of a _NET_WM_ICON
+// property. Returns false if they couldn't be read.
+using IconHeaderReader = std::function<bool(size_t offset, unsigned long* width,
+                                            unsigned long* height)>;
+
+// Walks a _NET_WM_ICON property of the given length, in 32 bit units, and
+// lists the icons it contains, reading only their headers. Parsing stops at
+// the first malformed or truncated icon.
+std::vector<IconHeader> ParseIconHeaders(IconHeaderReader const& read_header,
+                                         size_t length);
+
+// Same as above, for a property held in memory as returned by Xlib (one long
+// per 32 bit item).
+std::vector<IconHeader> ParseIconHeaders(unsigned long const* data,
+                                         size_t length);
+
+// Picks the icon that's best suited to be displayed at the given size: either
+// an exact match, or the smallest icon that can be scaled down, or the largest
+// one available. Returns nullptr if the list is empty.
+IconHeader const* GetBestIcon(std::vector<IconHeader> const& headers,
+                              int best_icon_size);
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_NET_WM_ICON_HH
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include "util/net_wm_icon.hh"
+
+namespace {
+
+// Appends a width x height icon filled with the given color.
+void AppendIcon(std::vector<unsigned long>* data, unsigned long width,
+                unsigned long height, unsigned long color) {
+  data->push_back(width);
+  data->push_back(height);
+  data->insert(data->end(), width * height, color);
+}
+
+std::vector<util::IconHeader> Headers(std::vector<int> const& sizes) {
+  std::vector<util::IconHeader> headers;
+  for (int size : sizes) {
+    headers.push_back(util::IconHeader{size, size, 0});
+  }
+  return headers;
+}
+
+}  // namespace
+
+TEST_CASE("ParseIconHeaders") {
+  std::vector<unsigned long> data;
+  AppendIcon(&data, 2, 2, 0xff0000ff);
+  AppendIcon(&data, 3, 1, 0xff00ff00);
+
+  SECTION("icons are listed with the position of their pixels") {
+    auto headers = util::ParseIconHeaders(data.data(), data.size());
+    REQUIRE(headers.size() == 2);
+    REQUIRE(headers[0].width == 2);
+    REQUIRE(headers[0].height == 2);
+    REQUIRE(headers[0].offset == 2);
+    REQUIRE(headers[1].width == 3);
+    REQUIRE(headers[1].height == 1);
+    REQUIRE(headers[1].offset == 8);
+    REQUIRE(data[headers[1].offset] == 0xff00ff00);
+  }
+
+  SECTION("truncated icons are dropped") {
+    auto headers = util::ParseIconHeaders(data.data(), data.size() - 1);
+    REQUIRE(headers.size() == 1);
+    REQUIRE(headers[0].width == 2);
+  }
+
+  SECTION("parsing stops at malformed icons") {
+    data.push_back(0);
+    data.push_back(4);
+    AppendIcon(&data, 1, 1, 0xffffffff);
+    REQUIRE(util::ParseIconHeaders(data.data(), data.size()).size() == 2);
+
+    std::vector<unsigned long> huge{~0UL, ~0UL, 0};
+    REQUIRE(util::ParseIconHeaders(huge.data(), huge.size()).empty());
+  }
+
+  SECTION("missing properties have no icons") {
+    REQUIRE(util::ParseIconHeaders(nullptr, 0).empty());
+  }
+
+  SECTION("only the headers are read") {
+    std::vector<size_t> offsets;
+    auto headers = util::ParseIconHeaders(
+        [&](size_t offset, unsigned long* width, unsigned long* height) {
+          offsets.push_back(offset);
+          *width = data[offset];
+          *height = data[offset + 1];
+          return true;
+        },
+        data.size());
+    REQUIRE(headers.size() == 2);
+    REQUIRE(offsets == std::vector<size_t>{0, 6});
+  }
+
+  SECTION("parsing stops when a header can't be read") {
+    auto headers = util::ParseIconHeaders(
+        [&](size_t offset, unsigned long* width, unsigned long* height) {
+          *width = data[offset];
+          *height = data[offset + 1];
+          return offset == 0;
+        },
+        data.size());
+    REQUIRE(headers.size() == 1);
+  }
+}
+
+TEST_CASE("GetBestIcon") {
+  REQUIRE(util::GetBestIcon({}, 24) == nullptr);
+
+  SECTION("an exact match wins") {
+    auto headers = Headers({16, 48, 24, 32});
+    REQUIRE(util::GetBestIcon(headers, 24) == &headers[2]);
+  }
+
+  SECTION("otherwise, the smallest larger icon is scaled down") {
+    auto headers = Headers({16, 128, 48, 32, 256});
+    REQUIRE(util::GetBestIcon(headers, 24) == &headers[3]);
+  }
+
+  SECTION("otherwise, the largest smaller icon is scaled up") {
+    auto headers = Headers({8, 22, 16});
+    REQUIRE(util::GetBestIcon(headers, 24) == &headers[1]);
+  }
+}
@@ -31,11 +31,13 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 
 #include "panel.hh"
 #include "server.hh"
 #include "taskbar/taskbar.hh"
 #include "util/common.hh"
+#include "util/net_wm_icon.hh"
 #include "util/window.hh"
 
 namespace util {
@@ -49,6 +51,18 @@ int GetDesktop(Window win) {
   return GetProperty32<int>(win, server.atom("_NET_WM_DESKTOP"), XA_CARDINAL);
 }
 
+std::string GetClass(Window win) {
+  XClassHint class_hint;
+  if (!XGetClassHint(server.dsp, win, &class_hint)) {
+    return std::string{};
+  }
+
+  std::string res_class{class_hint.res_class ? class_hint.res_class : ""};
+  XFree(class_hint.res_name);
+  XFree(class_hint.res_class);
+  return res_class;
+}
+
 void SetDesktop(Window win, int desktop) {
   SendEvent32(win, server.atom("_NET_WM_DESKTOP"), desktop, 2, 0);
 }
@@ -104,8 +118,8 @@ bool IsHidden(Window win) {
     }
   }
 
-  for (Panel& p : panels) {
-    if (p.main_win_ == win) {
+  for (auto& p : panels) {
+    if (p->main_win_ == win) {
       return 1;
     }
   }
@@ -206,74 +220,67 @@ void SetDesktop(int desktop) {
               desktop, 0, 0);
 }
 
-int GetIconCount(unsigned long* data, int num) {
-  int count = 0;
-  int pos = 0;
-
-  while (pos + 2 < num) {
-    int w = data[pos++];
-    int h = data[pos++];
-    pos += w * h;
-
-    if (pos > num || w <= 0 || h <= 0) {
-      break;
-    }
-
-    count++;
+NetWmIcon GetNetWmIcon(Window win, int best_icon_size) {
+  // Most windows only advertise a few small icons, which are read in one go.
+  // Larger properties are walked header by header, and only the selected
+  // frame is transferred.
+  static constexpr long kInitialLength = 4096;
+
+  NetWmIcon icon;
+  Atom atom = server.atom("_NET_WM_ICON");
+  int num_results = 0;
+  unsigned long bytes_after = 0;
+  auto head = server.GetPropertyRange<unsigned long>(
+      win, atom, XA_CARDINAL, 0, kInitialLength, &num_results, &bytes_after);
+  if (head == nullptr || num_results <= 0) {
+    return icon;
   }
 
-  return count;
-}
-
-unsigned long* GetBestIcon(unsigned long* data, int icon_count, int num,
-                           int* iw, int* ih, int best_icon_size) {
-  int width[icon_count];
-  int height[icon_count];
-  unsigned long* icon_data[icon_count];
-
-  /* List up icons */
-  int pos = 0;
-
-  for (int i = icon_count - 1; i >= 0; --i) {
-    int w = data[pos++];
-    int h = data[pos++];
-
-    if (pos + w * h > num) {
-      break;
-    }
-
-    width[i] = w;
-    height[i] = h;
-    icon_data[i] = &data[pos];
-
-    pos += w * h;
-  }
-
-  /* Try to find exact size */
-  int icon_num = -1;
+  // bytes_after counts the 32 bit items as 4 bytes, whatever the size of long
+  size_t head_length = num_results;
+  size_t total_length = head_length + bytes_after / 4;
+  auto headers = util::ParseIconHeaders(
+      [&](size_t offset, unsigned long* width, unsigned long* height) {
+        if (offset + 2 <= head_length) {
+          *width = head.get()[offset];
+          *height = head.get()[offset + 1];
+          return true;
+        }
+
+        int header_results = 0;
+        auto header = server.GetPropertyRange<unsigned long>(
+            win, atom, XA_CARDINAL, offset, 2, &header_results, nullptr);
+        if (header == nullptr || header_results != 2) {
+          return false;
+        }
+        *width = header.get()[0];
+        *height = header.get()[1];
+        return true;
+      },
+      total_length);
 
-  for (int i = 0; i < icon_count; i++) {
-    if (width[i] == best_icon_size) {
-      icon_num = i;
-      break;
-    }
+  util::IconHeader const* best = util::GetBestIcon(headers, best_icon_size);
+  if (best == nullptr) {
+    return icon;
   }
 
-  /* Take the biggest or whatever */
-  if (icon_num < 0) {
-    int highest = 0;
-
-    for (int i = 0; i < icon_count; i++) {
-      if (width[i] > highest) {
-        icon_num = i;
-        highest = width[i];
-      }
+  size_t length = static_cast<size_t>(best->width) * best->height;
+  if (best->offset + length <= head_length) {
+    icon.pixels = head.get() + best->offset;
+    icon.reply = std::move(head);
+  } else {
+    int frame_results = 0;
+    icon.reply = server.GetPropertyRange<unsigned long>(
+        win, atom, XA_CARDINAL, best->offset, length, &frame_results, nullptr);
+    if (icon.reply == nullptr ||
+        static_cast<size_t>(frame_results) != length) {
+      return NetWmIcon{};
     }
+    icon.pixels = icon.reply.get();
   }
-
-  (*iw) = width[icon_num];
-  (*ih) = height[icon_num];
-  return icon_data[icon_num];
+  icon.width = best->width;
+  icon.height = best->height;
+  return icon;
 }
 
 void GetTextSize(util::pango::FontDescriptionPtr const& font,
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "util/pango.hh"
+#include "util/x11.hh"
 
 namespace util {
 namespace window {
@@ -19,6 +20,7 @@ bool IsSkipTaskbar(Window win);
 void MaximizeRestore(Window win);
 void ToggleShade(Window win);
 int GetDesktop(Window win);
+std::string GetClass(Window win);
 void SetDesktop(Window win, int desktop);
 unsigned int GetMonitor(Window win);
 Window GetActive();
@@ -28,9 +30,20 @@ Window GetActive();
 
 void SetDesktop(int desktop);
 
-int GetIconCount(unsigned long* data, int num);
-unsigned long* GetBestIcon(unsigned long* data, int icon_count, int num,
-                           int* iw, int* ih, int best_icon_size);
+// One of the icons advertised through _NET_WM_ICON, along with the reply its
+// pixels live in.
+struct NetWmIcon {
+  util::x11::ClientData<unsigned long> reply{nullptr};
+  // one long per pixel, of which only the lower 32 bits are significant
+  unsigned long const* pixels = nullptr;
+  unsigned int width = 0;
+  unsigned int height = 0;
+};
+
+// Reads the icon of the given window that's best suited to be displayed at
+// the given size (see GetBestIcon()), transferring as little of the property
+// as possible. Returns an icon without pixels if there's none.
+NetWmIcon GetNetWmIcon(Window win, int best_icon_size);
 
 enum class MarkupTag {
   kNoMarkup,
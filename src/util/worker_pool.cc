@@ -0,0 +1,90 @@
+#include "util/worker_pool.hh"
+
+namespace util {
+
+WorkerPool::WorkerPool(size_t num_threads, Notifier notify)
+    : notify_(std::move(notify)), pending_(0), stopping_(false) {
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&WorkerPool::Run, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+    queue_.clear();
+  }
+  work_available_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::Post(Job work, Job done) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    queue_.emplace_back(std::move(work), std::move(done));
+    ++pending_;
+  }
+  work_available_.notify_one();
+}
+
+size_t WorkerPool::ProcessCompleted() {
+  std::deque<Job> completed;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    completed.swap(completed_);
+    pending_ -= completed.size();
+  }
+  for (auto& done : completed) {
+    if (done) {
+      done();
+    }
+  }
+  return completed.size();
+}
+
+size_t WorkerPool::pending() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return pending_;
+}
+
+size_t WorkerPool::num_threads() const { return threads_.size(); }
+
+void WorkerPool::Run() {
+  while (true) {
+    std::pair<Job, Job> job;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      work_available_.wait(lock,
+                           [this] { return stopping_ || !queue_.empty(); });
+      if (stopping_) {
+        return;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    if (job.first) {
+      job.first();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (stopping_) {
+        return;
+      }
+      completed_.push_back(std::move(job.second));
+    }
+
+    if (notify_) {
+      notify_();
+    }
+  }
+}
+
+}  // namespace util
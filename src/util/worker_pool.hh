@@ -0,0 +1,66 @@
+#ifndef TINT3_UTIL_WORKER_POOL_HH
+#define TINT3_UTIL_WORKER_POOL_HH
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Runs CPU-bound jobs on a small set of background threads.
+//
+// Every job comes with a completion callback, which isn't run by the worker
+// thread: it's queued up instead, and the owner is notified through the
+// callback given at construction time (which is invoked from the worker
+// thread, so it must only do thread-safe things, such as waking up the event
+// loop). The owner is then expected to call ProcessCompleted() from its own
+// thread, which is where the completion callbacks are run.
+//
+// Jobs must not touch any shared state without synchronization: this rules
+// out X11 and Imlib2 calls, as both rely on global, unprotected state.
+class WorkerPool {
+ public:
+  using Job = std::function<void()>;
+  using Notifier = std::function<void()>;
+
+  WorkerPool(size_t num_threads, Notifier notify);
+  ~WorkerPool();
+
+  WorkerPool(WorkerPool const&) = delete;
+  WorkerPool& operator=(WorkerPool const&) = delete;
+
+  // Schedules work() to be run on one of the worker threads. Once it returns,
+  // done() is queued up to be run by ProcessCompleted().
+  void Post(Job work, Job done);
+
+  // Runs the completion callbacks of all the jobs finished so far, in the
+  // order they finished. Returns the number of callbacks run.
+  size_t ProcessCompleted();
+
+  // Returns the number of jobs that haven't yet been completed through
+  // ProcessCompleted().
+  size_t pending() const;
+
+  size_t num_threads() const;
+
+ private:
+  void Run();
+
+  Notifier notify_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::deque<std::pair<Job, Job>> queue_;
+  std::deque<Job> completed_;
+  size_t pending_;
+  bool stopping_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace util
+
+#endif  // TINT3_UTIL_WORKER_POOL_HH
@@ -0,0 +1,141 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "util/argb.hh"
+#include "util/worker_pool.hh"
+
+namespace {
+
+util::ArgbImage MakeTestImage(unsigned int size, unsigned int seed) {
+  util::ArgbImage image{size, size};
+  uint32_t state = seed;
+  for (auto& pixel : image.pixels) {
+    state = state * 1664525 + 1013904223;
+    pixel = state;
+  }
+  return image;
+}
+
+// Keeps processing completions until the pool is idle, or until a generous
+// deadline expires to avoid hanging the test.
+bool WaitForPool(util::WorkerPool* pool) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (pool->pending() != 0) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    pool->ProcessCompleted();
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+// Sets the given flag when destroyed, along with the job holding it.
+class SetOnDestruction {
+ public:
+  explicit SetOnDestruction(std::atomic<bool>* flag) : flag_(flag) {}
+  ~SetOnDestruction() { *flag_ = true; }
+
+ private:
+  std::atomic<bool>* flag_;
+};
+
+}  // namespace
+
+TEST_CASE("WorkerPool::Post", "Jobs run and complete on the owner thread") {
+  std::atomic<int> notifications{0};
+  util::WorkerPool pool{2, [&] { ++notifications; }};
+  REQUIRE(pool.num_threads() == 2);
+
+  std::thread::id owner = std::this_thread::get_id();
+  std::atomic<int> ran{0};
+  int completed = 0;
+  bool completed_on_owner = true;
+
+  for (int i = 0; i < 16; ++i) {
+    pool.Post([&] { ++ran; },
+              [&] {
+                ++completed;
+                completed_on_owner &= (std::this_thread::get_id() == owner);
+              });
+  }
+
+  REQUIRE(WaitForPool(&pool));
+  REQUIRE(ran == 16);
+  REQUIRE(completed == 16);
+  REQUIRE(completed_on_owner);
+  REQUIRE(notifications == 16);
+  REQUIRE(pool.ProcessCompleted() == 0);
+}
+
+TEST_CASE("WorkerPool::Deterministic",
+          "Scaling in the pool gives the same results as inline scaling") {
+  const unsigned int kNumImages = 32;
+
+  std::vector<util::ArgbImage> sources;
+  std::vector<util::ArgbImage> expected;
+  for (unsigned int i = 0; i < kNumImages; ++i) {
+    sources.push_back(MakeTestImage(16 + i * 3, i));
+    expected.push_back(util::ScaleArgbImage(sources.back(), 24, 24));
+  }
+
+  for (size_t num_threads : {1, 4}) {
+    util::WorkerPool pool{num_threads, nullptr};
+    std::vector<util::ArgbImage> results(kNumImages);
+
+    for (unsigned int i = 0; i < kNumImages; ++i) {
+      auto result = std::make_shared<util::ArgbImage>();
+      util::ArgbImage const* source = &sources[i];
+      pool.Post(
+          [result, source] {
+            *result = util::ScaleArgbImage(*source, 24, 24);
+          },
+          [result, &results, i] { results[i] = *result; });
+    }
+
+    REQUIRE(WaitForPool(&pool));
+    for (unsigned int i = 0; i < kNumImages; ++i) {
+      REQUIRE(results[i] == expected[i]);
+    }
+  }
+}
+
+TEST_CASE("WorkerPool::Destruction", "Queued jobs are dropped") {
+  std::atomic<bool> release{false};
+  std::atomic<int> jobs_run{0};
+  int completed = 0;
+  auto done_token = std::make_shared<int>(0);
+  {
+    util::WorkerPool pool{1, nullptr};
+    pool.Post(
+        [&] {
+          ++jobs_run;
+          // the deadline only matters if the pool doesn't drop the job
+          auto deadline =
+              std::chrono::steady_clock::now() + std::chrono::seconds(5);
+          while (!release && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+          }
+        },
+        [&, done_token] { ++completed; });
+    // The second job can't start before the first one returns, which only
+    // happens once the pool drops the second job on destruction.
+    auto releaser = std::make_shared<SetOnDestruction>(&release);
+    pool.Post([&, releaser] { ++jobs_run; },
+              [&, done_token] { ++completed; });
+    releaser.reset();
+
+    while (jobs_run == 0) {
+      std::this_thread::yield();
+    }
+  }
+  REQUIRE(jobs_run == 1);
+  REQUIRE(completed == 0);
+  // the completion callbacks were released without being run
+  REQUIRE(done_token.use_count() == 1);
+}
@@ -55,20 +55,21 @@ Colormap Colormap::Create(Display* display, Window window, Visual* visual,
   return {display, XCreateColormap(display, window, visual, alloc)};
 }
 
-Pixmap::Pixmap(Display* display, ::Pixmap pixmap)
-    : display_{display}, pixmap_{pixmap} {}
-
-Pixmap::~Pixmap() {
-  if (pixmap_ != None) XFreePixmap(display_, pixmap_);
+Pixmap::Pixmap(Display* display, ::Pixmap pixmap) {
+  if (pixmap != None) {
+    pixmap_.reset(new ::Pixmap{pixmap}, [display](::Pixmap* p) {
+      XFreePixmap(display, *p);
+      delete p;
+    });
+  }
 }
 
 Pixmap& Pixmap::operator=(Pixmap other) {
-  std::swap(display_, other.display_);
   std::swap(pixmap_, other.pixmap_);
   return *this;
 }
 
-Pixmap::operator ::Pixmap() const { return pixmap_; }
+Pixmap::operator ::Pixmap() const { return pixmap_ ? *pixmap_ : None; }
 
 Pixmap Pixmap::Create(Display* display, Window window, unsigned int width,
                       unsigned int height, unsigned int depth) {
@@ -95,24 +96,24 @@ bool EventLoop::RunLoop() {
     if (panel_refresh) {
       panel_refresh = false;
 
-      for (Panel& panel : panels) {
-        if (panel.hidden()) {
-          XCopyArea(server_->dsp, panel.hidden_pixmap_, panel.main_win_,
-                    server_->gc, 0, 0, panel.hidden_width_,
-                    panel.hidden_height_, 0, 0);
-          XSetWindowBackgroundPixmap(server_->dsp, panel.main_win_,
-                                     panel.hidden_pixmap_);
+      for (auto& panel : panels) {
+        if (panel->hidden()) {
+          XCopyArea(server_->dsp, panel->hidden_pixmap_, panel->main_win_,
+                    server_->gc, 0, 0, panel->hidden_width_,
+                    panel->hidden_height_, 0, 0);
+          XSetWindowBackgroundPixmap(server_->dsp, panel->main_win_,
+                                     panel->hidden_pixmap_);
         } else {
-          if (panel.temp_pmap) {
-            XFreePixmap(server_->dsp, panel.temp_pmap);
+          if (panel->temp_pmap) {
+            XFreePixmap(server_->dsp, panel->temp_pmap);
           }
 
-          panel.temp_pmap =
-              XCreatePixmap(server_->dsp, server_->root_window(), panel.width_,
-                            panel.height_, server_->depth);
-          panel.Render();
-          XCopyArea(server_->dsp, panel.temp_pmap, panel.main_win_, server_->gc,
-                    0, 0, panel.width_, panel.height_, 0, 0);
+          panel->temp_pmap =
+              XCreatePixmap(server_->dsp, server_->root_window(), panel->width_,
+                            panel->height_, server_->depth);
+          panel->Render();
+          XCopyArea(server_->dsp, panel->temp_pmap, panel->main_win_,
+                    server_->gc, 0, 0, panel->width_, panel->height_, 0, 0);
         }
       }
 
@@ -136,6 +137,10 @@ bool EventLoop::RunLoop() {
     FD_SET(self_pipe_.ReadEnd(), &fdset);
 
     int max_fd_ = std::max(x11_file_descriptor_, self_pipe_.ReadEnd());
+    for (auto const& entry : file_descriptor_handlers_) {
+      FD_SET(entry.first, &fdset);
+      max_fd_ = std::max(max_fd_, entry.first);
+    }
 
     auto next_interval = timer_.GetNextInterval();
     struct timeval tv;
@@ -155,6 +160,16 @@ bool EventLoop::RunLoop() {
       // Remove bytes written by WakeUp()
       if (FD_ISSET(self_pipe_.ReadEnd(), &fdset)) {
         self_pipe_.ReadPendingBytes();
+
+        for (auto const& handler : wake_up_handlers_) {
+          handler();
+        }
+      }
+
+      for (auto const& entry : file_descriptor_handlers_) {
+        if (FD_ISSET(entry.first, &fdset)) {
+          entry.second();
+        }
       }
 
       if (pending_children) {
@@ -248,6 +263,18 @@ EventLoop& EventLoop::RegisterHandler(std::initializer_list<int> event_list,
   return (*this);
 }
 
+EventLoop& EventLoop::RegisterWakeUpHandler(
+    EventLoop::WakeUpHandler handler) {
+  wake_up_handlers_.push_back(std::move(handler));
+  return (*this);
+}
+
+EventLoop& EventLoop::RegisterFileDescriptorHandler(
+    int fd, EventLoop::FileDescriptorHandler handler) {
+  file_descriptor_handlers_[fd] = std::move(handler);
+  return (*this);
+}
+
 void EventLoop::ReapChildPIDs() const {
   pid_t pid;
   while ((pid = waitpid(-1, nullptr, WNOHANG)) > 0) {
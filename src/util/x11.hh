@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "util/pipe.hh"
 #include "util/timer.hh"
@@ -62,13 +63,14 @@ class Colormap {
   ::Colormap colormap_ = None;
 };
 
+// Copies share the same server-side pixmap, which is freed once the last of
+// them is destroyed.
 class Pixmap {
  public:
   Pixmap() = default;
   Pixmap(Display* display, ::Pixmap pixmap);
   Pixmap(Pixmap const& other) = default;
   Pixmap(Pixmap&& other) = default;
-  ~Pixmap();
 
   Pixmap& operator=(Pixmap other);
   operator ::Pixmap() const;
@@ -77,13 +79,14 @@ class Pixmap {
                        unsigned int height, unsigned int depth);
 
  private:
-  Display* display_ = nullptr;
-  ::Pixmap pixmap_ = None;
+  std::shared_ptr<::Pixmap> pixmap_;
 };
 
 class EventLoop {
  public:
   using EventHandler = std::function<void(XEvent&)>;
+  using WakeUpHandler = std::function<void()>;
+  using FileDescriptorHandler = std::function<void()>;
 
   EventLoop(Server const* const server, Timer& timer);
 
@@ -93,6 +96,14 @@ class EventLoop {
   EventLoop& RegisterHandler(int event, EventHandler handler);
   EventLoop& RegisterHandler(std::initializer_list<int> event_list,
                              EventHandler handler);
+  // Registers a callback to be run every time the loop is woken up through
+  // WakeUp(), which may be called from other threads.
+  EventLoop& RegisterWakeUpHandler(WakeUpHandler handler);
+  // Registers a callback to be run every time the given file descriptor
+  // becomes readable. The callback must consume the pending data without
+  // blocking, since it may also be run when there's none.
+  EventLoop& RegisterFileDescriptorHandler(int fd,
+                                           FileDescriptorHandler handler);
 
  private:
   bool alive_;
@@ -101,6 +112,8 @@ class EventLoop {
   util::SelfPipe self_pipe_;
   Timer& timer_;
   std::unordered_map<int, EventHandler> handler_map_;
+  std::vector<WakeUpHandler> wake_up_handlers_;
+  std::unordered_map<int, FileDescriptorHandler> file_descriptor_handlers_;
 
   void ReapChildPIDs() const;
 };
@@ -31,6 +31,11 @@ namespace util {
 namespace xdg {
 namespace basedir {
 
+util::fs::Path CacheHome() {
+  static auto default_ = GetDefaultDirectory("/.cache");
+  return default_(environment::Get("XDG_CACHE_HOME"));
+}
+
 util::fs::Path ConfigHome() {
   static auto default_ = GetDefaultDirectory("/.config");
   return default_(environment::Get("XDG_CONFIG_HOME"));
@@ -5,6 +5,11 @@
 #include "util/environment.hh"
 #include "util/xdg.hh"
 
+TEST_CASE("CacheHome", "Overrideable through the environment") {
+  auto env = environment::MakeScopedOverride("XDG_CACHE_HOME", "something");
+  REQUIRE(util::xdg::basedir::CacheHome() == "something");
+}
+
 TEST_CASE("ConfigHome", "Overrideable through the environment") {
   auto env = environment::MakeScopedOverride("XDG_CONFIG_HOME", "something");
   REQUIRE(util::xdg::basedir::ConfigHome() == "something");